@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#ifdef TEXTURED
+layout(set = 0, binding = 0) uniform sampler2D batchTexture;
+#endif
+
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) in vec4 fragColor;
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+#ifdef TEXTURED
+    outColor = fragColor * texture(batchTexture, fragUV);
+#else
+    outColor = fragColor;
+#endif
+}
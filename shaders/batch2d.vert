@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform TargetConstants
+{
+    vec2 scale;
+    vec2 offset;
+} target;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec4 fragColor;
+
+void main()
+{
+    // Pixels to normalized device coordinates.
+    gl_Position = vec4(inPosition * target.scale + target.offset, 0.0, 1.0);
+    fragUV = inUV;
+    fragColor = inColor;
+}
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform sampler2D overdraw;
+
+layout(push_constant) uniform HeatmapConstants
+{
+    float maxOverdraw;
+} heatmap;
+
+layout(location = 0) out vec4 outColor;
+
+// One fragment is blue, maxOverdraw fragments or more are red.
+const vec3 RAMP[5] = vec3[](vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0),
+                            vec3(1.0, 0.0, 0.0));
+
+void main()
+{
+    float count = texelFetch(overdraw, ivec2(gl_FragCoord.xy), 0).r;
+    if (count < 0.5)
+    {
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    float x = clamp((count - 1.0) / max(heatmap.maxOverdraw - 1.0, 1.0), 0.0, 1.0) * 4.0;
+    int i = min(int(x), 3);
+    outColor = vec4(mix(RAMP[i], RAMP[i + 1], x - float(i)), 1.0);
+}
@@ -1,6 +1,15 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+#ifdef OVERDRAW
+// Every shaded fragment adds one to the R16F count target through additive blending.
+layout(location = 0) out float outCount;
+
+void main()
+{
+    outCount = 1.0;
+}
+#else
 layout(location = 0) in vec3 fragColor;
 layout(location = 0) out vec4 outColor;
 
@@ -8,3 +17,4 @@ void main()
 {
     outColor = vec4(fragColor, 1.0);
 }
+#endif
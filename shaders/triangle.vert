@@ -1,6 +1,18 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+layout(set = 0, binding = 0) uniform SceneUniforms
+{
+    mat4 transform;
+} scene;
+
+layout(push_constant) uniform DrawConstants
+{
+    vec4 tint;
+    vec2 offset;
+    vec2 scale;
+} draw;
+
 layout(location = 0) out vec3 fragColor;
 
 vec2 positions[3] = vec2[](
@@ -17,6 +29,7 @@ vec3 colors[3] = vec3[](
 
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    vec2 position = positions[gl_VertexIndex] * draw.scale + draw.offset;
+    gl_Position = scene.transform * vec4(position, 0.0, 1.0);
+    fragColor = colors[gl_VertexIndex] * draw.tint.rgb;
 }
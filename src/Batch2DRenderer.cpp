@@ -0,0 +1,220 @@
+#include <cstring>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "ShaderReflection.hpp"
+#include "Batch2DRenderer.hpp"
+#include "reflection/Batch2DVert.hpp"
+#include "reflection/Batch2DSolidFrag.hpp"
+#include "reflection/Batch2DTexturedFrag.hpp"
+
+using std::array;
+
+using namespace VkTri;
+
+namespace VertexShader = VkTri::Reflection::Batch2DVert;
+namespace SolidShader = VkTri::Reflection::Batch2DSolidFrag;
+namespace TexturedShader = VkTri::Reflection::Batch2DTexturedFrag;
+
+static_assert(sizeof(Vertex2D) == VertexShader::VERTEX_STRIDE, "Vertex2D does not match the inputs of batch2d.vert");
+static_assert(sizeof(TargetConstants2D) == VertexShader::PUSH_CONSTANTS.size,
+              "TargetConstants2D does not match the push constant block of batch2d.vert");
+
+Batch2DRenderer::Batch2DRenderer(const vk::PhysicalDevice &physicalDevice, const vk::Device &device,
+                                 MemoryTracker &memoryTracker, DescriptorLayoutCache &layouts,
+                                 const vk::RenderPass &renderPass, uint32_t frameCount)
+{
+    this->device = device;
+    this->geometryRing = std::make_unique<UniformRing>(physicalDevice, device, memoryTracker, BATCH2D_FRAME_SIZE,
+                                                       frameCount, vk::BufferUsageFlagBits::eVertexBuffer |
+                                                                   vk::BufferUsageFlagBits::eIndexBuffer);
+    this->createLayouts(layouts);
+    this->createPipelines(renderPass);
+}
+
+void Batch2DRenderer::createLayouts(DescriptorLayoutCache &layouts)
+{
+    this->textureSetLayout = layouts.get(
+            descriptorSetLayoutBindings({VertexShader::INTERFACE, TexturedShader::INTERFACE}, 0, false));
+
+    // Both layouts share the same push constant range, so the constants survive switching between them.
+    auto solidRanges = pushConstantRanges({VertexShader::INTERFACE, SolidShader::INTERFACE});
+
+    vk::PipelineLayoutCreateInfo solidInfo;
+    solidInfo.pushConstantRangeCount = static_cast<uint32_t>(solidRanges.size());
+    solidInfo.pPushConstantRanges = solidRanges.data();
+
+    this->solidLayout = this->device.createPipelineLayoutUnique(solidInfo);
+
+    auto texturedRanges = pushConstantRanges({VertexShader::INTERFACE, TexturedShader::INTERFACE});
+
+    vk::PipelineLayoutCreateInfo texturedInfo;
+    texturedInfo.setLayoutCount = 1;
+    texturedInfo.pSetLayouts = &this->textureSetLayout;
+    texturedInfo.pushConstantRangeCount = static_cast<uint32_t>(texturedRanges.size());
+    texturedInfo.pPushConstantRanges = texturedRanges.data();
+
+    this->texturedLayout = this->device.createPipelineLayoutUnique(texturedInfo);
+}
+
+void Batch2DRenderer::createPipelines(const vk::RenderPass &renderPass)
+{
+    auto vertShaderModule = loadShaderModule(this->device, BATCH2D_VERTEX_SHADER_PATH);
+    auto solidShaderModule = loadShaderModule(this->device, BATCH2D_SOLID_SHADER_PATH);
+    auto texturedShaderModule = loadShaderModule(this->device, BATCH2D_TEXTURED_SHADER_PATH);
+
+    // Set up vertex input
+    auto vertexAttributes = vertexAttributeDescriptions(VertexShader::INTERFACE, 0);
+    vk::VertexInputBindingDescription vertexBinding(0, VertexShader::VERTEX_STRIDE, vk::VertexInputRate::eVertex);
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    array<vk::DynamicState, 2> dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    vk::PipelineDynamicStateCreateInfo dynamicState;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    // 2D primitives are submitted with either winding.
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+    multisampling.minSampleShading = 1.0f;
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask =
+            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB |
+            vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+    colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+    colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+
+    vk::PipelineColorBlendStateCreateInfo colorBlending;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    vk::PipelineShaderStageCreateInfo vertShaderStageInfo({}, VertexShader::STAGE, vertShaderModule.get(), "main");
+
+    for (size_t i = 0; i < this->pipelines.size(); i++)
+    {
+        auto pipeline2D = static_cast<Pipeline2D>(i);
+        bool textured = pipeline2D == Pipeline2D::Textured;
+
+        colorBlendAttachment.dstColorBlendFactor = pipeline2D == Pipeline2D::Additive
+                                                   ? vk::BlendFactor::eOne : vk::BlendFactor::eOneMinusSrcAlpha;
+
+        vk::PipelineShaderStageCreateInfo fragShaderStageInfo(
+                {}, textured ? TexturedShader::STAGE : SolidShader::STAGE,
+                textured ? texturedShaderModule.get() : solidShaderModule.get(), "main");
+
+        array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
+
+        vk::GraphicsPipelineCreateInfo pipelineInfo;
+        pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+        pipelineInfo.pStages = shaderStages.data();
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = this->layoutFor(pipeline2D);
+        pipelineInfo.renderPass = renderPass;
+        pipelineInfo.subpass = 0;
+
+        this->pipelines[i] = this->device.createGraphicsPipelineUnique(nullptr, pipelineInfo).value;
+    }
+}
+
+vk::PipelineLayout Batch2DRenderer::layoutFor(Pipeline2D pipeline) const
+{
+    return pipeline == Pipeline2D::Textured ? this->texturedLayout.get() : this->solidLayout.get();
+}
+
+vk::DescriptorSetLayout Batch2DRenderer::getTextureSetLayout() const noexcept
+{
+    return this->textureSetLayout;
+}
+
+uint32_t Batch2DRenderer::registerTexture(const vk::DescriptorSet &textureSet)
+{
+    this->textures.push_back(textureSet);
+    return static_cast<uint32_t>(this->textures.size());
+}
+
+void Batch2DRenderer::record(const vk::CommandBuffer &cmd, uint32_t frameIndex, const Batcher2D &batch,
+                             const vk::Extent2D &targetSize)
+{
+    const auto &draws = batch.getDraws();
+    if (draws.empty())
+    {
+        return;
+    }
+
+    const auto &vertices = batch.getVertices();
+    const auto &indices = batch.getIndices();
+
+    this->geometryRing->beginFrame(frameIndex);
+    auto vertexData = this->geometryRing->allocate(vertices.size() * sizeof(Vertex2D));
+    std::memcpy(vertexData.data, vertices.data(), vertices.size() * sizeof(Vertex2D));
+    auto indexData = this->geometryRing->allocate(indices.size() * sizeof(uint32_t));
+    std::memcpy(indexData.data, indices.data(), indices.size() * sizeof(uint32_t));
+    this->geometryRing->flush();
+
+    auto buffer = this->geometryRing->getBuffer();
+    cmd.bindVertexBuffers(0, buffer, vk::DeviceSize(vertexData.offset));
+    cmd.bindIndexBuffer(buffer, indexData.offset, vk::IndexType::eUint32);
+
+    TargetConstants2D constants;
+    constants.scale = glm::vec2(2.0f / static_cast<float>(targetSize.width),
+                                2.0f / static_cast<float>(targetSize.height));
+    constants.offset = glm::vec2(-1.0f, -1.0f);
+
+    auto boundPipeline = Pipeline2D::Count;
+    uint32_t boundTexture = 0u;
+
+    for (const auto &draw : draws)
+    {
+        if (draw.pipeline != boundPipeline)
+        {
+            auto layout = this->layoutFor(draw.pipeline);
+            cmd.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                             this->pipelines[static_cast<size_t>(draw.pipeline)].get());
+            cmd.pushConstants(layout, VertexShader::STAGE, 0, sizeof(TargetConstants2D), &constants);
+            boundPipeline = draw.pipeline;
+            boundTexture = 0u;
+        }
+
+        if (draw.pipeline == Pipeline2D::Textured && draw.texture != boundTexture)
+        {
+            if (draw.texture == 0u || draw.texture > this->textures.size())
+            {
+                throw std::runtime_error(fmt::format("Unknown 2D texture key {:d}", draw.texture));
+            }
+            cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->texturedLayout.get(), 0,
+                                   this->textures[draw.texture - 1u], nullptr);
+            boundTexture = draw.texture;
+        }
+
+        cmd.drawIndexed(draw.indexCount, 1, draw.firstIndex, 0, 0);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "Batcher2D.hpp"
+#include "DescriptorAllocator.hpp"
+#include "MemoryTracker.hpp"
+#include "UniformRing.hpp"
+
+using std::vector;
+using std::unique_ptr;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    const fs::path BATCH2D_VERTEX_SHADER_PATH("../shaders/batch2d_vert.spv");
+    const fs::path BATCH2D_SOLID_SHADER_PATH("../shaders/batch2d_solid_frag.spv");
+    const fs::path BATCH2D_TEXTURED_SHADER_PATH("../shaders/batch2d_textured_frag.spv");
+
+    static constexpr vk::DeviceSize BATCH2D_FRAME_SIZE = 4u * 1024u * 1024u; /**< Geometry bytes per frame */
+
+    /**
+     * \brief Push constants of batch2d.vert, mapping pixel coordinates to normalized device coordinates.
+     */
+    struct TargetConstants2D
+    {
+        glm::vec2 scale;
+        glm::vec2 offset;
+    };
+
+    /**
+     * \brief Streams the output of a Batcher2D to the GPU and draws it inside an active render pass.
+     *
+     * \details
+     * Each frame's vertices and indices are copied into one persistently mapped ring, so the whole batch costs two
+     * memcpys and one vertex and index buffer bind. Pipelines and texture sets are only rebound when the sorted
+     * draw list changes them.
+     *
+     * Texture keys are handed out by registerTexture(). Key 0 means untextured.
+     */
+    class Batch2DRenderer
+    {
+    private:
+        vk::Device device;
+        unique_ptr<UniformRing> geometryRing;
+
+        vk::DescriptorSetLayout textureSetLayout; /**< Owned by the layout cache */
+        vk::UniquePipelineLayout solidLayout;
+        vk::UniquePipelineLayout texturedLayout;
+        std::array<vk::UniquePipeline, static_cast<size_t>(Pipeline2D::Count)> pipelines;
+
+        vector<vk::DescriptorSet> textures; /**< Texture key - 1 to its combined image sampler set */
+
+        void createLayouts(DescriptorLayoutCache &layouts);
+
+        void createPipelines(const vk::RenderPass &renderPass);
+
+        [[nodiscard]] vk::PipelineLayout layoutFor(Pipeline2D pipeline) const;
+
+    public:
+        /**
+         * \param renderPass render pass whose subpass 0 the batches are drawn in.
+         * \param layouts cache the texture set layout is taken from, which must outlive the renderer.
+         * \param frameCount number of frames in flight.
+         */
+        Batch2DRenderer(const vk::PhysicalDevice &physicalDevice, const vk::Device &device,
+                        MemoryTracker &memoryTracker, DescriptorLayoutCache &layouts,
+                        const vk::RenderPass &renderPass, uint32_t frameCount);
+
+        /**
+         * \brief Layout texture sets must be allocated with: a combined image sampler at binding 0.
+         */
+        [[nodiscard]] vk::DescriptorSetLayout getTextureSetLayout() const noexcept;
+
+        /**
+         * \brief Makes a texture set available to Pipeline2D::Textured primitives.
+         * \return the texture key to add primitives with.
+         */
+        uint32_t registerTexture(const vk::DescriptorSet &textureSet);
+
+        /**
+         * \brief Uploads a finished batch and records its draws.
+         * \param frameIndex frame in flight slot, whose previous use must have completed on the GPU.
+         * \param targetSize size in pixels the batch's coordinates are relative to.
+         */
+        void record(const vk::CommandBuffer &cmd, uint32_t frameIndex, const Batcher2D &batch,
+                    const vk::Extent2D &targetSize);
+    };
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Batcher2D.hpp"
+
+using namespace VkTri;
+
+void Batcher2D::begin()
+{
+    this->primitives.clear();
+    this->submittedVertices.clear();
+    this->vertices.clear();
+    this->indices.clear();
+    this->draws.clear();
+    this->recording = true;
+}
+
+void Batcher2D::add(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D *source, uint32_t count)
+{
+    if (!this->recording)
+    {
+        throw std::runtime_error("Primitives must be added between Batcher2D::begin() and end().");
+    }
+
+    Primitive primitive;
+    primitive.key = (static_cast<uint64_t>(layer) << 48u) | (static_cast<uint64_t>(pipeline) << 32u) | texture;
+    primitive.sequence = static_cast<uint32_t>(this->primitives.size());
+    primitive.firstVertex = static_cast<uint32_t>(this->submittedVertices.size());
+    primitive.vertexCount = count;
+
+    this->primitives.push_back(primitive);
+    this->submittedVertices.insert(this->submittedVertices.end(), source, source + count);
+}
+
+void Batcher2D::addTriangle(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D &a,
+                            const Vertex2D &b, const Vertex2D &c)
+{
+    const Vertex2D corners[3] = {a, b, c};
+    this->add(layer, pipeline, texture, corners, 3u);
+}
+
+void Batcher2D::addQuad(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D &a,
+                        const Vertex2D &b, const Vertex2D &c, const Vertex2D &d)
+{
+    const Vertex2D corners[4] = {a, b, c, d};
+    this->add(layer, pipeline, texture, corners, 4u);
+}
+
+void Batcher2D::addRect(uint16_t layer, Pipeline2D pipeline, uint32_t texture, glm::vec2 min, glm::vec2 max,
+                        glm::vec4 color, glm::vec2 uvMin, glm::vec2 uvMax)
+{
+    this->addQuad(layer, pipeline, texture,
+                  Vertex2D{min, uvMin, color},
+                  Vertex2D{glm::vec2(max.x, min.y), glm::vec2(uvMax.x, uvMin.y), color},
+                  Vertex2D{max, uvMax, color},
+                  Vertex2D{glm::vec2(min.x, max.y), glm::vec2(uvMin.x, uvMax.y), color});
+}
+
+void Batcher2D::end()
+{
+    if (!this->recording)
+    {
+        throw std::runtime_error("Batcher2D::end() called without begin().");
+    }
+    this->recording = false;
+
+    // The sequence number makes the order of equal keys deterministic without a stable sort.
+    std::sort(this->primitives.begin(), this->primitives.end(),
+              [](const Primitive &a, const Primitive &b)
+              {
+                  return a.key != b.key ? a.key < b.key : a.sequence < b.sequence;
+              });
+
+    this->vertices.reserve(this->submittedVertices.size());
+
+    for (const auto &primitive : this->primitives)
+    {
+        auto pipeline = static_cast<Pipeline2D>((primitive.key >> 32u) & 0xFFFFu);
+        auto texture = static_cast<uint32_t>(primitive.key & 0xFFFFFFFFu);
+
+        // Layers only affect ordering, so a layer change with the same state continues the current draw.
+        if (this->draws.empty() || this->draws.back().pipeline != pipeline || this->draws.back().texture != texture)
+        {
+            this->draws.push_back(Draw2D{pipeline, texture, static_cast<uint32_t>(this->indices.size()), 0u});
+        }
+
+        auto base = static_cast<uint32_t>(this->vertices.size());
+        this->vertices.insert(this->vertices.end(), this->submittedVertices.begin() + primitive.firstVertex,
+                              this->submittedVertices.begin() + primitive.firstVertex + primitive.vertexCount);
+
+        if (primitive.vertexCount == 3u)
+        {
+            this->indices.insert(this->indices.end(), {base, base + 1u, base + 2u});
+            this->draws.back().indexCount += 3u;
+        }
+        else
+        {
+            this->indices.insert(this->indices.end(), {base, base + 1u, base + 2u, base + 2u, base + 3u, base});
+            this->draws.back().indexCount += 6u;
+        }
+    }
+}
+
+const vector<Vertex2D> &Batcher2D::getVertices() const noexcept
+{
+    return this->vertices;
+}
+
+const vector<uint32_t> &Batcher2D::getIndices() const noexcept
+{
+    return this->indices;
+}
+
+const vector<Draw2D> &Batcher2D::getDraws() const noexcept
+{
+    return this->draws;
+}
+
+size_t Batcher2D::primitiveCount() const noexcept
+{
+    return this->primitives.size();
+}
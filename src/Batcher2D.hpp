@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Vertex layout of the 2D batch shaders, matching the inputs of batch2d.vert.
+     */
+    struct Vertex2D
+    {
+        glm::vec2 position; /**< In pixels, origin at the top-left of the target */
+        glm::vec2 uv;
+        glm::vec4 color;
+    };
+
+    /**
+     * \brief Pipelines a 2D primitive can be drawn with. Textured primitives must use Textured.
+     */
+    enum class Pipeline2D : uint16_t
+    {
+        Solid,
+        Additive,
+        Textured,
+        Count
+    };
+
+    /**
+     * \brief Range of the batch's index buffer sharing one pipeline and texture.
+     */
+    struct Draw2D
+    {
+        Pipeline2D pipeline;
+        uint32_t texture; /**< 0 for untextured primitives */
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    /**
+     * \brief Accumulates 2D triangles and quads and turns them into as few draws as possible.
+     *
+     * \details
+     * Primitives are recorded in any order during a frame. end() sorts them by layer, then pipeline, then texture,
+     * keeping submission order for equal keys, and writes one vertex and index stream. Consecutive primitives with
+     * the same pipeline and texture end up in a single draw, even across layers.
+     *
+     * Layers are the only ordering guarantee. Primitives within a layer may be reordered, which is what lets their
+     * state changes be merged, so overlapping blended primitives that must keep their order need separate layers.
+     *
+     * This is all CPU work with no Vulkan dependency. Batch2DRenderer streams the result to the GPU. All buffers
+     * keep their capacity between frames, so steady-state frames do not allocate.
+     */
+    class Batcher2D
+    {
+    private:
+        /**
+         * \brief Submitted primitive. Its vertices live in submittedVertices until end() reorders them.
+         */
+        struct Primitive
+        {
+            uint64_t key; /**< layer:16 | pipeline:16 | texture:32 */
+            uint32_t sequence;
+            uint32_t firstVertex;
+            uint32_t vertexCount; /**< 3 for triangles, 4 for quads */
+        };
+
+        vector<Primitive> primitives;
+        vector<Vertex2D> submittedVertices;
+
+        vector<Vertex2D> vertices;
+        vector<uint32_t> indices;
+        vector<Draw2D> draws;
+
+        bool recording = false;
+
+        void add(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D *source, uint32_t count);
+
+    public:
+        /**
+         * \brief Starts a new frame, discarding the previous one's primitives but not its memory.
+         */
+        void begin();
+
+        void addTriangle(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D &a,
+                         const Vertex2D &b, const Vertex2D &c);
+
+        /**
+         * \brief Adds a quad whose corners are given in order around its edge.
+         */
+        void addQuad(uint16_t layer, Pipeline2D pipeline, uint32_t texture, const Vertex2D &a, const Vertex2D &b,
+                     const Vertex2D &c, const Vertex2D &d);
+
+        /**
+         * \brief Adds an axis aligned rectangle with a single color.
+         */
+        void addRect(uint16_t layer, Pipeline2D pipeline, uint32_t texture, glm::vec2 min, glm::vec2 max,
+                     glm::vec4 color, glm::vec2 uvMin = glm::vec2(0.0f), glm::vec2 uvMax = glm::vec2(1.0f));
+
+        /**
+         * \brief Sorts the frame's primitives and builds the vertex, index and draw lists.
+         */
+        void end();
+
+        [[nodiscard]] const vector<Vertex2D> &getVertices() const noexcept;
+
+        [[nodiscard]] const vector<uint32_t> &getIndices() const noexcept;
+
+        [[nodiscard]] const vector<Draw2D> &getDraws() const noexcept;
+
+        [[nodiscard]] size_t primitiveCount() const noexcept;
+    };
+}
@@ -0,0 +1,622 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "ComputeRunner.hpp"
+#include "reflection/ReduceComp.hpp"
+#include "reflection/ScanComp.hpp"
+#include "reflection/ScanAddComp.hpp"
+#include "reflection/SaxpyComp.hpp"
+
+using namespace VkTri;
+
+namespace ReduceShader = VkTri::Reflection::ReduceComp;
+namespace ScanShader = VkTri::Reflection::ScanComp;
+namespace ScanAddShader = VkTri::Reflection::ScanAddComp;
+namespace SaxpyShader = VkTri::Reflection::SaxpyComp;
+
+static_assert(sizeof(ReduceConstants) == ReduceShader::PUSH_CONSTANTS.size,
+              "ReduceConstants does not match the push constant block of reduce.comp");
+static_assert(sizeof(ScanConstants) == ScanShader::PUSH_CONSTANTS.size,
+              "ScanConstants does not match the push constant block of scan.comp");
+static_assert(sizeof(ScanConstants) == ScanAddShader::PUSH_CONSTANTS.size,
+              "ScanConstants does not match the push constant block of scan_add.comp");
+static_assert(sizeof(SaxpyConstants) == SaxpyShader::PUSH_CONSTANTS.size,
+              "SaxpyConstants does not match the push constant block of saxpy.comp");
+
+static constexpr float SAXPY_ALPHA = 2.0f;
+static constexpr uint32_t SUBMIT_OVERHEAD_SAMPLES = 32u;
+
+/**
+ * \brief Input value i. Small integers keep every sum exact, see COMPUTE_MAX_ELEMENTS.
+ */
+static float inputValue(uint32_t i)
+{
+    return static_cast<float>(i % 2u);
+}
+
+static uint32_t groupsFor(uint32_t count, uint32_t valuesPerGroup)
+{
+    return std::max((count + valuesPerGroup - 1u) / valuesPerGroup, 1u);
+}
+
+/**
+ * \brief Makes the results of the previous dispatch visible to the next one, and to transfers.
+ */
+static void computeBarrier(const vk::CommandBuffer &cmd)
+{
+    vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+                              vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite |
+                              vk::AccessFlagBits::eTransferRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                        vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                        {}, barrier, nullptr, nullptr);
+}
+
+bool ComputeRunner::isSuitable(const vk::PhysicalDevice &device)
+{
+    return findQueueFamily(device, vk::QueueFlagBits::eCompute).has_value();
+}
+
+unique_ptr<ComputeRunner> ComputeRunner::create(const vk::PhysicalDevice &device, uint32_t elementCount)
+{
+    if (elementCount == 0u || elementCount > COMPUTE_MAX_ELEMENTS)
+    {
+        throw std::invalid_argument(fmt::format("Compute runs need 1 to {:d} elements, not {:d}",
+                                                COMPUTE_MAX_ELEMENTS, elementCount));
+    }
+
+    auto runner = std::make_unique<ComputeRunner>();
+    runner->physicalDevice = device;
+    runner->elementCount = elementCount;
+
+    runner->createLogicalDevice();
+    runner->createBuffers();
+    runner->createKernels();
+    runner->createCommands();
+    runner->uploadInputs();
+
+    return runner;
+}
+
+ComputeRunner::~ComputeRunner()
+{
+    if (this->logicalDevice)
+    {
+        this->logicalDevice->waitIdle();
+    }
+}
+
+string ComputeRunner::name() const
+{
+    return string(this->physicalDevice.getProperties().deviceName.data());
+}
+
+// ======
+// Device
+// ======
+
+void ComputeRunner::createLogicalDevice()
+{
+    // A compute-only family is usually an async compute queue, which does not compete with graphics work.
+    auto queueFamilies = this->physicalDevice.getQueueFamilyProperties();
+    std::optional<uint32_t> family;
+    for (uint32_t i = 0; i < queueFamilies.size(); i++)
+    {
+        if ((queueFamilies[i].queueFlags & vk::QueueFlagBits::eCompute) &&
+            !(queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics))
+        {
+            family = i;
+            break;
+        }
+    }
+    if (!family.has_value())
+    {
+        family = findQueueFamily(this->physicalDevice, vk::QueueFlagBits::eCompute);
+    }
+    this->computeFamily = family.value();
+
+    float queuePriority = 1.0f;
+    vk::DeviceQueueCreateInfo queueCreateInfo;
+    queueCreateInfo.queueFamilyIndex = this->computeFamily;
+    queueCreateInfo.queueCount = 1u;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    vector<const char *> extensions;
+    bool budgetSupported = MemoryTracker::isBudgetExtensionSupported(this->physicalDevice);
+    if (budgetSupported)
+    {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    vk::DeviceCreateInfo createInfo;
+    createInfo.queueCreateInfoCount = 1u;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+
+    // Like the offscreen renderers, device functions go through the loader trampolines so devices can coexist.
+    this->logicalDevice = this->physicalDevice.createDeviceUnique(createInfo);
+    this->computeQueue = this->logicalDevice->getQueue(this->computeFamily, 0);
+
+    this->memoryTracker = std::make_unique<MemoryTracker>(this->physicalDevice, this->logicalDevice.get(),
+                                                          budgetSupported);
+    this->descriptorLayouts = std::make_unique<DescriptorLayoutCache>(this->logicalDevice.get());
+    this->descriptors = std::make_unique<DescriptorAllocator>(this->logicalDevice.get(), 1u);
+
+    auto validBits = queueFamilies[this->computeFamily].timestampValidBits;
+    if (validBits != 0u)
+    {
+        this->timestampPeriod = this->physicalDevice.getProperties().limits.timestampPeriod;
+        this->timestampMask = validBits >= 64u ? ~0ull : (1ull << validBits) - 1u;
+
+        vk::QueryPoolCreateInfo queryPoolInfo;
+        queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+        queryPoolInfo.queryCount = 2u;
+        this->timestampPool = this->logicalDevice->createQueryPoolUnique(queryPoolInfo);
+    }
+}
+
+// =======
+// Buffers
+// =======
+
+ComputeRunner::ComputeBuffer ComputeRunner::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+                                                         vk::MemoryPropertyFlags properties, MemoryCategory category)
+{
+    ComputeBuffer result;
+    result.size = size;
+
+    vk::BufferCreateInfo bufferInfo;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+    result.buffer = this->logicalDevice->createBufferUnique(bufferInfo);
+    auto requirements = this->logicalDevice->getBufferMemoryRequirements(result.buffer.get());
+    result.memory = this->memoryTracker->allocate(requirements, properties, category);
+    this->logicalDevice->bindBufferMemory(result.buffer.get(), result.memory.get(), 0);
+
+    return result;
+}
+
+void ComputeRunner::createBuffers()
+{
+    auto storage = [this](uint32_t count)
+    {
+        return this->createBuffer(count * sizeof(float), vk::BufferUsageFlagBits::eStorageBuffer |
+                                                         vk::BufferUsageFlagBits::eTransferSrc |
+                                                         vk::BufferUsageFlagBits::eTransferDst,
+                                  vk::MemoryPropertyFlagBits::eDeviceLocal, MemoryCategory::Buffer);
+    };
+
+    this->inputX = storage(this->elementCount);
+    this->inputY = storage(this->elementCount);
+    this->reducePartials = storage(REDUCE_MAX_GROUPS);
+    this->reduceResult = storage(1u);
+    this->scanOutput = storage(this->elementCount);
+
+    // Each level scans the block sums of the previous one, until a single block holds everything.
+    for (auto count = this->elementCount;; count = groupsFor(count, SCAN_BLOCK_SIZE))
+    {
+        ScanLevel level;
+        level.count = count;
+        if (!this->scanLevels.empty())
+        {
+            level.output = storage(count);
+        }
+        level.sums = storage(groupsFor(count, SCAN_BLOCK_SIZE));
+        this->scanLevels.push_back(std::move(level));
+
+        if (count <= SCAN_BLOCK_SIZE)
+        {
+            break;
+        }
+    }
+
+    this->staging = this->createBuffer(this->elementCount * sizeof(float),
+                                       vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+                                       vk::MemoryPropertyFlagBits::eHostVisible |
+                                       vk::MemoryPropertyFlagBits::eHostCoherent, MemoryCategory::Staging);
+    this->stagingData = static_cast<float *>(
+            this->logicalDevice->mapMemory(this->staging.memory.get(), 0, VK_WHOLE_SIZE));
+}
+
+// =======
+// Kernels
+// =======
+
+ComputeRunner::ComputeKernel ComputeRunner::createKernel(const fs::path &shaderPath, const ShaderInterface &interface)
+{
+    ComputeKernel kernel;
+    kernel.setLayout = this->descriptorLayouts->get(descriptorSetLayoutBindings({interface}, 0, false));
+
+    auto ranges = pushConstantRanges({interface});
+
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &kernel.setLayout;
+    layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+    layoutInfo.pPushConstantRanges = ranges.data();
+
+    kernel.layout = this->logicalDevice->createPipelineLayoutUnique(layoutInfo);
+
+    auto shaderModule = loadShaderModule(this->logicalDevice.get(), shaderPath);
+
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.stage = vk::PipelineShaderStageCreateInfo({}, interface.stage, shaderModule.get(), "main");
+    pipelineInfo.layout = kernel.layout.get();
+
+    kernel.pipeline = this->logicalDevice->createComputePipelineUnique(nullptr, pipelineInfo).value;
+    return kernel;
+}
+
+vk::DescriptorSet ComputeRunner::createSet(const ComputeKernel &kernel, std::initializer_list<vk::Buffer> buffers)
+{
+    auto set = this->descriptors->allocatePersistent(kernel.setLayout);
+
+    vector<vk::DescriptorBufferInfo> bufferInfos;
+    vector<vk::WriteDescriptorSet> writes;
+    bufferInfos.reserve(buffers.size());
+    for (const auto &buffer : buffers)
+    {
+        bufferInfos.emplace_back(buffer, 0, VK_WHOLE_SIZE);
+
+        vk::WriteDescriptorSet write;
+        write.dstSet = set;
+        write.dstBinding = static_cast<uint32_t>(writes.size());
+        write.descriptorCount = 1;
+        write.descriptorType = vk::DescriptorType::eStorageBuffer;
+        write.pBufferInfo = &bufferInfos.back();
+        writes.push_back(write);
+    }
+
+    this->logicalDevice->updateDescriptorSets(writes, nullptr);
+    return set;
+}
+
+void ComputeRunner::createKernels()
+{
+    this->reduceKernel = this->createKernel(REDUCE_SHADER_PATH, ReduceShader::INTERFACE);
+    this->scanKernel = this->createKernel(SCAN_SHADER_PATH, ScanShader::INTERFACE);
+    this->scanAddKernel = this->createKernel(SCAN_ADD_SHADER_PATH, ScanAddShader::INTERFACE);
+    this->saxpyKernel = this->createKernel(SAXPY_SHADER_PATH, SaxpyShader::INTERFACE);
+
+    this->reduceSets = {
+            this->createSet(this->reduceKernel, {this->inputX.buffer.get(), this->reducePartials.buffer.get()}),
+            this->createSet(this->reduceKernel, {this->reducePartials.buffer.get(), this->reduceResult.buffer.get()})};
+
+    for (size_t i = 0; i < this->scanLevels.size(); i++)
+    {
+        auto &level = this->scanLevels[i];
+        auto input = i == 0u ? this->inputX.buffer.get() : this->scanLevels[i - 1u].sums.buffer.get();
+        auto output = i == 0u ? this->scanOutput.buffer.get() : level.output.buffer.get();
+
+        level.scanSet = this->createSet(this->scanKernel, {input, output, level.sums.buffer.get()});
+        if (i + 1u < this->scanLevels.size())
+        {
+            // The next level's output holds this level's block sums, scanned.
+            level.addSet = this->createSet(this->scanAddKernel, {output, this->scanLevels[i + 1u].output.buffer.get()});
+        }
+    }
+
+    this->saxpySet = this->createSet(this->saxpyKernel, {this->inputX.buffer.get(), this->inputY.buffer.get()});
+}
+
+void ComputeRunner::createCommands()
+{
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = this->computeFamily;
+
+    this->commandPool = this->logicalDevice->createCommandPoolUnique(poolInfo);
+
+    vk::CommandBufferAllocateInfo allocInfo;
+    allocInfo.commandPool = this->commandPool.get();
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandBufferCount = 1;
+
+    this->commandBuffer = std::move(this->logicalDevice->allocateCommandBuffersUnique(allocInfo).front());
+    this->fence = this->logicalDevice->createFenceUnique({});
+}
+
+// =========
+// Recording
+// =========
+
+double ComputeRunner::submit(const std::function<void(const vk::CommandBuffer &)> &record)
+{
+    auto &cmd = this->commandBuffer.get();
+    this->logicalDevice->resetCommandPool(this->commandPool.get(), {});
+
+    vk::CommandBufferBeginInfo beginInfo;
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    cmd.begin(beginInfo);
+    record(cmd);
+    cmd.end();
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+
+    auto start = std::chrono::steady_clock::now();
+    this->logicalDevice->resetFences(this->fence.get());
+    this->computeQueue.submit(submitInfo, this->fence.get());
+    if (this->logicalDevice->waitForFences(this->fence.get(), VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+    {
+        throw std::runtime_error(fmt::format("Timed out waiting for compute work on {:s}", this->name()));
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+void ComputeRunner::uploadInputs()
+{
+    for (uint32_t i = 0; i < this->elementCount; i++)
+    {
+        this->stagingData[i] = inputValue(i);
+    }
+    this->submit([this](const vk::CommandBuffer &cmd)
+    {
+        cmd.copyBuffer(this->staging.buffer.get(), this->inputX.buffer.get(),
+                       vk::BufferCopy(0, 0, this->inputX.size));
+    });
+
+    std::fill(this->stagingData, this->stagingData + this->elementCount, 1.0f);
+    this->submit([this](const vk::CommandBuffer &cmd)
+    {
+        cmd.copyBuffer(this->staging.buffer.get(), this->inputY.buffer.get(),
+                       vk::BufferCopy(0, 0, this->inputY.size));
+    });
+}
+
+double ComputeRunner::timeBatch(uint32_t runs, const std::function<void(const vk::CommandBuffer &)> &recordRun,
+                                const std::function<void(const vk::CommandBuffer &)> &readback)
+{
+    auto cpuMs = this->submit([&](const vk::CommandBuffer &cmd)
+    {
+        // Uploads from earlier submissions must be visible to the first run.
+        computeBarrier(cmd);
+
+        if (this->timestampPool)
+        {
+            cmd.resetQueryPool(this->timestampPool.get(), 0u, 2u);
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, this->timestampPool.get(), 0u);
+        }
+
+        for (uint32_t i = 0; i < runs; i++)
+        {
+            recordRun(cmd);
+            computeBarrier(cmd);
+        }
+
+        if (this->timestampPool)
+        {
+            cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampPool.get(), 1u);
+        }
+
+        readback(cmd);
+    });
+
+    if (this->timestampPool)
+    {
+        std::array<uint64_t, 2> timestamps{};
+        auto result = this->logicalDevice->getQueryPoolResults(this->timestampPool.get(), 0u, 2u,
+                                                               sizeof(timestamps), timestamps.data(),
+                                                               sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+        if (result == vk::Result::eSuccess)
+        {
+            auto ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+            return static_cast<double>(ticks) * this->timestampPeriod / 1.0e6 / runs;
+        }
+    }
+
+    return cpuMs / runs;
+}
+
+void ComputeRunner::copyToStaging(const vk::CommandBuffer &cmd, const ComputeBuffer &source,
+                                  vk::DeviceSize size) const
+{
+    cmd.copyBuffer(source.buffer.get(), this->staging.buffer.get(), vk::BufferCopy(0, 0, size));
+
+    vk::MemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+                        hostBarrier, nullptr, nullptr);
+}
+
+void ComputeRunner::recordReduce(const vk::CommandBuffer &cmd) const
+{
+    auto groups = std::min(groupsFor(this->elementCount, COMPUTE_WORKGROUP_SIZE), REDUCE_MAX_GROUPS);
+    auto layout = this->reduceKernel.layout.get();
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, this->reduceKernel.pipeline.get());
+
+    ReduceConstants constants{this->elementCount};
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, this->reduceSets[0], nullptr);
+    cmd.pushConstants(layout, ReduceShader::STAGE, 0, sizeof(constants), &constants);
+    cmd.dispatch(groups, 1, 1);
+
+    computeBarrier(cmd);
+
+    constants.count = groups;
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, this->reduceSets[1], nullptr);
+    cmd.pushConstants(layout, ReduceShader::STAGE, 0, sizeof(constants), &constants);
+    cmd.dispatch(1, 1, 1);
+}
+
+void ComputeRunner::recordScan(const vk::CommandBuffer &cmd) const
+{
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, this->scanKernel.pipeline.get());
+    for (size_t i = 0; i < this->scanLevels.size(); i++)
+    {
+        const auto &level = this->scanLevels[i];
+        if (i != 0u)
+        {
+            computeBarrier(cmd);
+        }
+
+        ScanConstants constants{level.count};
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->scanKernel.layout.get(), 0, level.scanSet,
+                               nullptr);
+        cmd.pushConstants(this->scanKernel.layout.get(), ScanShader::STAGE, 0, sizeof(constants), &constants);
+        cmd.dispatch(groupsFor(level.count, SCAN_BLOCK_SIZE), 1, 1);
+    }
+
+    // Offsets flow from the coarsest level back down to the input.
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, this->scanAddKernel.pipeline.get());
+    for (auto i = this->scanLevels.size() - 1u; i-- > 0u;)
+    {
+        const auto &level = this->scanLevels[i];
+        computeBarrier(cmd);
+
+        ScanConstants constants{level.count};
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->scanAddKernel.layout.get(), 0, level.addSet,
+                               nullptr);
+        cmd.pushConstants(this->scanAddKernel.layout.get(), ScanAddShader::STAGE, 0, sizeof(constants),
+                          &constants);
+        cmd.dispatch(groupsFor(level.count, SCAN_BLOCK_SIZE), 1, 1);
+    }
+}
+
+void ComputeRunner::recordSaxpy(const vk::CommandBuffer &cmd, uint32_t count) const
+{
+    auto maxGroups = this->physicalDevice.getProperties().limits.maxComputeWorkGroupCount[0];
+    auto groups = std::min(groupsFor(count, COMPUTE_WORKGROUP_SIZE), maxGroups);
+
+    SaxpyConstants constants{count, SAXPY_ALPHA};
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, this->saxpyKernel.pipeline.get());
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, this->saxpyKernel.layout.get(), 0, this->saxpySet,
+                           nullptr);
+    cmd.pushConstants(this->saxpyKernel.layout.get(), SaxpyShader::STAGE, 0, sizeof(constants), &constants);
+    cmd.dispatch(groups, 1, 1);
+}
+
+// =======
+// Running
+// =======
+
+ComputeKernelResult ComputeRunner::runReduce(uint32_t batchSize)
+{
+    ComputeKernelResult result;
+    result.kernel = "reduce";
+    result.dispatchesPerRun = 2u;
+    result.msPerRun = this->timeBatch(batchSize, [this](const vk::CommandBuffer &cmd) { this->recordReduce(cmd); },
+                                      [this](const vk::CommandBuffer &cmd)
+                                      {
+                                          this->copyToStaging(cmd, this->reduceResult, sizeof(float));
+                                      });
+
+    // Every other value is 1.
+    auto expected = static_cast<float>(this->elementCount / 2u);
+    result.correct = this->stagingData[0] == expected;
+    result.gigabytesPerSecond = static_cast<double>(this->inputX.size) / (result.msPerRun * 1.0e6);
+    return result;
+}
+
+ComputeKernelResult ComputeRunner::runScan(uint32_t batchSize)
+{
+    ComputeKernelResult result;
+    result.kernel = "scan";
+    result.dispatchesPerRun = static_cast<uint32_t>(this->scanLevels.size() * 2u - 1u);
+    result.msPerRun = this->timeBatch(batchSize, [this](const vk::CommandBuffer &cmd) { this->recordScan(cmd); },
+                                      [this](const vk::CommandBuffer &cmd)
+                                      {
+                                          this->copyToStaging(cmd, this->scanOutput, this->scanOutput.size);
+                                      });
+
+    result.correct = true;
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < this->elementCount && result.correct; i++)
+    {
+        sum += inputValue(i);
+        result.correct = this->stagingData[i] == sum;
+    }
+    result.gigabytesPerSecond = 2.0 * static_cast<double>(this->inputX.size) / (result.msPerRun * 1.0e6);
+    return result;
+}
+
+ComputeKernelResult ComputeRunner::runSaxpy(uint32_t batchSize)
+{
+    ComputeKernelResult result;
+    result.kernel = "saxpy";
+    result.dispatchesPerRun = 1u;
+    result.msPerRun = this->timeBatch(batchSize,
+                                      [this](const vk::CommandBuffer &cmd)
+                                      {
+                                          this->recordSaxpy(cmd, this->elementCount);
+                                      },
+                                      [this](const vk::CommandBuffer &cmd)
+                                      {
+                                          this->copyToStaging(cmd, this->inputY, this->inputY.size);
+                                      });
+
+    // y started at 1 and had alpha * x added once per run, which stays exact for the batch sizes used.
+    result.correct = true;
+    for (uint32_t i = 0; i < this->elementCount && result.correct; i++)
+    {
+        auto expected = 1.0f + static_cast<float>(batchSize) * SAXPY_ALPHA * inputValue(i);
+        result.correct = this->stagingData[i] == expected;
+    }
+    result.gigabytesPerSecond = 3.0 * static_cast<double>(this->inputX.size) / (result.msPerRun * 1.0e6);
+
+    // Restore y, so that another run starts from the same values.
+    std::fill(this->stagingData, this->stagingData + this->elementCount, 1.0f);
+    this->submit([this](const vk::CommandBuffer &cmd)
+    {
+        cmd.copyBuffer(this->staging.buffer.get(), this->inputY.buffer.get(),
+                       vk::BufferCopy(0, 0, this->inputY.size));
+    });
+
+    return result;
+}
+
+void ComputeRunner::measureOverhead(uint32_t batchSize, ComputeReport &report)
+{
+    // SAXPY over no elements does no work, so what is left is the cost of the dispatch and its barrier.
+    auto emptyRun = [this](const vk::CommandBuffer &cmd) { this->recordSaxpy(cmd, 0u); };
+    report.dispatchOverheadUs = this->timeBatch(batchSize, emptyRun, [](const vk::CommandBuffer &) {}) * 1.0e3;
+
+    // Submits the same single dispatch again and again, so recording does not count towards the submission.
+    this->logicalDevice->resetCommandPool(this->commandPool.get(), {});
+    auto &cmd = this->commandBuffer.get();
+    cmd.begin(vk::CommandBufferBeginInfo());
+    emptyRun(cmd);
+    cmd.end();
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < SUBMIT_OVERHEAD_SAMPLES; i++)
+    {
+        this->logicalDevice->resetFences(this->fence.get());
+        this->computeQueue.submit(submitInfo, this->fence.get());
+        if (this->logicalDevice->waitForFences(this->fence.get(), VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+        {
+            throw std::runtime_error(fmt::format("Timed out waiting for compute work on {:s}", this->name()));
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    report.submitOverheadUs = elapsed.count() / SUBMIT_OVERHEAD_SAMPLES;
+}
+
+ComputeReport ComputeRunner::run(uint32_t batchSize)
+{
+    batchSize = std::max(batchSize, 1u);
+
+    ComputeReport report;
+    report.deviceName = this->name();
+    report.gpuTimestamps = static_cast<bool>(this->timestampPool);
+    report.kernels.push_back(this->runReduce(batchSize));
+    report.kernels.push_back(this->runScan(batchSize));
+    report.kernels.push_back(this->runSaxpy(batchSize));
+    this->measureOverhead(batchSize, report);
+
+    return report;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "DescriptorAllocator.hpp"
+#include "MemoryTracker.hpp"
+#include "ShaderReflection.hpp"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    const fs::path REDUCE_SHADER_PATH("../shaders/reduce_comp.spv");
+    const fs::path SCAN_SHADER_PATH("../shaders/scan_comp.spv");
+    const fs::path SCAN_ADD_SHADER_PATH("../shaders/scan_add_comp.spv");
+    const fs::path SAXPY_SHADER_PATH("../shaders/saxpy_comp.spv");
+
+    static constexpr uint32_t COMPUTE_WORKGROUP_SIZE = 256u; /**< local_size_x of every compute shader */
+    static constexpr uint32_t SCAN_BLOCK_SIZE = COMPUTE_WORKGROUP_SIZE * 4u; /**< Values scanned per workgroup */
+    static constexpr uint32_t REDUCE_MAX_GROUPS = 1024u; /**< Partial sums of the first reduction pass */
+
+    /**
+     * \brief Largest supported input. The inputs are small integers, so every sum up to this size is exact in a
+     * float and results can be compared bit for bit.
+     */
+    static constexpr uint32_t COMPUTE_MAX_ELEMENTS = 1u << 24u;
+
+    /**
+     * \brief Push constants of reduce.comp.
+     */
+    struct ReduceConstants
+    {
+        uint32_t count;
+    };
+
+    /**
+     * \brief Push constants of scan.comp and scan_add.comp.
+     */
+    struct ScanConstants
+    {
+        uint32_t count;
+    };
+
+    /**
+     * \brief Push constants of saxpy.comp.
+     */
+    struct SaxpyConstants
+    {
+        uint32_t count;
+        float alpha;
+    };
+
+    /**
+     * \brief Timing of one kernel, averaged over a batch of runs submitted together.
+     */
+    struct ComputeKernelResult
+    {
+        string kernel;
+        uint32_t dispatchesPerRun = 0u;
+        double msPerRun = 0.0;
+        double gigabytesPerSecond = 0.0; /**< Minimum traffic of the kernel (each input read, each output written) */
+        bool correct = false; /**< Whether the last run's output matched the CPU reference */
+    };
+
+    /**
+     * \brief Results of every kernel on one device.
+     */
+    struct ComputeReport
+    {
+        string deviceName;
+        bool gpuTimestamps = false; /**< Times come from GPU timestamps, or from the CPU around submit and wait */
+        vector<ComputeKernelResult> kernels;
+        double dispatchOverheadUs = 0.0; /**< GPU time of an empty dispatch and its barrier within a batch */
+        double submitOverheadUs = 0.0; /**< CPU time to submit an empty dispatch and wait for it */
+    };
+
+    /**
+     * \brief Runs compute kernels on a device without any graphics or presentation setup.
+     *
+     * \details
+     * The logical device only has a compute queue, preferring a compute family without graphics support.
+     * Every kernel runs a batch of times in one command buffer and one submission, with a barrier between
+     * dispatches, so the per-run time is not dominated by submission cost. The cost of a dispatch and of a
+     * submission is measured separately with empty dispatches. Reports from different devices, lavapipe included,
+     * come from the same code and are directly comparable.
+     */
+    class ComputeRunner
+    {
+    private:
+        /**
+         * \brief Storage buffer of floats.
+         */
+        struct ComputeBuffer
+        {
+            vk::UniqueBuffer buffer;
+            DeviceAllocation memory;
+            vk::DeviceSize size = 0u;
+        };
+
+        struct ComputeKernel
+        {
+            vk::DescriptorSetLayout setLayout; /**< Owned by descriptorLayouts */
+            vk::UniquePipelineLayout layout;
+            vk::UniquePipeline pipeline;
+        };
+
+        /**
+         * \brief One level of the scan: blocks of input scanned into output, with their totals in sums.
+         * \details Level 0 scans the input, every further level scans the block sums of the level before.
+         */
+        struct ScanLevel
+        {
+            uint32_t count = 0u;
+            ComputeBuffer output; /**< Unused at level 0, which writes scanOutput */
+            ComputeBuffer sums;
+            vk::DescriptorSet scanSet;
+            vk::DescriptorSet addSet; /**< Adds the next level's output to this level's, null on the last level */
+        };
+
+        vk::PhysicalDevice physicalDevice;
+        vk::UniqueDevice logicalDevice;
+        vk::Queue computeQueue;
+        uint32_t computeFamily = 0u;
+        unique_ptr<MemoryTracker> memoryTracker;
+        unique_ptr<DescriptorLayoutCache> descriptorLayouts;
+        unique_ptr<DescriptorAllocator> descriptors; /**< Only persistent sets, the bindings never change */
+
+        uint32_t elementCount = 0u;
+        ComputeBuffer inputX;
+        ComputeBuffer inputY; /**< Updated in place by SAXPY */
+        ComputeBuffer reducePartials;
+        ComputeBuffer reduceResult;
+        ComputeBuffer scanOutput;
+        vector<ScanLevel> scanLevels;
+        ComputeBuffer staging; /**< Host visible, used for uploads and readbacks */
+        float *stagingData = nullptr;
+
+        ComputeKernel reduceKernel;
+        ComputeKernel scanKernel;
+        ComputeKernel scanAddKernel;
+        ComputeKernel saxpyKernel;
+        std::array<vk::DescriptorSet, 2> reduceSets; /**< Input to partials, then partials to result */
+        vk::DescriptorSet saxpySet;
+
+        vk::UniqueCommandPool commandPool;
+        vk::UniqueCommandBuffer commandBuffer;
+        vk::UniqueFence fence;
+
+        vk::UniqueQueryPool timestampPool; /**< Null if the compute queue has no timestamps */
+        double timestampPeriod = 0.0;
+        uint64_t timestampMask = 0u;
+
+        void createLogicalDevice();
+
+        [[nodiscard]] ComputeBuffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage,
+                                                 vk::MemoryPropertyFlags properties, MemoryCategory category);
+
+        void createBuffers();
+
+        [[nodiscard]] ComputeKernel createKernel(const fs::path &shaderPath, const ShaderInterface &interface);
+
+        [[nodiscard]] vk::DescriptorSet createSet(const ComputeKernel &kernel,
+                                                  std::initializer_list<vk::Buffer> buffers);
+
+        void createKernels();
+
+        void createCommands();
+
+        void uploadInputs();
+
+        /**
+         * \brief Records commands into the runner's command buffer, submits them and waits for the device.
+         * \return CPU time from submission until the fence signaled, in milliseconds.
+         */
+        double submit(const std::function<void(const vk::CommandBuffer &)> &record);
+
+        /**
+         * \brief Records the kernel's runs between two timestamps and returns the time per run in milliseconds.
+         * \param readback recorded after the runs, to copy results into the staging buffer.
+         */
+        double timeBatch(uint32_t runs, const std::function<void(const vk::CommandBuffer &)> &recordRun,
+                         const std::function<void(const vk::CommandBuffer &)> &readback);
+
+        void recordReduce(const vk::CommandBuffer &cmd) const;
+
+        void recordScan(const vk::CommandBuffer &cmd) const;
+
+        void recordSaxpy(const vk::CommandBuffer &cmd, uint32_t count) const;
+
+        void copyToStaging(const vk::CommandBuffer &cmd, const ComputeBuffer &source, vk::DeviceSize size) const;
+
+        [[nodiscard]] ComputeKernelResult runReduce(uint32_t batchSize);
+
+        [[nodiscard]] ComputeKernelResult runScan(uint32_t batchSize);
+
+        [[nodiscard]] ComputeKernelResult runSaxpy(uint32_t batchSize);
+
+        void measureOverhead(uint32_t batchSize, ComputeReport &report);
+
+    public:
+        /**
+         * \brief Checks if the device has a compute queue.
+         */
+        [[nodiscard]] static bool isSuitable(const vk::PhysicalDevice &device);
+
+        /**
+         * \brief Creates a compute-only logical device and the buffers for kernels over elementCount values.
+         * \throws std::invalid_argument if elementCount is 0 or above COMPUTE_MAX_ELEMENTS.
+         */
+        [[nodiscard]] static unique_ptr<ComputeRunner> create(const vk::PhysicalDevice &device,
+                                                              uint32_t elementCount);
+
+        ~ComputeRunner();
+
+        /**
+         * \brief Runs every kernel batchSize times in one submission each, then measures dispatch overhead.
+         */
+        [[nodiscard]] ComputeReport run(uint32_t batchSize);
+
+        [[nodiscard]] string name() const;
+    };
+}
@@ -0,0 +1,30 @@
+#include "DeletionQueue.hpp"
+
+using namespace VkTri;
+
+size_t DeletionQueue::collect(uint64_t completedFrame)
+{
+    size_t destroyed = 0u;
+    while (!this->entries.empty() && this->entries.front().frame <= completedFrame)
+    {
+        this->entries.pop_front();
+        destroyed++;
+    }
+
+    return destroyed;
+}
+
+void DeletionQueue::flush()
+{
+    this->entries.clear();
+}
+
+bool DeletionQueue::empty() const noexcept
+{
+    return this->entries.empty();
+}
+
+size_t DeletionQueue::size() const noexcept
+{
+    return this->entries.size();
+}
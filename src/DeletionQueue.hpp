@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+using std::unique_ptr;
+
+namespace VkTri
+{
+    /**
+     * \brief Holds on to GPU resources until the last frame that used them has completed.
+     *
+     * \details
+     * Replacing a resource that frames in flight may still read, e.g. a swap chain, a pipeline or a buffer, used
+     * to mean either vkDeviceWaitIdle or a use-after-free on the GPU. Instead, the old resource is moved into the
+     * queue along with the number of the last frame submitted so far, and destroyed by collect() once the owner
+     * has seen that frame's fence signal.
+     *
+     * Any movable type can be deferred: vk::Unique handles, DeviceAllocation, unique_ptr to a whole FrameGraph,
+     * or a vector of image views. Entries are destroyed in the order they were deferred, and frames are expected
+     * to be non-decreasing, so an entry never outlives the ones deferred after it by more than a frame.
+     *
+     * The queue does not know about the device. Its owner must flush() it, after waiting for the device to go
+     * idle, before destroying the device or the MemoryTracker the resources came from.
+     */
+    class DeletionQueue
+    {
+    private:
+        struct Retired
+        {
+            virtual ~Retired() = default;
+        };
+
+        template<typename T>
+        struct RetiredResource : Retired
+        {
+            T resource;
+
+            explicit RetiredResource(T &&resource) : resource(std::move(resource))
+            {}
+        };
+
+        struct Entry
+        {
+            uint64_t frame; /**< Last frame that may use the resource */
+            unique_ptr<Retired> retired;
+        };
+
+        std::deque<Entry> entries;
+
+    public:
+        /**
+         * \brief Takes ownership of a resource until the given frame has completed.
+         * \param lastUseFrame number of the last frame submitted that may use the resource, 0 if none.
+         */
+        template<typename T>
+        void defer(uint64_t lastUseFrame, T &&resource)
+        {
+            static_assert(!std::is_lvalue_reference<T>::value, "Resources must be moved into the deletion queue.");
+            this->entries.push_back(Entry{lastUseFrame, std::make_unique<RetiredResource<T>>(std::move(resource))});
+        }
+
+        /**
+         * \brief Destroys every resource whose last frame is at most completedFrame.
+         * \return number of resources destroyed.
+         */
+        size_t collect(uint64_t completedFrame);
+
+        /**
+         * \brief Destroys everything. The device must be idle.
+         */
+        void flush();
+
+        [[nodiscard]] bool empty() const noexcept;
+
+        [[nodiscard]] size_t size() const noexcept;
+    };
+}
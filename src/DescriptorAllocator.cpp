@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <fmt/format.h>
+#include "DescriptorAllocator.hpp"
+
+using namespace VkTri;
+
+// ======================
+// DescriptorLayoutCache
+// ======================
+
+DescriptorLayoutCache::DescriptorLayoutCache(const vk::Device &device) : device(device)
+{}
+
+vk::DescriptorSetLayout DescriptorLayoutCache::get(const vector<vk::DescriptorSetLayoutBinding> &bindings)
+{
+    LayoutKey key;
+    key.reserve(bindings.size());
+    for (const auto &binding : bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            throw std::runtime_error(fmt::format("Binding {:d} uses immutable samplers, which cannot be cached",
+                                                 binding.binding));
+        }
+        key.emplace_back(binding.binding, binding.descriptorType, binding.descriptorCount,
+                         static_cast<VkShaderStageFlags>(binding.stageFlags));
+    }
+    std::sort(key.begin(), key.end());
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto &layout = this->layouts[key];
+    if (!layout)
+    {
+        vk::DescriptorSetLayoutCreateInfo layoutInfo;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        layout = this->device.createDescriptorSetLayoutUnique(layoutInfo);
+    }
+
+    return layout.get();
+}
+
+size_t DescriptorLayoutCache::size()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->layouts.size();
+}
+
+// ===================
+// DescriptorAllocator
+// ===================
+
+DescriptorAllocator::DescriptorAllocator(const vk::Device &device, uint32_t frameCount, uint32_t threadCount,
+                                         vector<DescriptorPoolRatio> ratios)
+        : device(device), ratios(std::move(ratios)), threadSlots(threadCount)
+{
+    for (auto &slot : this->threadSlots)
+    {
+        slot.frames.resize(frameCount);
+    }
+}
+
+vk::UniqueDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) const
+{
+    vector<vk::DescriptorPoolSize> poolSizes;
+    poolSizes.reserve(this->ratios.size());
+    for (const auto &ratio : this->ratios)
+    {
+        auto count = static_cast<uint32_t>(std::ceil(ratio.perSet * static_cast<float>(maxSets)));
+        poolSizes.emplace_back(ratio.type, std::max(count, 1u));
+    }
+
+    vk::DescriptorPoolCreateInfo poolInfo;
+    poolInfo.maxSets = maxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    return this->device.createDescriptorPoolUnique(poolInfo);
+}
+
+vk::DescriptorSet DescriptorAllocator::allocateFrom(PoolChain &chain, const vk::DescriptorSetLayout &layout)
+{
+    vk::DescriptorSetAllocateInfo allocInfo;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    while (true)
+    {
+        bool freshPool = chain.current == chain.pools.size();
+        if (freshPool)
+        {
+            auto doublings = std::min<size_t>(chain.pools.size(), 6u);
+            chain.pools.push_back(this->createPool(std::min(INITIAL_SETS_PER_POOL << doublings, MAX_SETS_PER_POOL)));
+        }
+
+        allocInfo.descriptorPool = chain.pools[chain.current].get();
+
+        vk::DescriptorSet set;
+        auto result = this->device.allocateDescriptorSets(&allocInfo, &set);
+        if (result == vk::Result::eSuccess)
+        {
+            return set;
+        }
+
+        // A set that does not fit an empty pool would not fit the next one either.
+        bool poolFull = result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool;
+        if (!poolFull || freshPool)
+        {
+            throw std::runtime_error(fmt::format("Failed to allocate descriptor set: {:s}", vk::to_string(result)));
+        }
+
+        chain.current++;
+    }
+}
+
+void DescriptorAllocator::beginFrame(uint32_t frameIndex)
+{
+    this->frameIndex = frameIndex;
+
+    for (auto &slot : this->threadSlots)
+    {
+        auto &chain = slot.frames[frameIndex];
+        for (size_t i = 0; i < chain.pools.size() && i <= chain.current; i++)
+        {
+            this->device.resetDescriptorPool(chain.pools[i].get());
+        }
+        chain.current = 0u;
+    }
+}
+
+vk::DescriptorSet DescriptorAllocator::allocateTransient(const vk::DescriptorSetLayout &layout, uint32_t threadIndex)
+{
+    return this->allocateFrom(this->threadSlots[threadIndex].frames[this->frameIndex], layout);
+}
+
+vk::DescriptorSet DescriptorAllocator::allocatePersistent(const vk::DescriptorSetLayout &layout, uint32_t threadIndex)
+{
+    return this->allocateFrom(this->threadSlots[threadIndex].persistent, layout);
+}
+
+size_t DescriptorAllocator::poolCount() const noexcept
+{
+    size_t count = 0u;
+    for (const auto &slot : this->threadSlots)
+    {
+        for (const auto &chain : slot.frames)
+        {
+            count += chain.pools.size();
+        }
+        count += slot.persistent.pools.size();
+    }
+    return count;
+}
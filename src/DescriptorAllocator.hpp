@@ -0,0 +1,145 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Descriptors of one type a pool gets per set it can hold.
+     */
+    struct DescriptorPoolRatio
+    {
+        vk::DescriptorType type;
+        float perSet;
+    };
+
+    /**
+     * \brief Pool composition used when none is given, covering the descriptor types the renderers use.
+     */
+    inline const vector<DescriptorPoolRatio> DEFAULT_DESCRIPTOR_POOL_RATIOS = {
+            {vk::DescriptorType::eUniformBufferDynamic, 1.0f},
+            {vk::DescriptorType::eUniformBuffer,        1.0f},
+            {vk::DescriptorType::eStorageBufferDynamic, 0.5f},
+            {vk::DescriptorType::eStorageBuffer,        1.0f},
+            {vk::DescriptorType::eCombinedImageSampler, 2.0f},
+            {vk::DescriptorType::eSampledImage,         1.0f},
+            {vk::DescriptorType::eStorageImage,         0.5f}};
+
+    /**
+     * \brief Owns descriptor set layouts and hands out the same layout for identical binding lists.
+     *
+     * \details
+     * Pipelines built from the same reflected interface, or from interfaces that happen to agree on a set, end up
+     * sharing one layout object. Bindings are compared by number, type, count and stages, independently of their
+     * order. Immutable samplers are not supported.
+     *
+     * Layouts are usually looked up while creating pipelines, which may happen on any thread, so lookups lock.
+     */
+    class DescriptorLayoutCache
+    {
+    private:
+        using LayoutKey = vector<std::tuple<uint32_t, vk::DescriptorType, uint32_t, VkShaderStageFlags>>;
+
+        vk::Device device;
+        std::mutex mutex;
+        std::map<LayoutKey, vk::UniqueDescriptorSetLayout> layouts;
+
+    public:
+        explicit DescriptorLayoutCache(const vk::Device &device);
+
+        /**
+         * \brief Returns the layout for the bindings, creating it on first use. It lives as long as the cache.
+         */
+        [[nodiscard]] vk::DescriptorSetLayout get(const vector<vk::DescriptorSetLayoutBinding> &bindings);
+
+        [[nodiscard]] size_t size();
+    };
+
+    /**
+     * \brief Allocates descriptor sets from growable chains of pools.
+     *
+     * \details
+     * Transient sets are only valid for the frame in flight they were allocated in. Every frame slot has its own
+     * pool chain, which beginFrame() resets as a whole with vkResetDescriptorPool, so there is no per-set freeing
+     * and no fragmentation. Persistent sets come from a separate chain that is never reset and live as long as the
+     * allocator.
+     *
+     * When a pool runs out, the next one in the chain is used, or a new pool twice the size of the last one is
+     * created. Pools created for a busy frame are kept and reused after the reset, so steady-state frames neither
+     * create pools nor hit eErrorOutOfPoolMemory.
+     *
+     * Every recording thread uses its own slot, like it would use its own command pool. Slots share nothing, so
+     * allocating never takes a lock. Each slot must only be used by one thread at a time.
+     */
+    class DescriptorAllocator
+    {
+    private:
+        /**
+         * \brief Pools of one kind, filled in order. Pools past current are empty or were reset.
+         */
+        struct PoolChain
+        {
+            vector<vk::UniqueDescriptorPool> pools;
+            size_t current = 0u;
+        };
+
+        struct ThreadSlot
+        {
+            vector<PoolChain> frames; /**< Transient sets, indexed by frame in flight */
+            PoolChain persistent;
+        };
+
+        static constexpr uint32_t INITIAL_SETS_PER_POOL = 64u;
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096u;
+
+        vk::Device device;
+        vector<DescriptorPoolRatio> ratios;
+        vector<ThreadSlot> threadSlots;
+        uint32_t frameIndex = 0u;
+
+        [[nodiscard]] vk::UniqueDescriptorPool createPool(uint32_t maxSets) const;
+
+        [[nodiscard]] vk::DescriptorSet allocateFrom(PoolChain &chain, const vk::DescriptorSetLayout &layout);
+
+    public:
+        /**
+         * \param frameCount number of frames in flight, each getting its own transient pools.
+         * \param threadCount number of threads allocating concurrently.
+         * \param ratios descriptors per set of each type that the pools are sized with.
+         */
+        DescriptorAllocator(const vk::Device &device, uint32_t frameCount, uint32_t threadCount = 1u,
+                            vector<DescriptorPoolRatio> ratios = DEFAULT_DESCRIPTOR_POOL_RATIOS);
+
+        /**
+         * \brief Releases the transient sets of the frame slot in every thread slot.
+         * \details Must be called once the slot's previous frame has completed, while no thread is allocating.
+         */
+        void beginFrame(uint32_t frameIndex);
+
+        /**
+         * \brief Allocates a set that is valid until the current frame slot comes around again.
+         */
+        [[nodiscard]] vk::DescriptorSet allocateTransient(const vk::DescriptorSetLayout &layout,
+                                                          uint32_t threadIndex = 0u);
+
+        /**
+         * \brief Allocates a set that lives as long as the allocator.
+         */
+        [[nodiscard]] vk::DescriptorSet allocatePersistent(const vk::DescriptorSetLayout &layout,
+                                                           uint32_t threadIndex = 0u);
+
+        /**
+         * \brief Number of pools created so far across all slots, for diagnostics.
+         */
+        [[nodiscard]] size_t poolCount() const noexcept;
+    };
+}
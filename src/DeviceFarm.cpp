@@ -0,0 +1,192 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "OffscreenRenderer.hpp"
+#include "SoftwareRenderer.hpp"
+#include "DeviceFarm.hpp"
+
+using namespace VkTri;
+
+using Clock = std::chrono::steady_clock;
+
+unique_ptr<DeviceFarm> DeviceFarm::create(const vk::Extent2D &extent, bool enableValidation)
+{
+    auto farm = std::make_unique<DeviceFarm>();
+
+    // A missing loader or driver surfaces as an exception while creating the instance.
+    vector<vk::PhysicalDevice> devices;
+    try
+    {
+        farm->instance = createHeadlessInstance("Vulkan Triangle Device Farm", enableValidation);
+        devices = farm->instance->enumeratePhysicalDevices();
+    }
+    catch (const VulkanUnavailable &err)
+    {
+        std::clog << fmt::format("Vulkan is unavailable: {:s}\n", err.what());
+    }
+
+    for (const auto &device : devices)
+    {
+        auto deviceName = string(device.getProperties().deviceName.data());
+        if (!OffscreenRenderer::isSuitable(device))
+        {
+            std::clog << fmt::format("Skipping unsuitable device: {:s}\n", deviceName);
+            continue;
+        }
+
+        farm->renderers.push_back(OffscreenRenderer::create(device, extent));
+
+        DeviceFarmStats deviceStats;
+        deviceStats.deviceName = deviceName;
+        farm->stats.push_back(deviceStats);
+
+        std::clog << fmt::format("Added device: {:s}\n", deviceName);
+    }
+
+    if (farm->renderers.empty())
+    {
+        farm->renderers.push_back(SoftwareRenderer::create(extent));
+
+        DeviceFarmStats deviceStats;
+        deviceStats.deviceName = farm->renderers.back()->name();
+        farm->stats.push_back(deviceStats);
+
+        std::clog << fmt::format("No suitable Vulkan device, rendering with the {:s}\n", deviceStats.deviceName);
+    }
+
+    return farm;
+}
+
+DeviceFarm::~DeviceFarm()
+{
+    // Logical devices must be gone before the instance is destroyed.
+    this->renderers.clear();
+}
+
+const vector<DeviceFarmStats> &DeviceFarm::getStats() const noexcept
+{
+    return this->stats;
+}
+
+size_t DeviceFarm::deviceCount() const noexcept
+{
+    return this->renderers.size();
+}
+
+uint32_t DeviceFarm::chunkSize(uint32_t deviceIndex) const
+{
+    double fastest = 0.0;
+    for (const auto &deviceStats : this->stats)
+    {
+        fastest = std::max(fastest, deviceStats.framesPerSecond);
+    }
+
+    if (fastest <= 0.0)
+    {
+        return 1u;
+    }
+
+    auto weight = this->stats[deviceIndex].framesPerSecond / fastest;
+    return std::max(1u, static_cast<uint32_t>(weight * BASE_CHUNK_SIZE + 0.5));
+}
+
+void DeviceFarm::calibrate(uint32_t framesPerDevice)
+{
+    vector<uint8_t> scratch;
+    for (uint32_t i = 0; i < this->renderers.size(); i++)
+    {
+        // The first frame includes pipeline and driver warm-up, so it is excluded from the measurement.
+        this->renderers[i]->renderFrame(0, scratch);
+
+        auto start = Clock::now();
+        for (uint32_t frame = 0; frame < framesPerDevice; frame++)
+        {
+            this->renderers[i]->renderFrame(frame, scratch);
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        this->stats[i].framesPerSecond = elapsed.count() > 0.0 ? framesPerDevice / elapsed.count() : 0.0;
+        std::clog << fmt::format("Calibrated {:s}: {:.1f} frames/s\n", this->stats[i].deviceName,
+                                 this->stats[i].framesPerSecond);
+    }
+}
+
+vector<FrameJobResult> DeviceFarm::render(uint64_t jobCount)
+{
+    vector<FrameJobResult> results(jobCount);
+    std::atomic<uint64_t> nextJob(0u);
+    std::mutex statsMutex;
+    std::exception_ptr failure;
+
+    auto worker = [&](uint32_t deviceIndex)
+    {
+        try
+        {
+            auto &renderer = *this->renderers[deviceIndex];
+            while (true)
+            {
+                uint32_t chunk;
+                {
+                    std::lock_guard<std::mutex> lock(statsMutex);
+                    if (failure) return;
+                    chunk = this->chunkSize(deviceIndex);
+                }
+
+                auto first = nextJob.fetch_add(chunk);
+                if (first >= jobCount) return;
+                auto last = std::min(first + chunk, jobCount);
+
+                auto start = Clock::now();
+                for (auto job = first; job < last; job++)
+                {
+                    renderer.renderFrame(job, results[job].pixels);
+                    results[job].jobIndex = job;
+                    results[job].deviceIndex = deviceIndex;
+                }
+                std::chrono::duration<double> elapsed = Clock::now() - start;
+
+                std::lock_guard<std::mutex> lock(statsMutex);
+                auto &deviceStats = this->stats[deviceIndex];
+                deviceStats.jobsRendered += last - first;
+                if (elapsed.count() > 0.0)
+                {
+                    auto sample = (last - first) / elapsed.count();
+                    deviceStats.framesPerSecond = deviceStats.framesPerSecond > 0.0
+                                                  ? (1.0 - THROUGHPUT_SMOOTHING) * deviceStats.framesPerSecond +
+                                                    THROUGHPUT_SMOOTHING * sample
+                                                  : sample;
+                }
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if (!failure) failure = std::current_exception();
+        }
+    };
+
+    vector<std::thread> workers;
+    workers.reserve(this->renderers.size());
+    for (uint32_t i = 0; i < this->renderers.size(); i++)
+    {
+        workers.emplace_back(worker, i);
+    }
+
+    for (auto &thread : workers)
+    {
+        thread.join();
+    }
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+
+    return results;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "FrameRenderer.hpp"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+namespace VkTri
+{
+    /**
+     * \brief Result of a single offscreen frame job.
+     */
+    struct FrameJobResult
+    {
+        uint64_t jobIndex = 0u;
+        uint32_t deviceIndex = 0u; /**< Index of the device which rendered the frame */
+        vector<uint8_t> pixels; /**< RGBA8 pixel data */
+    };
+
+    /**
+     * \brief Per-device statistics gathered during calibration and rendering.
+     */
+    struct DeviceFarmStats
+    {
+        string deviceName;
+        double framesPerSecond = 0.0; /**< Throughput, updated as jobs complete */
+        uint64_t jobsRendered = 0u;
+    };
+
+    /**
+     * \brief Distributes independent offscreen frame jobs across every suitable physical device.
+     *
+     * \details
+     * Each device gets its own logical device and worker thread. Workers pull chunks of jobs from a shared
+     * queue, and the chunk size of each worker is scaled by the measured throughput of its device. Fast devices
+     * take more work per trip while slow devices only ever hold a small amount, which keeps the tail of a batch
+     * short. Results are written into a vector indexed by job, so they come back in order regardless of which
+     * device rendered them.
+     *
+     * Without a Vulkan loader, driver or suitable device, a single SoftwareRenderer renders every job instead.
+     */
+    class DeviceFarm
+    {
+    private:
+        vk::UniqueInstance instance; /**< Null when Vulkan is unavailable */
+        vector<unique_ptr<FrameRenderer>> renderers;
+        vector<DeviceFarmStats> stats;
+
+        static constexpr uint32_t BASE_CHUNK_SIZE = 8u; /**< Chunk size given to the fastest device */
+        static constexpr double THROUGHPUT_SMOOTHING = 0.25; /**< Weight of new samples in the throughput average */
+
+        [[nodiscard]] uint32_t chunkSize(uint32_t deviceIndex) const;
+
+    public:
+        /**
+         * \brief Creates an offscreen renderer on every suitable physical device, or a software one if there is none.
+         * \param extent size of the rendered frames.
+         * \param enableValidation whether the Khronos validation layer should be enabled.
+         */
+        [[nodiscard]] static unique_ptr<DeviceFarm> create(const vk::Extent2D &extent, bool enableValidation);
+
+        ~DeviceFarm();
+
+        /**
+         * \brief Measures the initial throughput of every device.
+         * \param framesPerDevice number of frames rendered on each device for the measurement.
+         */
+        void calibrate(uint32_t framesPerDevice);
+
+        /**
+         * \brief Renders jobCount frames across all devices.
+         * \return one result per job, ordered by job index.
+         */
+        vector<FrameJobResult> render(uint64_t jobCount);
+
+        [[nodiscard]] const vector<DeviceFarmStats> &getStats() const noexcept;
+
+        [[nodiscard]] size_t deviceCount() const noexcept;
+    };
+}
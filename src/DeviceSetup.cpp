@@ -0,0 +1,158 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+
+using namespace VkTri;
+
+void VkTri::loadVulkan()
+{
+    // The loader must stay resident for as long as any instance lives, so it is kept in static storage.
+    static std::unique_ptr<vk::DynamicLoader> dynaLoader;
+    if (!dynaLoader)
+    {
+        const char *libraryName = std::getenv("VK_TRI_VULKAN_LIBRARY");
+        try
+        {
+            dynaLoader = std::make_unique<vk::DynamicLoader>(libraryName != nullptr ? libraryName : "");
+        }
+        catch (const std::runtime_error &err)
+        {
+            throw VulkanUnavailable(fmt::format("Failed to load the Vulkan loader: {:s}", err.what()));
+        }
+    }
+
+    auto vkGetInstanceProcAddr = dynaLoader->getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
+    if (vkGetInstanceProcAddr == nullptr)
+    {
+        throw VulkanUnavailable("The Vulkan loader does not export vkGetInstanceProcAddr.");
+    }
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+}
+
+vk::UniqueInstance VkTri::createHeadlessInstance(const char *appName, bool enableValidation)
+{
+    loadVulkan();
+
+    vk::ApplicationInfo appInfo;
+    appInfo.pApplicationName = appName;
+    appInfo.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    const vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
+    vector<const char *> extensions;
+
+    vk::InstanceCreateInfo createInfo;
+    createInfo.pApplicationInfo = &appInfo;
+
+    if (enableValidation)
+    {
+        bool layerFound = false;
+        for (const auto &layerProps : vk::enumerateInstanceLayerProperties())
+        {
+            if (strncmp(validationLayers[0], layerProps.layerName, 255) == 0)
+            {
+                layerFound = true;
+                break;
+            }
+        }
+
+        if (layerFound)
+        {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+        }
+        else
+        {
+            std::clog << "Validation layers requested but not available, continuing without them.\n";
+        }
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+
+    vk::UniqueInstance instance;
+    try
+    {
+        instance = vk::createInstanceUnique(createInfo);
+    }
+    catch (const vk::SystemError &err)
+    {
+        // Typically eErrorIncompatibleDriver, when the loader finds no driver.
+        throw VulkanUnavailable(fmt::format("Failed to create a Vulkan instance: {:s}", err.what()));
+    }
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(*instance);
+
+    return instance;
+}
+
+std::optional<uint32_t> VkTri::findQueueFamily(const vk::PhysicalDevice &device, vk::QueueFlags flags)
+{
+    auto queueFamilies = device.getQueueFamilyProperties();
+
+    for (uint32_t i = 0; i < queueFamilies.size(); i++)
+    {
+        if ((queueFamilies[i].queueFlags & flags) == flags)
+        {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+uint32_t VkTri::findMemoryType(const vk::PhysicalDevice &device, uint32_t typeFilter,
+                               vk::MemoryPropertyFlags properties)
+{
+    auto memProperties = device.getMemoryProperties();
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1u << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find a suitable memory type.");
+}
+
+bool VkTri::hasDeviceExtension(const vk::PhysicalDevice &device, const char *extensionName)
+{
+    for (const auto &ext : device.enumerateDeviceExtensionProperties())
+    {
+        if (strncmp(extensionName, ext.extensionName, VK_MAX_EXTENSION_NAME_SIZE) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+vk::UniqueShaderModule VkTri::loadShaderModule(const vk::Device &device, const fs::path &filePath)
+{
+    auto fileStream = std::ifstream(filePath, std::ios::ate | std::ios::binary);
+    if (!fileStream.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to open file: {:s}", filePath.string()));
+    }
+
+    auto fileSize = static_cast<size_t>(fileStream.tellg());
+    fileStream.seekg(std::ios::beg);
+
+    // SPIR-V is a stream of 32-bit words, so read straight into word storage to keep pCode aligned.
+    vector<uint32_t> code((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    fileStream.read(reinterpret_cast<char *>(code.data()), fileSize);
+
+    vk::ShaderModuleCreateInfo createInfo;
+    createInfo.codeSize = fileSize;
+    createInfo.pCode = code.data();
+
+    return device.createShaderModuleUnique(createInfo);
+}
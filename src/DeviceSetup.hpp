@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    /**
+     * \brief Thrown when this machine cannot run Vulkan at all: no loader, no driver, or no suitable device.
+     *
+     * \details
+     * Callers can catch this to fall back to the software renderer. Any other exception during setup is a bug or a
+     * broken installation, and must not be hidden behind the fallback.
+     */
+    class VulkanUnavailable : public std::runtime_error
+    {
+    public:
+        explicit VulkanUnavailable(const string &message) : std::runtime_error(message)
+        {}
+    };
+
+    /**
+     * \brief Opens the Vulkan loader and initializes the default dispatcher with its vkGetInstanceProcAddr.
+     *
+     * \details
+     * Nothing links against the loader, so executables start on machines without one. The library stays loaded
+     * until the process exits. The environment variable VK_TRI_VULKAN_LIBRARY overrides its name.
+     *
+     * \throws VulkanUnavailable if the loader cannot be opened.
+     */
+    void loadVulkan();
+
+    /**
+     * \brief Creates a Vulkan instance that does not depend on any window system.
+     *
+     * \details
+     * The dynamic dispatcher is initialized against the new instance only. Device level functions are then
+     * resolved through the loader trampolines, which lets several logical devices share the default dispatcher.
+     *
+     * \param appName application name reported to the driver.
+     * \param enableValidation whether the Khronos validation layer should be enabled.
+     * \return the newly created instance.
+     * \throws VulkanUnavailable if there is no loader or no driver.
+     */
+    vk::UniqueInstance createHeadlessInstance(const char *appName, bool enableValidation);
+
+    /**
+     * \brief Finds the first queue family on the device which supports all of the provided flags.
+     * \param device physical Vulkan device to analyze.
+     * \param flags capabilities the queue family must have.
+     * \return index of the queue family, if one exists.
+     */
+    std::optional<uint32_t> findQueueFamily(const vk::PhysicalDevice &device, vk::QueueFlags flags);
+
+    /**
+     * \brief Finds a memory type matching the type filter and the requested properties.
+     * \param device physical Vulkan device the memory will be allocated from.
+     * \param typeFilter bitmask of acceptable memory types, taken from vk::MemoryRequirements.
+     * \param properties required memory property flags.
+     * \return index of the memory type.
+     */
+    uint32_t findMemoryType(const vk::PhysicalDevice &device, uint32_t typeFilter, vk::MemoryPropertyFlags properties);
+
+    /**
+     * \brief Checks if the device advertises the named extension.
+     */
+    bool hasDeviceExtension(const vk::PhysicalDevice &device, const char *extensionName);
+
+    /**
+     * \brief Reads a SPIR-V file from disk and wraps it in a shader module.
+     */
+    vk::UniqueShaderModule loadShaderModule(const vk::Device &device, const fs::path &filePath);
+}
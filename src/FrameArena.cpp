@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "FrameArena.hpp"
+
+using namespace VkTri;
+
+FrameArena::FrameArena(size_t capacity) : block(new std::byte[capacity]), capacity(capacity)
+{
+    this->overflow.reserve(8u);
+}
+
+void *FrameArena::allocateBytes(size_t size, size_t alignment)
+{
+    if (alignment == 0u || (alignment & (alignment - 1u)) != 0u)
+    {
+        throw std::invalid_argument(fmt::format("Alignment {:d} is not a power of two", alignment));
+    }
+
+    auto base = reinterpret_cast<uintptr_t>(this->block.get());
+    auto start = (base + this->offset + alignment - 1u) & ~(alignment - 1u);
+    if (start + size <= base + this->capacity)
+    {
+        this->offset = start + size - base;
+        return reinterpret_cast<void *>(start);
+    }
+
+    // Does not fit, so this frame falls back to the heap. The padding covers the worst case alignment.
+    this->overflow.emplace_back(new std::byte[size + alignment]);
+    this->overflowSize += size + alignment;
+
+    auto overflowBase = reinterpret_cast<uintptr_t>(this->overflow.back().get());
+    return reinterpret_cast<void *>((overflowBase + alignment - 1u) & ~(alignment - 1u));
+}
+
+void FrameArena::reset()
+{
+    if (!this->overflow.empty())
+    {
+        // Room for the whole frame that just ended, with headroom so that slow growth does not reallocate often.
+        this->capacity = std::max(this->capacity * 2u, this->offset + this->overflowSize);
+        this->block.reset(new std::byte[this->capacity]);
+        this->overflow.clear();
+        this->overflowSize = 0u;
+    }
+    this->offset = 0u;
+}
+
+size_t FrameArena::getUsed() const noexcept
+{
+    return this->offset + this->overflowSize;
+}
+
+size_t FrameArena::getCapacity() const noexcept
+{
+    return this->capacity;
+}
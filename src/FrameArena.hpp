@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using std::vector;
+
+namespace VkTri
+{
+    static constexpr size_t FRAME_ARENA_SIZE = 64u * 1024u; /**< Initial capacity of a frame arena in bytes */
+
+    /**
+     * \brief Bump allocator for CPU data that only lives while a frame is recorded, such as barrier arrays.
+     *
+     * \details
+     * Allocating moves an offset forward in one block, and reset() moves it back to the start, so neither touches
+     * the heap. A frame that needs more than the block holds gets extra blocks from the heap. On the next reset()
+     * the block is replaced with one large enough for that frame, so the arena stops allocating after warm-up.
+     *
+     * Objects are never destroyed, so only trivially destructible types can be allocated. Memory from a previous
+     * frame must not be used after reset().
+     */
+    class FrameArena
+    {
+    private:
+        std::unique_ptr<std::byte[]> block;
+        size_t capacity;
+        size_t offset = 0u;
+        vector<std::unique_ptr<std::byte[]>> overflow; /**< Heap blocks of allocations that did not fit */
+        size_t overflowSize = 0u;
+
+        [[nodiscard]] void *allocateBytes(size_t size, size_t alignment);
+
+    public:
+        explicit FrameArena(size_t capacity = FRAME_ARENA_SIZE);
+
+        FrameArena(const FrameArena &) = delete;
+
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        /**
+         * \brief Releases everything allocated since the last reset, growing the block if the frame overflowed.
+         */
+        void reset();
+
+        /**
+         * \brief Allocates count value-initialized objects.
+         */
+        template<typename T>
+        [[nodiscard]] T *allocate(size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+
+            auto *objects = static_cast<T *>(this->allocateBytes(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; i++)
+            {
+                new(objects + i) T();
+            }
+            return objects;
+        }
+
+        /**
+         * \brief Allocates a copy of count objects starting at source.
+         */
+        template<typename T>
+        [[nodiscard]] T *copy(const T *source, size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+
+            auto *objects = static_cast<T *>(this->allocateBytes(sizeof(T) * count, alignof(T)));
+            std::uninitialized_copy(source, source + count, objects);
+            return objects;
+        }
+
+        /**
+         * \brief Bytes allocated since the last reset, including alignment padding and overflow.
+         */
+        [[nodiscard]] size_t getUsed() const noexcept;
+
+        [[nodiscard]] size_t getCapacity() const noexcept;
+    };
+}
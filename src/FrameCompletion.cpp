@@ -0,0 +1,271 @@
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "FrameCompletion.hpp"
+
+using namespace VkTri;
+
+/**
+ * \brief Blocks until the descriptor is readable, or only checks when timeout is 0.
+ */
+static bool pollReadable(int fd, int timeout)
+{
+    pollfd pfd{};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    int result;
+    do
+    {
+        result = poll(&pfd, 1, timeout);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+    {
+        throw std::runtime_error(fmt::format("Failed to poll frame completion descriptor: {:d}", errno));
+    }
+
+    return result > 0;
+}
+
+bool FrameCompletion::isSyncFdSupported(const vk::PhysicalDevice &device)
+{
+    if (!hasDeviceExtension(device, VK_KHR_EXTERNAL_FENCE_FD_EXTENSION_NAME))
+    {
+        return false;
+    }
+
+    vk::PhysicalDeviceExternalFenceInfo fenceInfo(vk::ExternalFenceHandleTypeFlagBits::eSyncFd);
+    auto properties = device.getExternalFenceProperties(fenceInfo);
+    return static_cast<bool>(properties.externalFenceFeatures & vk::ExternalFenceFeatureFlagBits::eExportable);
+}
+
+FrameCompletion::FrameCompletion(const vk::Device &device, uint32_t slotCount, bool syncFd)
+{
+    this->device = device;
+    this->syncFd = syncFd;
+    this->fds.assign(slotCount, -1);
+    this->pending.assign(slotCount, false);
+
+    for (uint32_t i = 0; i < slotCount; i++)
+    {
+        if (syncFd)
+        {
+            vk::ExportFenceCreateInfo exportInfo(vk::ExternalFenceHandleTypeFlagBits::eSyncFd);
+            vk::FenceCreateInfo fenceInfo;
+            fenceInfo.pNext = &exportInfo;
+            this->fences.push_back(device.createFenceUnique(fenceInfo));
+        }
+        else
+        {
+            this->fences.push_back(device.createFenceUnique({}));
+            this->fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (this->fds[i] < 0)
+            {
+                throw std::runtime_error(fmt::format("Failed to create eventfd: {:d}", errno));
+            }
+        }
+    }
+
+    if (!syncFd)
+    {
+        this->waiter = std::thread(&FrameCompletion::waiterLoop, this);
+    }
+}
+
+FrameCompletion::~FrameCompletion()
+{
+    if (this->waiter.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->waitMutex);
+            this->stopping = true;
+        }
+        this->waitCondition.notify_one();
+        this->waiter.join();
+    }
+
+    for (auto fd : this->fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void FrameCompletion::waiterLoop()
+{
+    try
+    {
+        while (true)
+        {
+            uint32_t slot;
+            {
+                std::unique_lock<std::mutex> lock(this->waitMutex);
+                this->waitCondition.wait(lock, [this]
+                { return this->stopping || !this->waitQueue.empty(); });
+
+                // Pending frames are still drained on shutdown, so the fences are idle when they are destroyed.
+                if (this->waitQueue.empty())
+                {
+                    return;
+                }
+
+                slot = this->waitQueue.front();
+                this->waitQueue.pop_front();
+            }
+
+            if (this->device.waitForFences(this->fences[slot].get(), VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+            {
+                throw std::runtime_error("Timed out waiting for a frame in flight.");
+            }
+
+            uint64_t signal = 1u;
+            if (write(this->fds[slot], &signal, sizeof(signal)) != sizeof(signal))
+            {
+                throw std::runtime_error(fmt::format("Failed to signal frame completion eventfd: {:d}", errno));
+            }
+        }
+    }
+    catch (...)
+    {
+        // An exception escaping the thread would terminate the process, so it is handed to the caller instead.
+        {
+            std::lock_guard<std::mutex> lock(this->waitMutex);
+            this->waiterError = std::current_exception();
+        }
+
+        // Wakes anyone polling a slot, so the error surfaces from isComplete() or wait().
+        for (auto fd : this->fds)
+        {
+            uint64_t signal = 1u;
+            [[maybe_unused]] auto written = write(fd, &signal, sizeof(signal));
+        }
+    }
+}
+
+void FrameCompletion::rethrowWaiterError()
+{
+    if (this->syncFd)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->waitMutex);
+    if (this->waiterError)
+    {
+        std::rethrow_exception(this->waiterError);
+    }
+}
+
+vk::Fence FrameCompletion::fenceFor(uint32_t slot)
+{
+    if (this->pending[slot])
+    {
+        throw std::runtime_error(fmt::format("Frame slot {:d} is still in flight.", slot));
+    }
+
+    // Exporting a sync file already reset the fence, the eventfd path has to do it by hand.
+    if (!this->syncFd)
+    {
+        this->device.resetFences(this->fences[slot].get());
+    }
+
+    return this->fences[slot].get();
+}
+
+void FrameCompletion::submitted(uint32_t slot)
+{
+    this->pending[slot] = true;
+
+    if (this->syncFd)
+    {
+        vk::FenceGetFdInfoKHR getFdInfo;
+        getFdInfo.fence = this->fences[slot].get();
+        getFdInfo.handleType = vk::ExternalFenceHandleTypeFlagBits::eSyncFd;
+
+        // -1 is a valid result and means the fence has already signaled.
+        this->fds[slot] = this->device.getFenceFdKHR(getFdInfo);
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->waitMutex);
+            this->waitQueue.push_back(slot);
+        }
+        this->waitCondition.notify_one();
+    }
+}
+
+void FrameCompletion::markComplete(uint32_t slot)
+{
+    if (this->syncFd)
+    {
+        if (this->fds[slot] >= 0)
+        {
+            close(this->fds[slot]);
+            this->fds[slot] = -1;
+        }
+    }
+    else
+    {
+        uint64_t value;
+        if (read(this->fds[slot], &value, sizeof(value)) != sizeof(value))
+        {
+            throw std::runtime_error(fmt::format("Failed to read frame completion eventfd: {:d}", errno));
+        }
+    }
+
+    this->pending[slot] = false;
+}
+
+bool FrameCompletion::isComplete(uint32_t slot)
+{
+    if (!this->pending[slot])
+    {
+        return true;
+    }
+
+    this->rethrowWaiterError();
+
+    if (this->fds[slot] >= 0 && !pollReadable(this->fds[slot], 0))
+    {
+        return false;
+    }
+
+    // The waiter also signals when it fails, which must not pass for completion.
+    this->rethrowWaiterError();
+    this->markComplete(slot);
+    return true;
+}
+
+void FrameCompletion::wait(uint32_t slot)
+{
+    if (!this->pending[slot])
+    {
+        return;
+    }
+
+    this->rethrowWaiterError();
+    if (this->fds[slot] >= 0)
+    {
+        pollReadable(this->fds[slot], -1);
+    }
+
+    this->rethrowWaiterError();
+    this->markComplete(slot);
+}
+
+int FrameCompletion::fd(uint32_t slot) const
+{
+    return this->pending[slot] ? this->fds[slot] : -1;
+}
+
+bool FrameCompletion::usesSyncFd() const noexcept
+{
+    return this->syncFd;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Tracks completion of frames in flight through file descriptors a host event loop can poll.
+     *
+     * \details
+     * With VK_KHR_external_fence_fd, each submission's fence is exported as a sync file. The sync file becomes
+     * readable once the GPU signals the fence. Exporting a sync file resets the fence, so from that point on the
+     * descriptor is the only record of completion.
+     *
+     * Without the extension, each frame slot gets an eventfd instead. A waiter thread blocks on the fences in
+     * submission order and writes to the matching eventfd as each one signals.
+     *
+     * Either way, the descriptor for a slot is readable exactly when the frame last submitted from it is done.
+     */
+    class FrameCompletion
+    {
+    private:
+        vk::Device device;
+        bool syncFd;
+
+        vector<vk::UniqueFence> fences;
+        vector<int> fds; /**< Sync file or eventfd per slot, -1 when a sync file has not been exported */
+        vector<bool> pending; /**< Whether the slot has a submission that has not been observed as complete */
+
+        // eventfd fallback
+        std::thread waiter;
+        std::mutex waitMutex;
+        std::condition_variable waitCondition;
+        std::deque<uint32_t> waitQueue;
+        bool stopping = false;
+        std::exception_ptr waiterError; /**< Failure of the waiter thread, rethrown on the caller's thread */
+
+        void waiterLoop();
+
+        /**
+         * \brief Throws the waiter thread's failure, if it had one. Nothing completes after it failed.
+         */
+        void rethrowWaiterError();
+
+        void markComplete(uint32_t slot);
+
+    public:
+        /**
+         * \brief Checks if the device can export fences as sync files.
+         */
+        [[nodiscard]] static bool isSyncFdSupported(const vk::PhysicalDevice &device);
+
+        /**
+         * \param syncFd whether VK_KHR_external_fence_fd was enabled on the device.
+         */
+        FrameCompletion(const vk::Device &device, uint32_t slotCount, bool syncFd);
+
+        ~FrameCompletion();
+
+        /**
+         * \brief Fence to pass to the submission for the slot. The slot must be complete.
+         */
+        [[nodiscard]] vk::Fence fenceFor(uint32_t slot);
+
+        /**
+         * \brief Must be called right after the slot's fence has been submitted.
+         */
+        void submitted(uint32_t slot);
+
+        /**
+         * \brief Checks, without blocking, if the frame last submitted from the slot has finished.
+         * \throws std::runtime_error if the waiter thread of the eventfd fallback failed.
+         */
+        [[nodiscard]] bool isComplete(uint32_t slot);
+
+        /**
+         * \brief Blocks until the frame last submitted from the slot has finished.
+         * \throws std::runtime_error if the waiter thread of the eventfd fallback failed.
+         */
+        void wait(uint32_t slot);
+
+        /**
+         * \brief Descriptor which becomes readable when the slot completes, or -1 if nothing is pending on it.
+         */
+        [[nodiscard]] int fd(uint32_t slot) const;
+
+        [[nodiscard]] bool usesSyncFd() const noexcept;
+    };
+}
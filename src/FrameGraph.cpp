@@ -0,0 +1,613 @@
+#include <iostream>
+#include <algorithm>
+#include <fmt/format.h>
+#include "FrameGraph.hpp"
+
+using namespace VkTri;
+
+/**
+ * \brief Images that never leave the render pass do not need backing memory on tilers.
+ */
+static bool isAttachmentOnly(vk::ImageUsageFlags usage)
+{
+    auto attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment |
+                           vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                           vk::ImageUsageFlagBits::eInputAttachment;
+    return !(usage & ~vk::ImageUsageFlags(attachmentUsage));
+}
+
+FrameGraph::FrameGraph(const vk::PhysicalDevice &physicalDevice, const vk::Device &device,
+                       MemoryTracker &memoryTracker)
+{
+    this->physicalDevice = physicalDevice;
+    this->device = device;
+    this->memoryTracker = &memoryTracker;
+}
+
+ResourceHandle FrameGraph::createImage(const string &name, vk::Format format, const vk::Extent2D &extent)
+{
+    Resource resource;
+    resource.name = name;
+    resource.format = format;
+    resource.extent = extent;
+
+    this->resources.push_back(std::move(resource));
+    return static_cast<ResourceHandle>(this->resources.size() - 1u);
+}
+
+ResourceHandle FrameGraph::importImage(const string &name, vk::Format format, const vk::Extent2D &extent,
+                                       vk::ImageLayout initialLayout, vk::ImageLayout finalLayout)
+{
+    auto handle = this->createImage(name, format, extent);
+    auto &resource = this->resources[handle];
+    resource.imported = true;
+    resource.importedInitialLayout = initialLayout;
+    resource.importedFinalLayout = finalLayout;
+
+    return handle;
+}
+
+void FrameGraph::setImportedImage(ResourceHandle resource, const vk::Image &image, const vk::ImageView &view)
+{
+    if (!this->resources.at(resource).imported)
+    {
+        throw std::runtime_error(fmt::format("Frame graph resource {:s} is not imported.",
+                                             this->resources[resource].name));
+    }
+
+    this->resources[resource].image = image;
+    this->resources[resource].view = view;
+}
+
+void FrameGraph::markOutput(ResourceHandle resource)
+{
+    this->resources.at(resource).output = true;
+}
+
+void FrameGraph::addPass(const string &name, const vector<PassAccess> &accesses, PassExecutor executor)
+{
+    Pass pass;
+    pass.name = name;
+    pass.accesses = accesses;
+    pass.executor = std::move(executor);
+
+    this->passes.push_back(std::move(pass));
+}
+
+FrameGraph::AccessState FrameGraph::stateFor(ResourceAccess access)
+{
+    AccessState state;
+    switch (access)
+    {
+        case ResourceAccess::ColorAttachmentWrite:
+            state.layout = vk::ImageLayout::eColorAttachmentOptimal;
+            state.stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+            state.access = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+            state.write = true;
+            break;
+        case ResourceAccess::DepthStencilAttachmentWrite:
+            state.layout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+            state.stages = vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                           vk::PipelineStageFlagBits::eLateFragmentTests;
+            state.access = vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                           vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+            state.write = true;
+            break;
+        case ResourceAccess::SampledRead:
+            state.layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+            state.stages = vk::PipelineStageFlagBits::eFragmentShader;
+            state.access = vk::AccessFlagBits::eShaderRead;
+            break;
+        case ResourceAccess::TransferSrc:
+            state.layout = vk::ImageLayout::eTransferSrcOptimal;
+            state.stages = vk::PipelineStageFlagBits::eTransfer;
+            state.access = vk::AccessFlagBits::eTransferRead;
+            break;
+        case ResourceAccess::TransferDst:
+            state.layout = vk::ImageLayout::eTransferDstOptimal;
+            state.stages = vk::PipelineStageFlagBits::eTransfer;
+            state.access = vk::AccessFlagBits::eTransferWrite;
+            state.write = true;
+            break;
+    }
+
+    return state;
+}
+
+vk::ImageUsageFlags FrameGraph::usageFor(ResourceAccess access)
+{
+    switch (access)
+    {
+        case ResourceAccess::ColorAttachmentWrite:
+            return vk::ImageUsageFlagBits::eColorAttachment;
+        case ResourceAccess::DepthStencilAttachmentWrite:
+            return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+        case ResourceAccess::SampledRead:
+            return vk::ImageUsageFlagBits::eSampled;
+        case ResourceAccess::TransferSrc:
+            return vk::ImageUsageFlagBits::eTransferSrc;
+        case ResourceAccess::TransferDst:
+            return vk::ImageUsageFlagBits::eTransferDst;
+    }
+
+    return {};
+}
+
+void FrameGraph::compile()
+{
+    if (this->compiled || this->planned)
+    {
+        throw std::runtime_error("Frame graph has already been compiled.");
+    }
+    if (this->memoryTracker == nullptr)
+    {
+        throw std::runtime_error("Frame graph without a device can only be planned.");
+    }
+
+    this->cullPasses();
+    this->computeLifetimes();
+    this->createTransientImages();
+
+    auto memProperties = this->physicalDevice.getMemoryProperties();
+    this->assignMemorySlots([this, &memProperties](ResourceHandle resource)
+                            { return this->queryMemoryNeeds(resource, memProperties); });
+
+    this->bindTransientMemory();
+    this->computeBarriers();
+    this->compiled = true;
+}
+
+void FrameGraph::plan(const TransientMemoryQuery &memoryNeeds)
+{
+    if (this->compiled || this->planned)
+    {
+        throw std::runtime_error("Frame graph has already been compiled.");
+    }
+
+    this->cullPasses();
+    this->computeLifetimes();
+    this->assignMemorySlots(memoryNeeds);
+    this->computeBarriers();
+    this->planned = true;
+}
+
+void FrameGraph::cullPasses()
+{
+    // Walk backwards from the resources that leave the graph. A pass survives only if something downstream
+    // needs one of the resources it writes, and then everything it reads becomes needed in turn.
+    vector<bool> needed(this->resources.size(), false);
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        needed[i] = this->resources[i].imported || this->resources[i].output;
+    }
+
+    for (auto pass = this->passes.rbegin(); pass != this->passes.rend(); pass++)
+    {
+        bool producesNeeded = false;
+        for (const auto &access : pass->accesses)
+        {
+            if (stateFor(access.access).write && needed[access.resource])
+            {
+                producesNeeded = true;
+                break;
+            }
+        }
+
+        pass->culled = !producesNeeded;
+        if (pass->culled)
+        {
+            std::clog << fmt::format("Frame graph culled pass: {:s}\n", pass->name);
+            continue;
+        }
+
+        for (const auto &access : pass->accesses)
+        {
+            if (!stateFor(access.access).write)
+            {
+                needed[access.resource] = true;
+            }
+        }
+    }
+}
+
+void FrameGraph::computeLifetimes()
+{
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        if (this->passes[i].culled) continue;
+
+        for (const auto &access : this->passes[i].accesses)
+        {
+            auto &resource = this->resources[access.resource];
+            resource.firstPass = std::min(resource.firstPass, i);
+            resource.lastPass = std::max(resource.lastPass, i);
+            resource.usage |= usageFor(access.access);
+        }
+    }
+
+    for (auto &resource : this->resources)
+    {
+        bool isDepth = static_cast<bool>(resource.usage & vk::ImageUsageFlagBits::eDepthStencilAttachment);
+        resource.aspect = isDepth ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+    }
+}
+
+vector<ResourceHandle> FrameGraph::getTransients() const
+{
+    vector<ResourceHandle> transients;
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        if (!this->resources[i].imported && this->resources[i].firstPass != UINT32_MAX)
+        {
+            transients.push_back(i);
+        }
+    }
+
+    // Placing resources in order of first use lets each one reuse a slot freed by an earlier pass.
+    std::stable_sort(transients.begin(), transients.end(), [this](ResourceHandle a, ResourceHandle b)
+    {
+        return this->resources[a].firstPass < this->resources[b].firstPass;
+    });
+
+    return transients;
+}
+
+void FrameGraph::createTransientImages()
+{
+    for (auto handle : this->getTransients())
+    {
+        auto &resource = this->resources[handle];
+
+        vk::ImageCreateInfo imageInfo;
+        imageInfo.imageType = vk::ImageType::e2D;
+        imageInfo.format = resource.format;
+        imageInfo.extent = vk::Extent3D(resource.extent.width, resource.extent.height, 1u);
+        imageInfo.mipLevels = 1u;
+        imageInfo.arrayLayers = 1u;
+        imageInfo.samples = vk::SampleCountFlagBits::e1;
+        imageInfo.tiling = vk::ImageTiling::eOptimal;
+        imageInfo.usage = resource.usage;
+        if (isAttachmentOnly(resource.usage))
+        {
+            imageInfo.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+        }
+        imageInfo.sharingMode = vk::SharingMode::eExclusive;
+        imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+
+        resource.ownedImage = this->device.createImageUnique(imageInfo);
+        resource.image = resource.ownedImage.get();
+    }
+}
+
+TransientMemoryNeeds FrameGraph::queryMemoryNeeds(ResourceHandle resource,
+                                                  const vk::PhysicalDeviceMemoryProperties &memProperties) const
+{
+    TransientMemoryNeeds needs;
+    needs.requirements = this->device.getImageMemoryRequirements(this->resources[resource].image);
+
+    if (isAttachmentOnly(this->resources[resource].usage))
+    {
+        for (uint32_t type = 0; type < memProperties.memoryTypeCount; type++)
+        {
+            if ((needs.requirements.memoryTypeBits & (1u << type)) &&
+                (memProperties.memoryTypes[type].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated))
+            {
+                needs.lazy = true;
+                break;
+            }
+        }
+    }
+
+    return needs;
+}
+
+void FrameGraph::assignMemorySlots(const TransientMemoryQuery &memoryNeeds)
+{
+    for (auto handle : this->getTransients())
+    {
+        auto &resource = this->resources[handle];
+        auto needs = memoryNeeds(handle);
+
+        // Find a slot whose current occupant is finished before this resource is first used.
+        int32_t slotIndex = -1;
+        for (uint32_t s = 0; s < this->memorySlots.size(); s++)
+        {
+            auto &slot = this->memorySlots[s];
+            if (slot.lastPass < resource.firstPass && slot.lazy == needs.lazy &&
+                (slot.memoryTypeBits & needs.requirements.memoryTypeBits) != 0u)
+            {
+                slotIndex = static_cast<int32_t>(s);
+                break;
+            }
+        }
+
+        if (slotIndex < 0)
+        {
+            this->memorySlots.emplace_back();
+            this->memorySlots.back().lazy = needs.lazy;
+            slotIndex = static_cast<int32_t>(this->memorySlots.size() - 1u);
+        }
+
+        auto &slot = this->memorySlots[slotIndex];
+        slot.size = std::max(slot.size, needs.requirements.size);
+        slot.memoryTypeBits &= needs.requirements.memoryTypeBits;
+        slot.lastPass = resource.lastPass;
+        slot.resources.push_back(handle);
+        resource.memorySlot = slotIndex;
+    }
+}
+
+void FrameGraph::bindTransientMemory()
+{
+    for (auto &slot : this->memorySlots)
+    {
+        vk::MemoryRequirements slotRequirements;
+        slotRequirements.size = slot.size;
+        slotRequirements.memoryTypeBits = slot.memoryTypeBits;
+
+        slot.memory = this->memoryTracker->allocate(
+                slotRequirements,
+                slot.lazy ? vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated
+                          : vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal),
+                MemoryCategory::Image);
+
+        // Every resource sits at offset 0, so the largest alignment requirement is met automatically.
+        for (auto handle : slot.resources)
+        {
+            this->device.bindImageMemory(this->resources[handle].image, slot.memory.get(), 0);
+        }
+    }
+
+    auto transients = this->getTransients();
+    for (auto handle : transients)
+    {
+        auto &resource = this->resources[handle];
+
+        vk::ImageViewCreateInfo viewInfo;
+        viewInfo.image = resource.image;
+        viewInfo.viewType = vk::ImageViewType::e2D;
+        viewInfo.format = resource.format;
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(resource.aspect, 0, 1, 0, 1);
+
+        resource.ownedView = this->device.createImageViewUnique(viewInfo);
+        resource.view = resource.ownedView.get();
+    }
+
+    std::clog << fmt::format("Frame graph: {:d} transient image(s) in {:d} memory block(s), {:d} bytes\n",
+                             transients.size(), this->memorySlots.size(), this->getTransientMemorySize());
+}
+
+void FrameGraph::computeBarriers()
+{
+    // The last state of every resource is needed up front: a transient image's first use has to wait for
+    // whichever resource used its memory before it, which for the first occupant is the last one of the
+    // previous frame.
+    vector<AccessState> lastStates(this->resources.size());
+    for (const auto &pass : this->passes)
+    {
+        if (pass.culled) continue;
+
+        for (const auto &access : pass.accesses)
+        {
+            lastStates[access.resource] = stateFor(access.access);
+        }
+    }
+
+    vector<AccessState> current(this->resources.size());
+    vector<bool> touched(this->resources.size(), false);
+
+    this->passBarriers.assign(this->passes.size(), BarrierBatch());
+
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        if (this->passes[i].culled) continue;
+
+        auto &batch = this->passBarriers[i];
+        for (const auto &access : this->passes[i].accesses)
+        {
+            auto &resource = this->resources[access.resource];
+            auto next = stateFor(access.access);
+
+            vk::ImageMemoryBarrier barrier;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.newLayout = next.layout;
+            barrier.dstAccessMask = next.access;
+            barrier.subresourceRange = vk::ImageSubresourceRange(
+                    resource.imported ? vk::ImageAspectFlags(vk::ImageAspectFlagBits::eColor) : resource.aspect,
+                    0, 1, 0, 1);
+            vk::PipelineStageFlags srcStages;
+
+            if (!touched[access.resource])
+            {
+                touched[access.resource] = true;
+                if (resource.imported)
+                {
+                    // Chains with the semaphore wait the caller places on the stage of the first access.
+                    barrier.oldLayout = resource.importedInitialLayout;
+                    srcStages = next.stages;
+                }
+                else
+                {
+                    auto &slot = this->memorySlots[resource.memorySlot];
+                    auto position = std::find(slot.resources.begin(), slot.resources.end(), access.resource);
+                    auto previous = position == slot.resources.begin() ? slot.resources.back() : *(position - 1);
+
+                    barrier.oldLayout = vk::ImageLayout::eUndefined;
+                    srcStages = lastStates[previous].stages;
+                    barrier.srcAccessMask = lastStates[previous].write ? lastStates[previous].access
+                                                                       : vk::AccessFlags();
+                }
+            }
+            else
+            {
+                auto &state = current[access.resource];
+                if (state.layout == next.layout && !state.write && !next.write)
+                {
+                    // Read after read: widen the set of readers a later writer must wait for.
+                    state.stages |= next.stages;
+                    state.access |= next.access;
+                    continue;
+                }
+
+                barrier.oldLayout = state.layout;
+                srcStages = state.stages;
+                barrier.srcAccessMask = state.write ? state.access : vk::AccessFlags();
+            }
+
+            current[access.resource] = next;
+            batch.srcStages |= srcStages;
+            batch.dstStages |= next.stages;
+            batch.barriers.push_back(barrier);
+            batch.resources.push_back(access.resource);
+        }
+    }
+
+    for (uint32_t i = 0; i < this->resources.size(); i++)
+    {
+        const auto &resource = this->resources[i];
+        if (!resource.imported || !touched[i] || current[i].layout == resource.importedFinalLayout) continue;
+
+        vk::ImageMemoryBarrier barrier;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.oldLayout = current[i].layout;
+        barrier.newLayout = resource.importedFinalLayout;
+        barrier.srcAccessMask = current[i].write ? current[i].access : vk::AccessFlags();
+        barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+        this->finalBarriers.srcStages |= current[i].stages;
+        this->finalBarriers.dstStages |= vk::PipelineStageFlagBits::eBottomOfPipe;
+        this->finalBarriers.barriers.push_back(barrier);
+        this->finalBarriers.resources.push_back(i);
+    }
+}
+
+void FrameGraph::recordBarriers(const vk::CommandBuffer &cmd, const BarrierBatch &batch, FrameArena &arena) const
+{
+    if (batch.barriers.empty()) return;
+
+    // The compiled batch stays untouched, imported images are filled in on a per-frame copy.
+    auto count = static_cast<uint32_t>(batch.barriers.size());
+    auto *barriers = arena.copy(batch.barriers.data(), count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        barriers[i].image = this->resources[batch.resources[i]].image;
+    }
+
+    cmd.pipelineBarrier(batch.srcStages, batch.dstStages, {}, nullptr, nullptr,
+                        vk::ArrayProxy<const vk::ImageMemoryBarrier>(count, barriers));
+}
+
+void FrameGraph::execute(const vk::CommandBuffer &cmd, FrameArena &arena,
+                         std::optional<PassQueryRange> passQueries) const
+{
+    if (!this->compiled)
+    {
+        throw std::runtime_error("Frame graph must be compiled before it is executed.");
+    }
+
+    for (const auto &resource : this->resources)
+    {
+        if (resource.imported && !resource.image)
+        {
+            throw std::runtime_error(fmt::format("No image supplied for imported resource {:s}.", resource.name));
+        }
+    }
+
+    auto passCount = static_cast<uint32_t>(this->passes.size());
+    if (passQueries)
+    {
+        cmd.resetQueryPool(passQueries->pool, passQueries->firstQuery, passCount);
+    }
+
+    for (uint32_t i = 0; i < passCount; i++)
+    {
+        if (passQueries)
+        {
+            cmd.beginQuery(passQueries->pool, passQueries->firstQuery + i, {});
+        }
+
+        if (!this->passes[i].culled)
+        {
+            this->recordBarriers(cmd, this->passBarriers[i], arena);
+            this->passes[i].executor(cmd, *this);
+        }
+
+        if (passQueries)
+        {
+            cmd.endQuery(passQueries->pool, passQueries->firstQuery + i);
+        }
+    }
+
+    this->recordBarriers(cmd, this->finalBarriers, arena);
+}
+
+vk::Image FrameGraph::getImage(ResourceHandle resource) const
+{
+    return this->resources.at(resource).image;
+}
+
+vk::ImageView FrameGraph::getImageView(ResourceHandle resource) const
+{
+    return this->resources.at(resource).view;
+}
+
+bool FrameGraph::isPassCulled(const string &name) const
+{
+    for (const auto &pass : this->passes)
+    {
+        if (pass.name == name)
+        {
+            return pass.culled;
+        }
+    }
+
+    return true;
+}
+
+int32_t FrameGraph::getMemorySlot(ResourceHandle resource) const
+{
+    return this->resources.at(resource).memorySlot;
+}
+
+const BarrierBatch &FrameGraph::getPassBarriers(const string &name) const
+{
+    for (uint32_t i = 0; i < this->passes.size(); i++)
+    {
+        if (this->passes[i].name == name)
+        {
+            return this->passBarriers.at(i);
+        }
+    }
+
+    throw std::runtime_error(fmt::format("Frame graph has no pass named {:s}.", name));
+}
+
+const BarrierBatch &FrameGraph::getFinalBarriers() const
+{
+    return this->finalBarriers;
+}
+
+vector<string> FrameGraph::getPassNames() const
+{
+    vector<string> names;
+    names.reserve(this->passes.size());
+    for (const auto &pass : this->passes)
+    {
+        names.push_back(pass.name);
+    }
+
+    return names;
+}
+
+vk::DeviceSize FrameGraph::getTransientMemorySize() const
+{
+    vk::DeviceSize total = 0u;
+    for (const auto &slot : this->memorySlots)
+    {
+        total += slot.size;
+    }
+
+    return total;
+}
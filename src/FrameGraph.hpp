@@ -0,0 +1,279 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <vector>
+#include <string>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "FrameArena.hpp"
+#include "MemoryTracker.hpp"
+
+using std::string;
+using std::vector;
+
+namespace VkTri
+{
+    using ResourceHandle = uint32_t;
+
+    /**
+     * \brief Ways a pass can use an image resource.
+     */
+    enum class ResourceAccess
+    {
+        ColorAttachmentWrite,
+        DepthStencilAttachmentWrite,
+        SampledRead,
+        TransferSrc,
+        TransferDst
+    };
+
+    /**
+     * \brief A single resource use declared by a pass.
+     */
+    struct PassAccess
+    {
+        ResourceHandle resource;
+        ResourceAccess access;
+    };
+
+    /**
+     * \brief Queries execute() wraps the passes in, one per pass in the order they were added.
+     */
+    struct PassQueryRange
+    {
+        vk::QueryPool pool;
+        uint32_t firstQuery;
+    };
+
+    /**
+     * \brief Image barriers recorded together, before a pass or after the last one.
+     */
+    struct BarrierBatch
+    {
+        vk::PipelineStageFlags srcStages;
+        vk::PipelineStageFlags dstStages;
+        vector<vk::ImageMemoryBarrier> barriers;
+        vector<ResourceHandle> resources; /**< Resource of each barrier, used to fill in imported images */
+    };
+
+    /**
+     * \brief Memory a transient image needs. Images only alias when their needs are compatible.
+     */
+    struct TransientMemoryNeeds
+    {
+        vk::MemoryRequirements requirements;
+        bool lazy = false; /**< Whether the image goes into lazily allocated memory */
+    };
+
+    class FrameGraph;
+
+    using TransientMemoryQuery = std::function<TransientMemoryNeeds(ResourceHandle resource)>;
+
+    using PassExecutor = std::function<void(const vk::CommandBuffer &cmd, const FrameGraph &graph)>;
+
+    /**
+     * \brief Orders rendering passes and derives their synchronization from declared resource accesses.
+     *
+     * \details
+     * Passes are executed in the order they are added. Each pass lists the images it reads and writes, and
+     * compile() then does the following:
+     *  - culls passes whose results never reach an imported or output resource.
+     *  - creates the transient images. Images that are only ever used as attachments get eTransientAttachment
+     *    usage and lazily allocated memory when the device offers it, which tile-based GPUs can keep in tile memory.
+     *  - aliases transient images whose lifetimes do not overlap into shared memory blocks.
+     *  - computes the layout transitions and pipeline barriers between passes. Read-after-read in the same layout
+     *    emits nothing.
+     *
+     * Imported images (e.g. swap chain images) are supplied again before each execute() call, because the image
+     * changes from frame to frame while the barriers stay the same.
+     *
+     * plan() does the same as compile() without a device, taking the memory needs of the transient images from the
+     * caller. It lets the culling, aliasing and barriers be checked on the CPU, but a planned graph cannot execute.
+     */
+    class FrameGraph
+    {
+    private:
+        struct AccessState
+        {
+            vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+            vk::PipelineStageFlags stages;
+            vk::AccessFlags access;
+            bool write = false;
+        };
+
+        struct Resource
+        {
+            string name;
+            vk::Format format;
+            vk::Extent2D extent;
+            vk::ImageAspectFlags aspect;
+            vk::ImageUsageFlags usage;
+
+            bool imported = false;
+            bool output = false;
+            vk::ImageLayout importedInitialLayout = vk::ImageLayout::eUndefined;
+            vk::ImageLayout importedFinalLayout = vk::ImageLayout::eUndefined;
+
+            vk::Image image;
+            vk::ImageView view;
+            vk::UniqueImage ownedImage;
+            vk::UniqueImageView ownedView;
+
+            uint32_t firstPass = UINT32_MAX;
+            uint32_t lastPass = 0u;
+            int32_t memorySlot = -1;
+        };
+
+        struct Pass
+        {
+            string name;
+            vector<PassAccess> accesses;
+            PassExecutor executor;
+            bool culled = false;
+        };
+
+        struct MemorySlot
+        {
+            DeviceAllocation memory;
+            vk::DeviceSize size = 0u;
+            uint32_t memoryTypeBits = ~0u;
+            bool lazy = false;
+            uint32_t lastPass = 0u; /**< Last pass of the most recent resource placed in the slot */
+            vector<ResourceHandle> resources;
+        };
+
+        vk::PhysicalDevice physicalDevice;
+        vk::Device device;
+        MemoryTracker *memoryTracker = nullptr; /**< Null for a graph that can only be planned */
+
+        vector<MemorySlot> memorySlots; /**< Declared before the resources so images are destroyed first */
+        vector<Resource> resources;
+        vector<Pass> passes;
+
+        vector<BarrierBatch> passBarriers; /**< Barriers recorded before each pass */
+        BarrierBatch finalBarriers; /**< Transitions of imported images to their final layouts */
+        bool planned = false;
+        bool compiled = false;
+
+        [[nodiscard]] static AccessState stateFor(ResourceAccess access);
+
+        [[nodiscard]] static vk::ImageUsageFlags usageFor(ResourceAccess access);
+
+        void cullPasses();
+
+        void computeLifetimes();
+
+        /**
+         * \brief Graph-owned images that survived culling, in order of first use.
+         */
+        [[nodiscard]] vector<ResourceHandle> getTransients() const;
+
+        void createTransientImages();
+
+        [[nodiscard]] TransientMemoryNeeds queryMemoryNeeds(
+                ResourceHandle resource, const vk::PhysicalDeviceMemoryProperties &memProperties) const;
+
+        /**
+         * \brief Places each transient image in a memory slot, reusing slots whose occupants are no longer in use.
+         */
+        void assignMemorySlots(const TransientMemoryQuery &memoryNeeds);
+
+        void bindTransientMemory();
+
+        void computeBarriers();
+
+        void recordBarriers(const vk::CommandBuffer &cmd, const BarrierBatch &batch, FrameArena &arena) const;
+
+    public:
+        /**
+         * \param memoryTracker tracker transient memory is allocated through. Must outlive the graph.
+         */
+        FrameGraph(const vk::PhysicalDevice &physicalDevice, const vk::Device &device, MemoryTracker &memoryTracker);
+
+        /**
+         * \brief Graph without a device, which can be planned but not compiled.
+         */
+        FrameGraph() = default;
+
+        /**
+         * \brief Declares an image owned by the graph, created on compile().
+         */
+        ResourceHandle createImage(const string &name, vk::Format format, const vk::Extent2D &extent);
+
+        /**
+         * \brief Declares an image owned outside of the graph.
+         * \param initialLayout layout the image is in when the graph starts executing.
+         * \param finalLayout layout the graph leaves the image in.
+         */
+        ResourceHandle importImage(const string &name, vk::Format format, const vk::Extent2D &extent,
+                                   vk::ImageLayout initialLayout, vk::ImageLayout finalLayout);
+
+        /**
+         * \brief Supplies the image and view backing an imported resource for the next execute() call.
+         */
+        void setImportedImage(ResourceHandle resource, const vk::Image &image, const vk::ImageView &view);
+
+        /**
+         * \brief Keeps a graph-owned image, and the passes producing it, alive even if nothing reads it.
+         */
+        void markOutput(ResourceHandle resource);
+
+        void addPass(const string &name, const vector<PassAccess> &accesses, PassExecutor executor);
+
+        /**
+         * \brief Culls passes, allocates and aliases transient images, and computes barriers.
+         * \throws OutOfMemoryBudget if the transient images do not fit the memory budget.
+         */
+        void compile();
+
+        /**
+         * \brief Culls passes, aliases transient images and computes barriers without creating anything.
+         * \param memoryNeeds memory needs of each transient image, which compile() queries from the device.
+         */
+        void plan(const TransientMemoryQuery &memoryNeeds);
+
+        /**
+         * \brief Records every live pass, along with its barriers, into the command buffer.
+         * \param arena frame arena the barrier arrays are built in, so recording does not touch the heap.
+         * \param passQueries queries to reset and wrap each pass in. Culled passes get an empty query, so every
+         * query of the range has a result.
+         */
+        void execute(const vk::CommandBuffer &cmd, FrameArena &arena,
+                     std::optional<PassQueryRange> passQueries = std::nullopt) const;
+
+        [[nodiscard]] vk::Image getImage(ResourceHandle resource) const;
+
+        [[nodiscard]] vk::ImageView getImageView(ResourceHandle resource) const;
+
+        [[nodiscard]] bool isPassCulled(const string &name) const;
+
+        /**
+         * \brief Memory slot of a transient image, -1 for imported and unused images. Images sharing a slot alias.
+         */
+        [[nodiscard]] int32_t getMemorySlot(ResourceHandle resource) const;
+
+        /**
+         * \brief Barriers recorded before the named pass, empty if it was culled.
+         */
+        [[nodiscard]] const BarrierBatch &getPassBarriers(const string &name) const;
+
+        /**
+         * \brief Barriers recorded after the last pass, moving imported images to their final layouts.
+         */
+        [[nodiscard]] const BarrierBatch &getFinalBarriers() const;
+
+        /**
+         * \brief Names of all passes, culled or not, in execution order.
+         */
+        [[nodiscard]] vector<string> getPassNames() const;
+
+        /**
+         * \brief Total device memory allocated for transient images after aliasing.
+         */
+        [[nodiscard]] vk::DeviceSize getTransientMemorySize() const;
+    };
+}
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cmath>
+#include "FrameRenderer.hpp"
+
+using namespace VkTri;
+
+std::array<uint8_t, 4> FrameRenderer::jobClearColor(uint64_t jobIndex)
+{
+    return {static_cast<uint8_t>(jobIndex & 0xFFu), static_cast<uint8_t>((jobIndex >> 8u) & 0xFFu), 0x40u, 0xFFu};
+}
+
+DrawConstants FrameRenderer::gridCell(uint32_t triangles, uint32_t index)
+{
+    auto gridSize = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangles)))), 1u);
+    auto column = static_cast<float>(index % gridSize);
+    auto row = static_cast<float>(index / gridSize);
+
+    DrawConstants constants;
+    constants.scale = glm::vec2(1.0f / static_cast<float>(gridSize));
+    constants.offset = glm::vec2((column + 0.5f) * 2.0f, (row + 0.5f) * 2.0f) * constants.scale - 1.0f;
+    return constants;
+}
+
+void FrameRenderer::buildOverlay(const SceneDescription &scene, const vk::Extent2D &extent, uint64_t jobIndex,
+                                 Batcher2D &overlay)
+{
+    overlay.begin();
+
+    auto width = static_cast<float>(extent.width);
+    auto height = static_cast<float>(extent.height);
+
+    for (uint32_t i = 0; i < scene.quads; i++)
+    {
+        // Deterministic scatter, drifting by a pixel per frame so every frame differs.
+        auto x = std::fmod(static_cast<float>(i * 37u + jobIndex), width);
+        auto y = std::fmod(static_cast<float>(i * 61u) + static_cast<float>(i / 7u), height);
+        auto layer = static_cast<uint16_t>(i % scene.layers);
+        auto pipeline = i % 5u == 0u ? Pipeline2D::Additive : Pipeline2D::Solid;
+        auto shade = static_cast<float>(layer + 1u) / static_cast<float>(scene.layers);
+        glm::vec4 color(shade, 0.5f, 0.25f, 0.5f);
+
+        overlay.addRect(layer, pipeline, 0, glm::vec2(x, y), glm::vec2(x + 6.0f, y + 6.0f), color);
+    }
+
+    overlay.end();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+#include <string>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "TrianglePipeline.hpp"
+#include "Batcher2D.hpp"
+#include "SceneDescription.hpp"
+#include "PipelineStatistics.hpp"
+
+using std::string;
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Backend-independent interface of a renderer that draws a scene into RGBA8 frames in host memory.
+     *
+     * \details
+     * OffscreenRenderer implements it on a Vulkan device and SoftwareRenderer on the CPU. Both draw the same
+     * scene from the helpers below, so their frames can be compared pixel by pixel.
+     */
+    class FrameRenderer
+    {
+    protected:
+        /**
+         * \brief Draw constants of a triangle shrunk into its cell of a square grid.
+         *
+         * \details
+         * A single triangle fills the whole frame.
+         *
+         * \param triangles number of triangles in the grid.
+         * \param index index of the triangle, cells are filled row by row.
+         */
+        [[nodiscard]] static DrawConstants gridCell(uint32_t triangles, uint32_t index);
+
+        /**
+         * \brief Fills the batch with the scene's quads, moving them a little every frame.
+         */
+        static void buildOverlay(const SceneDescription &scene, const vk::Extent2D &extent, uint64_t jobIndex,
+                                 Batcher2D &overlay);
+
+    public:
+        virtual ~FrameRenderer() = default;
+
+        /**
+         * \brief Renders one frame and copies its RGBA8 pixels into the provided vector.
+         *
+         * \details
+         * The clear color and the triangle's rotation are derived from the job index, so every frame is
+         * distinguishable once aggregated.
+         * This call blocks until the frame is complete.
+         */
+        virtual void renderFrame(uint64_t jobIndex, vector<uint8_t> &pixels) = 0;
+
+        /**
+         * \brief Replaces the workload of subsequent frames. The scene's extent is ignored.
+         */
+        virtual void setScene(const SceneDescription &scene) = 0;
+
+        /**
+         * \brief GPU time of the last frame, if the backend can measure it.
+         */
+        [[nodiscard]] virtual std::optional<double> lastGpuFrameMs() const noexcept = 0;
+
+        /**
+         * \brief Pipeline statistics of the last frame's render pass, or null if the backend has none.
+         */
+        [[nodiscard]] virtual const PipelineStatistics *getPipelineStatistics() const noexcept = 0;
+
+        [[nodiscard]] virtual string name() const = 0;
+
+        [[nodiscard]] virtual size_t frameSize() const noexcept = 0;
+
+        /**
+         * \brief Clear color used for the provided job, packed as RGBA8.
+         */
+        [[nodiscard]] static std::array<uint8_t, 4> jobClearColor(uint64_t jobIndex);
+    };
+}
@@ -0,0 +1,213 @@
+#include <sstream>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "MemoryTracker.hpp"
+
+using namespace VkTri;
+
+static const std::array<const char *, static_cast<size_t>(MemoryCategory::Count)> CATEGORY_NAMES = {
+        "buffers", "images", "staging"
+};
+
+// =================
+// Device Allocation
+// =================
+
+DeviceAllocation::DeviceAllocation(DeviceAllocation &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+DeviceAllocation &DeviceAllocation::operator=(DeviceAllocation &&other) noexcept
+{
+    if (this != &other)
+    {
+        this->reset();
+        this->memory = std::move(other.memory);
+        this->tracker = other.tracker;
+        this->heapIndex = other.heapIndex;
+        this->size = other.size;
+        this->category = other.category;
+        other.tracker = nullptr;
+    }
+
+    return *this;
+}
+
+DeviceAllocation::~DeviceAllocation()
+{
+    this->reset();
+}
+
+void DeviceAllocation::reset()
+{
+    this->memory.reset();
+    if (this->tracker != nullptr)
+    {
+        this->tracker->release(this->heapIndex, this->size, this->category);
+        this->tracker = nullptr;
+    }
+}
+
+const vk::DeviceMemory &DeviceAllocation::get() const noexcept
+{
+    return this->memory.get();
+}
+
+DeviceAllocation::operator bool() const noexcept
+{
+    return static_cast<bool>(this->memory);
+}
+
+// ==============
+// Memory Tracker
+// ==============
+
+MemoryTracker::MemoryTracker(const vk::PhysicalDevice &physicalDevice, const vk::Device &device,
+                             bool budgetExtension)
+{
+    this->physicalDevice = physicalDevice;
+    this->device = device;
+    this->budgetExtension = budgetExtension;
+    this->memProperties = physicalDevice.getMemoryProperties();
+    this->trackedHeapUsage.assign(this->memProperties.memoryHeapCount, 0u);
+}
+
+bool MemoryTracker::isBudgetExtensionSupported(const vk::PhysicalDevice &device)
+{
+    return hasDeviceExtension(device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+}
+
+vector<HeapBudget> MemoryTracker::queryHeaps() const
+{
+    vector<HeapBudget> heaps(this->memProperties.memoryHeapCount);
+
+    if (this->budgetExtension)
+    {
+        auto chain = this->physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const auto &budgetProps = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+        for (uint32_t i = 0; i < heaps.size(); i++)
+        {
+            heaps[i].budget = budgetProps.heapBudget[i];
+            heaps[i].usage = budgetProps.heapUsage[i];
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < heaps.size(); i++)
+        {
+            heaps[i].budget = static_cast<vk::DeviceSize>(this->memProperties.memoryHeaps[i].size *
+                                                          FALLBACK_BUDGET_FRACTION);
+            heaps[i].usage = this->trackedHeapUsage[i];
+        }
+    }
+
+    for (uint32_t i = 0; i < heaps.size(); i++)
+    {
+        heaps[i].size = this->memProperties.memoryHeaps[i].size;
+        heaps[i].tracked = this->trackedHeapUsage[i];
+        heaps[i].deviceLocal = static_cast<bool>(this->memProperties.memoryHeaps[i].flags &
+                                                 vk::MemoryHeapFlagBits::eDeviceLocal);
+    }
+
+    return heaps;
+}
+
+bool MemoryTracker::fitsBudget(uint32_t memoryTypeIndex, vk::DeviceSize size) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto heapIndex = this->memProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    auto heap = this->queryHeaps()[heapIndex];
+    return heap.usage + size <= heap.budget;
+}
+
+DeviceAllocation MemoryTracker::allocate(const vk::MemoryRequirements &requirements,
+                                         vk::MemoryPropertyFlags properties, MemoryCategory category)
+{
+    auto typeIndex = findMemoryType(this->physicalDevice, requirements.memoryTypeBits, properties);
+    auto heapIndex = this->memProperties.memoryTypes[typeIndex].heapIndex;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto heap = this->queryHeaps()[heapIndex];
+    if (heap.usage + requirements.size > heap.budget)
+    {
+        throw OutOfMemoryBudget(fmt::format("Allocating {:d} bytes of {:s} would exceed the budget of heap {:d} "
+                                            "({:d} of {:d} bytes in use).", requirements.size,
+                                            CATEGORY_NAMES[static_cast<size_t>(category)], heapIndex, heap.usage,
+                                            heap.budget));
+    }
+
+    vk::MemoryAllocateInfo allocInfo;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = typeIndex;
+
+    DeviceAllocation allocation;
+    try
+    {
+        allocation.memory = this->device.allocateMemoryUnique(allocInfo);
+    }
+    catch (const vk::OutOfDeviceMemoryError &err)
+    {
+        // The budget is only a hint, so the driver can still refuse. Report it the same way.
+        throw OutOfMemoryBudget(err.what());
+    }
+
+    allocation.tracker = this;
+    allocation.heapIndex = heapIndex;
+    allocation.size = requirements.size;
+    allocation.category = category;
+
+    this->trackedHeapUsage[heapIndex] += requirements.size;
+    this->categoryBytes[static_cast<size_t>(category)] += requirements.size;
+    this->categoryAllocations[static_cast<size_t>(category)]++;
+
+    return allocation;
+}
+
+void MemoryTracker::release(uint32_t heapIndex, vk::DeviceSize size, MemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->trackedHeapUsage[heapIndex] -= size;
+    this->categoryBytes[static_cast<size_t>(category)] -= size;
+    this->categoryAllocations[static_cast<size_t>(category)]--;
+}
+
+MemoryStats MemoryTracker::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    MemoryStats stats;
+    stats.budgetExtension = this->budgetExtension;
+    stats.heaps = this->queryHeaps();
+    stats.categoryBytes = this->categoryBytes;
+    stats.categoryAllocations = this->categoryAllocations;
+
+    return stats;
+}
+
+string MemoryTracker::format(const MemoryStats &stats)
+{
+    std::ostringstream out;
+    out << fmt::format("Memory ({:s}):\n", stats.budgetExtension ? "VK_EXT_memory_budget" : "estimated budget");
+
+    for (uint32_t i = 0; i < stats.heaps.size(); i++)
+    {
+        const auto &heap = stats.heaps[i];
+        out << fmt::format("\tHeap {:d}{:s}: {:.1f} / {:.1f} MiB used, {:.1f} MiB ours, {:.1f} MiB total\n", i,
+                           heap.deviceLocal ? " (device local)" : "", heap.usage / 1048576.0,
+                           heap.budget / 1048576.0, heap.tracked / 1048576.0, heap.size / 1048576.0);
+    }
+
+    for (size_t i = 0; i < CATEGORY_NAMES.size(); i++)
+    {
+        out << fmt::format("\t{:s}: {:d} allocation(s), {:.1f} MiB\n", CATEGORY_NAMES[i],
+                           stats.categoryAllocations[i], stats.categoryBytes[i] / 1048576.0);
+    }
+
+    return out.str();
+}
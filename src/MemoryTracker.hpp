@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::string;
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief What an allocation is used for, for accounting purposes.
+     */
+    enum class MemoryCategory : uint32_t
+    {
+        Buffer,
+        Image,
+        Staging,
+        Count
+    };
+
+    /**
+     * \brief Usage and budget of a single memory heap.
+     */
+    struct HeapBudget
+    {
+        vk::DeviceSize size = 0u; /**< Total size of the heap */
+        vk::DeviceSize budget = 0u; /**< Amount this process can allocate without hurting others */
+        vk::DeviceSize usage = 0u; /**< Amount in use, by this process when the budget extension is present */
+        vk::DeviceSize tracked = 0u; /**< Amount allocated through the tracker */
+        bool deviceLocal = false;
+    };
+
+    /**
+     * \brief Snapshot of heap budgets and of the tracker's own allocations.
+     */
+    struct MemoryStats
+    {
+        bool budgetExtension = false; /**< Whether the budgets come from VK_EXT_memory_budget or are estimates */
+        vector<HeapBudget> heaps;
+        std::array<vk::DeviceSize, static_cast<size_t>(MemoryCategory::Count)> categoryBytes{};
+        std::array<uint32_t, static_cast<size_t>(MemoryCategory::Count)> categoryAllocations{};
+    };
+
+    /**
+     * \brief Thrown when an allocation would push a heap past its budget.
+     *
+     * \details
+     * Callers can catch this to fall back to smaller resources, instead of running into
+     * vk::Result::eErrorOutOfDeviceMemory or pushing other processes out of video memory.
+     */
+    class OutOfMemoryBudget : public std::runtime_error
+    {
+    public:
+        explicit OutOfMemoryBudget(const string &message) : std::runtime_error(message)
+        {}
+    };
+
+    class MemoryTracker;
+
+    /**
+     * \brief Device memory allocated through a MemoryTracker. Frees its accounting along with the memory.
+     */
+    class DeviceAllocation
+    {
+    private:
+        vk::UniqueDeviceMemory memory;
+        MemoryTracker *tracker = nullptr;
+        uint32_t heapIndex = 0u;
+        vk::DeviceSize size = 0u;
+        MemoryCategory category = MemoryCategory::Buffer;
+
+        friend class MemoryTracker;
+
+    public:
+        DeviceAllocation() = default;
+
+        DeviceAllocation(DeviceAllocation &&other) noexcept;
+
+        DeviceAllocation &operator=(DeviceAllocation &&other) noexcept;
+
+        ~DeviceAllocation();
+
+        void reset();
+
+        [[nodiscard]] const vk::DeviceMemory &get() const noexcept;
+
+        explicit operator bool() const noexcept;
+    };
+
+    /**
+     * \brief Tracks device memory per category and checks allocations against the heap budgets.
+     *
+     * \details
+     * When VK_EXT_memory_budget is enabled, the budgets come from the driver and account for every process on
+     * the machine. Otherwise each heap is given a fixed fraction of its size and only the tracker's own allocations
+     * count against it.
+     */
+    class MemoryTracker
+    {
+    private:
+        vk::PhysicalDevice physicalDevice;
+        vk::Device device;
+        bool budgetExtension;
+        vk::PhysicalDeviceMemoryProperties memProperties;
+
+        mutable std::mutex mutex;
+        vector<vk::DeviceSize> trackedHeapUsage;
+        std::array<vk::DeviceSize, static_cast<size_t>(MemoryCategory::Count)> categoryBytes{};
+        std::array<uint32_t, static_cast<size_t>(MemoryCategory::Count)> categoryAllocations{};
+
+        static constexpr double FALLBACK_BUDGET_FRACTION = 0.8; /**< Budget of each heap without the extension */
+
+        friend class DeviceAllocation;
+
+        void release(uint32_t heapIndex, vk::DeviceSize size, MemoryCategory category);
+
+        [[nodiscard]] vector<HeapBudget> queryHeaps() const;
+
+    public:
+        /**
+         * \param budgetExtension whether VK_EXT_memory_budget was enabled on the device.
+         */
+        MemoryTracker(const vk::PhysicalDevice &physicalDevice, const vk::Device &device, bool budgetExtension);
+
+        /**
+         * \brief Checks if the device supports VK_EXT_memory_budget.
+         */
+        [[nodiscard]] static bool isBudgetExtensionSupported(const vk::PhysicalDevice &device);
+
+        /**
+         * \brief Allocates memory of a matching type, after checking the allocation fits the heap's budget.
+         * \throws OutOfMemoryBudget if the allocation would exceed the budget.
+         */
+        [[nodiscard]] DeviceAllocation allocate(const vk::MemoryRequirements &requirements,
+                                                vk::MemoryPropertyFlags properties, MemoryCategory category);
+
+        /**
+         * \brief Checks if an allocation of the given size from the memory type would fit the heap's budget.
+         */
+        [[nodiscard]] bool fitsBudget(uint32_t memoryTypeIndex, vk::DeviceSize size) const;
+
+        [[nodiscard]] MemoryStats snapshot() const;
+
+        /**
+         * \brief Formats a snapshot for logging.
+         */
+        [[nodiscard]] static string format(const MemoryStats &stats);
+    };
+}
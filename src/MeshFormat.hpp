@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VkTri
+{
+    static constexpr uint32_t MESH_FILE_MAGIC = 0x4D544B56u; /**< "VKTM" read as a little endian word */
+    static constexpr uint32_t MESH_FILE_VERSION = 1u;
+
+    static constexpr uint32_t MESHLET_MAX_VERTICES = 64u; /**< Default vertex limit of a meshlet */
+    static constexpr uint32_t MESHLET_MAX_TRIANGLES = 124u; /**< Default triangle limit of a meshlet */
+
+    /**
+     * \brief Vertex of a preprocessed mesh.
+     */
+    struct MeshVertex
+    {
+        float position[3];
+        float normal[3];
+        float uv[2];
+    };
+
+    /**
+     * \brief Start of a .vkmesh file, as written by tools/mesh_optimizer.
+     *
+     * \details
+     * The header is followed by these arrays, tightly packed in this order:
+     *  - vertexCount MeshVertex, ordered by first use.
+     *  - indexCount uint32_t triangle list indices, ordered for the post-transform cache and for overdraw.
+     *  - meshletCount Meshlet.
+     *  - meshletVertexCount uint32_t, the mesh vertices each meshlet references.
+     *  - meshletTriangleCount * 3 uint8_t, triangles as indices into the meshlet's own vertex range.
+     */
+    struct MeshFileHeader
+    {
+        uint32_t magic = MESH_FILE_MAGIC;
+        uint32_t version = MESH_FILE_VERSION;
+        uint32_t vertexCount = 0u;
+        uint32_t indexCount = 0u;
+        uint32_t meshletCount = 0u;
+        uint32_t meshletVertexCount = 0u;
+        uint32_t meshletTriangleCount = 0u;
+    };
+
+    /**
+     * \brief Small cluster of triangles with the bounds needed to cull it as a whole.
+     *
+     * \details
+     * A meshlet whose triangles all face away from the camera can be skipped when
+     * dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff. Meshlets whose triangles face too many
+     * directions get a cutoff of 1, which never culls.
+     */
+    struct Meshlet
+    {
+        uint32_t vertexOffset; /**< First entry in the meshlet vertex array */
+        uint32_t triangleOffset; /**< First triangle in the meshlet triangle array */
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+        float center[3]; /**< Bounding sphere */
+        float radius;
+        float coneApex[3];
+        float coneCutoff; /**< Sine of the cone's half angle */
+        float coneAxis[3];
+        float padding;
+    };
+
+    static_assert(sizeof(MeshVertex) == 32u, "MeshVertex must stay tightly packed");
+    static_assert(sizeof(Meshlet) == 64u, "Meshlet must stay tightly packed");
+}
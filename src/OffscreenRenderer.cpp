@@ -0,0 +1,407 @@
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "OffscreenRenderer.hpp"
+
+using namespace VkTri;
+
+bool OffscreenRenderer::isSuitable(const vk::PhysicalDevice &device)
+{
+    if (!findQueueFamily(device, vk::QueueFlagBits::eGraphics).has_value())
+    {
+        return false;
+    }
+
+    // The color target is both rendered to and copied from.
+    auto formatProps = device.getFormatProperties(colorFormat);
+    auto required = vk::FormatFeatureFlagBits::eColorAttachment | vk::FormatFeatureFlagBits::eTransferSrc;
+    return (formatProps.optimalTilingFeatures & required) == required;
+}
+
+unique_ptr<OffscreenRenderer> OffscreenRenderer::create(const vk::PhysicalDevice &device, const vk::Extent2D &extent)
+{
+    auto renderer = std::make_unique<OffscreenRenderer>();
+    renderer->physicalDevice = device;
+    renderer->extent = extent;
+
+    renderer->createLogicalDevice();
+    renderer->createColorTarget();
+    renderer->createReadbackBuffer();
+    renderer->createRenderPass();
+    renderer->createPipeline();
+    renderer->createCommands();
+    renderer->createTimestampPool();
+
+    if (renderer->pipelineStatisticsSupported)
+    {
+        renderer->pipelineStatistics = std::make_unique<PipelineStatistics>(renderer->logicalDevice.get(), 1u,
+                                                                            vector<string>{"scene"});
+    }
+
+    return renderer;
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    if (this->logicalDevice)
+    {
+        this->logicalDevice->waitIdle();
+    }
+}
+
+string OffscreenRenderer::name() const
+{
+    return string(this->physicalDevice.getProperties().deviceName.data());
+}
+
+MemoryStats OffscreenRenderer::getMemoryStats() const
+{
+    return this->memoryTracker->snapshot();
+}
+
+size_t OffscreenRenderer::frameSize() const noexcept
+{
+    return static_cast<size_t>(this->extent.width) * this->extent.height * 4u;
+}
+
+void OffscreenRenderer::createLogicalDevice()
+{
+    this->graphicsFamily = findQueueFamily(this->physicalDevice, vk::QueueFlagBits::eGraphics).value();
+
+    float queuePriority = 1.0f;
+    vk::DeviceQueueCreateInfo queueCreateInfo;
+    queueCreateInfo.queueFamilyIndex = this->graphicsFamily;
+    queueCreateInfo.queueCount = 1u;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    auto deviceFeatures = vk::PhysicalDeviceFeatures();
+    this->pipelineStatisticsSupported = PipelineStatistics::isSupported(this->physicalDevice);
+    deviceFeatures.pipelineStatisticsQuery = this->pipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+
+    vector<const char *> extensions;
+    bool budgetSupported = MemoryTracker::isBudgetExtensionSupported(this->physicalDevice);
+    if (budgetSupported)
+    {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    vk::DeviceCreateInfo createInfo;
+    createInfo.queueCreateInfoCount = 1u;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+    createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+
+    // The default dispatcher is deliberately not re-initialized with this device: several devices share it,
+    // so device functions keep going through the loader trampolines.
+    this->logicalDevice = this->physicalDevice.createDeviceUnique(createInfo);
+    this->graphicsQueue = this->logicalDevice->getQueue(this->graphicsFamily, 0);
+
+    this->memoryTracker = std::make_unique<MemoryTracker>(this->physicalDevice, this->logicalDevice.get(),
+                                                          budgetSupported);
+}
+
+void OffscreenRenderer::createColorTarget()
+{
+    vk::ImageCreateInfo imageInfo;
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = colorFormat;
+    imageInfo.extent = vk::Extent3D(this->extent.width, this->extent.height, 1u);
+    imageInfo.mipLevels = 1u;
+    imageInfo.arrayLayers = 1u;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+    imageInfo.sharingMode = vk::SharingMode::eExclusive;
+    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+
+    this->colorImage = this->logicalDevice->createImageUnique(imageInfo);
+
+    auto requirements = this->logicalDevice->getImageMemoryRequirements(this->colorImage.get());
+    this->colorMemory = this->memoryTracker->allocate(requirements, vk::MemoryPropertyFlagBits::eDeviceLocal,
+                                                      MemoryCategory::Image);
+    this->logicalDevice->bindImageMemory(this->colorImage.get(), this->colorMemory.get(), 0);
+
+    vk::ImageViewCreateInfo viewInfo;
+    viewInfo.image = this->colorImage.get();
+    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.format = colorFormat;
+    viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    this->colorView = this->logicalDevice->createImageViewUnique(viewInfo);
+}
+
+void OffscreenRenderer::createReadbackBuffer()
+{
+    vk::BufferCreateInfo bufferInfo;
+    bufferInfo.size = this->frameSize();
+    bufferInfo.usage = vk::BufferUsageFlagBits::eTransferDst;
+    bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+    this->readbackBuffer = this->logicalDevice->createBufferUnique(bufferInfo);
+
+    auto requirements = this->logicalDevice->getBufferMemoryRequirements(this->readbackBuffer.get());
+    this->readbackMemory = this->memoryTracker->allocate(requirements,
+                                                         vk::MemoryPropertyFlagBits::eHostVisible |
+                                                         vk::MemoryPropertyFlagBits::eHostCoherent,
+                                                         MemoryCategory::Staging);
+    this->logicalDevice->bindBufferMemory(this->readbackBuffer.get(), this->readbackMemory.get(), 0);
+
+    this->readbackData = static_cast<const uint8_t *>(
+            this->logicalDevice->mapMemory(this->readbackMemory.get(), 0, VK_WHOLE_SIZE));
+}
+
+void OffscreenRenderer::createRenderPass()
+{
+    vk::AttachmentDescription colorAttachment;
+    colorAttachment.format = colorFormat;
+    colorAttachment.samples = vk::SampleCountFlagBits::e1;
+    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    colorAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    colorAttachment.finalLayout = vk::ImageLayout::eTransferSrcOptimal;
+
+    vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+
+    vk::SubpassDescription subpass;
+    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorRef;
+
+    // Make the color writes visible to the readback copy that follows the render pass.
+    vk::SubpassDependency dependency;
+    dependency.srcSubpass = 0;
+    dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    dependency.dstStageMask = vk::PipelineStageFlagBits::eTransfer;
+    dependency.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+    vk::RenderPassCreateInfo renderPassInfo;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    this->renderPass = this->logicalDevice->createRenderPassUnique(renderPassInfo);
+
+    vk::FramebufferCreateInfo framebufferInfo;
+    framebufferInfo.renderPass = this->renderPass.get();
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &this->colorView.get();
+    framebufferInfo.width = this->extent.width;
+    framebufferInfo.height = this->extent.height;
+    framebufferInfo.layers = 1;
+
+    this->framebuffer = this->logicalDevice->createFramebufferUnique(framebufferInfo);
+}
+
+void OffscreenRenderer::createPipeline()
+{
+    this->descriptorLayouts = std::make_unique<DescriptorLayoutCache>(this->logicalDevice.get());
+    this->descriptors = std::make_unique<DescriptorAllocator>(this->logicalDevice.get(), 1u);
+
+    this->pipeline = TrianglePipeline::create(this->logicalDevice.get(), this->renderPass.get(),
+                                              *this->descriptorLayouts);
+
+    this->uniformRing = std::make_unique<UniformRing>(this->physicalDevice, this->logicalDevice.get(),
+                                                      *this->memoryTracker, sizeof(SceneUniforms), 1u,
+                                                      vk::BufferUsageFlagBits::eUniformBuffer);
+    this->uniformSet = this->pipeline.allocateUniformSet(this->logicalDevice.get(), *this->descriptors,
+                                                         this->uniformRing->getBuffer());
+}
+
+void OffscreenRenderer::createCommands()
+{
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = this->graphicsFamily;
+
+    this->commandPool = this->logicalDevice->createCommandPoolUnique(poolInfo);
+
+    vk::CommandBufferAllocateInfo allocInfo;
+    allocInfo.commandPool = this->commandPool.get();
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandBufferCount = 1;
+
+    this->commandBuffer = std::move(this->logicalDevice->allocateCommandBuffersUnique(allocInfo).front());
+    this->frameFence = this->logicalDevice->createFenceUnique({});
+}
+
+void OffscreenRenderer::createTimestampPool()
+{
+    auto validBits = this->physicalDevice.getQueueFamilyProperties()[this->graphicsFamily].timestampValidBits;
+    if (validBits == 0u)
+    {
+        return;
+    }
+
+    this->timestampPeriod = this->physicalDevice.getProperties().limits.timestampPeriod;
+    this->timestampMask = validBits >= 64u ? ~0ull : (1ull << validBits) - 1u;
+
+    vk::QueryPoolCreateInfo queryPoolInfo;
+    queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+    queryPoolInfo.queryCount = 2u;
+    this->timestampPool = this->logicalDevice->createQueryPoolUnique(queryPoolInfo);
+}
+
+void OffscreenRenderer::setScene(const SceneDescription &newScene)
+{
+    this->scene = newScene;
+
+    if (this->scene.quads > 0u && !this->overlayRenderer)
+    {
+        this->overlayRenderer = std::make_unique<Batch2DRenderer>(this->physicalDevice, this->logicalDevice.get(),
+                                                                  *this->memoryTracker, *this->descriptorLayouts,
+                                                                  this->renderPass.get(), 1u);
+    }
+}
+
+const PipelineStatistics *OffscreenRenderer::getPipelineStatistics() const noexcept
+{
+    return this->pipelineStatistics.get();
+}
+
+std::optional<double> OffscreenRenderer::lastGpuFrameMs() const noexcept
+{
+    return this->gpuFrameMs;
+}
+
+void OffscreenRenderer::recordFrame(uint64_t jobIndex)
+{
+    auto &cmd = this->commandBuffer.get();
+
+    vk::CommandBufferBeginInfo beginInfo;
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    cmd.begin(beginInfo);
+
+    if (this->timestampPool)
+    {
+        cmd.resetQueryPool(this->timestampPool.get(), 0u, 2u);
+        cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, this->timestampPool.get(), 0u);
+    }
+
+    auto clearColor = FrameRenderer::jobClearColor(jobIndex);
+    vk::ClearValue clearValue;
+    clearValue.color = vk::ClearColorValue(std::array<float, 4>{
+            clearColor[0] / 255.0f, clearColor[1] / 255.0f, clearColor[2] / 255.0f, clearColor[3] / 255.0f});
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = this->renderPass.get();
+    renderPassInfo.framebuffer = this->framebuffer.get();
+    renderPassInfo.renderArea = vk::Rect2D({0, 0}, this->extent);
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearValue;
+
+    std::optional<PassQueryRange> sceneQuery;
+    if (this->pipelineStatistics)
+    {
+        sceneQuery = this->pipelineStatistics->queriesFor(0u);
+        cmd.resetQueryPool(sceneQuery->pool, sceneQuery->firstQuery, 1u);
+        cmd.beginQuery(sceneQuery->pool, sceneQuery->firstQuery, {});
+    }
+
+    cmd.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(this->extent.width),
+                          static_cast<float>(this->extent.height), 0.0f, 1.0f);
+    cmd.setViewport(0, viewport);
+    cmd.setScissor(0, vk::Rect2D({0, 0}, this->extent));
+
+    // The previous frame was waited on, so the ring's only region is free again.
+    auto aspect = static_cast<float>(this->extent.width) / static_cast<float>(this->extent.height);
+    this->uniformRing->beginFrame(0u);
+    this->descriptors->beginFrame(0u);
+    auto uniformOffset = this->uniformRing->push(SceneUniforms::rotated(0.1f * static_cast<float>(jobIndex), aspect));
+    this->uniformRing->flush();
+
+    // Triangles are shrunk into the cells of a square grid, a single one fills the whole frame as before.
+    this->pipeline.bind(cmd, this->uniformSet, uniformOffset, FrameRenderer::gridCell(this->scene.triangles, 0u));
+    for (uint32_t i = 0; i < this->scene.triangles; i++)
+    {
+        this->pipeline.push(cmd, FrameRenderer::gridCell(this->scene.triangles, i));
+        cmd.draw(3, 1, 0, 0);
+    }
+
+    if (this->scene.quads > 0u)
+    {
+        FrameRenderer::buildOverlay(this->scene, this->extent, jobIndex, this->overlay);
+        this->overlayRenderer->record(cmd, 0u, this->overlay, this->extent);
+    }
+
+    cmd.endRenderPass();
+
+    if (sceneQuery)
+    {
+        cmd.endQuery(sceneQuery->pool, sceneQuery->firstQuery);
+    }
+
+    vk::BufferImageCopy region;
+    region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    region.imageExtent = vk::Extent3D(this->extent.width, this->extent.height, 1u);
+    cmd.copyImageToBuffer(this->colorImage.get(), vk::ImageLayout::eTransferSrcOptimal,
+                          this->readbackBuffer.get(), region);
+
+    vk::BufferMemoryBarrier hostBarrier;
+    hostBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    hostBarrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = this->readbackBuffer.get();
+    hostBarrier.offset = 0;
+    hostBarrier.size = VK_WHOLE_SIZE;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+                        nullptr, hostBarrier, nullptr);
+
+    if (this->timestampPool)
+    {
+        cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampPool.get(), 1u);
+    }
+
+    cmd.end();
+}
+
+void OffscreenRenderer::renderFrame(uint64_t jobIndex, vector<uint8_t> &pixels)
+{
+    this->logicalDevice->resetCommandPool(this->commandPool.get(), {});
+    this->recordFrame(jobIndex);
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &this->commandBuffer.get();
+
+    this->logicalDevice->resetFences(this->frameFence.get());
+    this->graphicsQueue.submit(submitInfo, this->frameFence.get());
+
+    if (this->logicalDevice->waitForFences(this->frameFence.get(), VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+    {
+        throw std::runtime_error(fmt::format("Timed out waiting for frame {:d} on {:s}", jobIndex, this->name()));
+    }
+
+    pixels.resize(this->frameSize());
+    std::memcpy(pixels.data(), this->readbackData, pixels.size());
+
+    if (this->timestampPool)
+    {
+        std::array<uint64_t, 2> timestamps{};
+        auto result = this->logicalDevice->getQueryPoolResults(this->timestampPool.get(), 0u, 2u,
+                                                               sizeof(timestamps), timestamps.data(),
+                                                               sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+        if (result == vk::Result::eSuccess)
+        {
+            auto ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+            this->gpuFrameMs = static_cast<double>(ticks) * this->timestampPeriod / 1.0e6;
+        }
+    }
+
+    if (this->pipelineStatistics)
+    {
+        this->pipelineStatistics->collect(0u);
+    }
+}
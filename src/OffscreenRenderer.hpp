@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <array>
+#include <optional>
+#include <vector>
+#include <string>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "TrianglePipeline.hpp"
+#include "MemoryTracker.hpp"
+#include "UniformRing.hpp"
+#include "Batcher2D.hpp"
+#include "Batch2DRenderer.hpp"
+#include "SceneDescription.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineStatistics.hpp"
+#include "FrameRenderer.hpp"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+namespace VkTri
+{
+    /**
+     * \brief Renders the triangle into an offscreen image on a single device and reads the pixels back.
+     *
+     * \details
+     * No surface or swap chain is involved, so any device with a graphics queue can be used.
+     *
+     * By default each frame is the single triangle the app draws. setScene() swaps in a heavier workload, which
+     * is what the performance suite measures.
+     */
+    class OffscreenRenderer : public FrameRenderer
+    {
+    private:
+        vk::PhysicalDevice physicalDevice; /**< Physical device backing this renderer */
+        vk::UniqueDevice logicalDevice; /**< Logical device created for this renderer only */
+        vk::Queue graphicsQueue;
+        uint32_t graphicsFamily = 0u;
+        unique_ptr<MemoryTracker> memoryTracker;
+
+        vk::Extent2D extent;
+        static constexpr vk::Format colorFormat = vk::Format::eR8G8B8A8Unorm;
+
+        vk::UniqueImage colorImage;
+        DeviceAllocation colorMemory;
+        vk::UniqueImageView colorView;
+
+        vk::UniqueBuffer readbackBuffer;
+        DeviceAllocation readbackMemory;
+        const uint8_t *readbackData = nullptr; /**< Persistent mapping of readbackMemory */
+
+        vk::UniqueRenderPass renderPass;
+        vk::UniqueFramebuffer framebuffer;
+        unique_ptr<DescriptorLayoutCache> descriptorLayouts;
+        unique_ptr<DescriptorAllocator> descriptors; /**< Single frame slot, frames are rendered one at a time */
+        TrianglePipeline pipeline;
+        unique_ptr<UniformRing> uniformRing; /**< Single region, frames are rendered one at a time */
+        vk::DescriptorSet uniformSet;
+
+        SceneDescription scene;
+        Batcher2D overlay;
+        unique_ptr<Batch2DRenderer> overlayRenderer; /**< Created by setScene() for scenes with quads */
+
+        vk::UniqueQueryPool timestampPool; /**< Brackets the frame's GPU work, null without timestamp support */
+        double timestampPeriod = 0.0;
+        uint64_t timestampMask = 0u;
+        std::optional<double> gpuFrameMs;
+        bool pipelineStatisticsSupported = false;
+        unique_ptr<PipelineStatistics> pipelineStatistics; /**< Single "scene" pass, null without device support */
+
+        vk::UniqueCommandPool commandPool;
+        vk::UniqueCommandBuffer commandBuffer;
+        vk::UniqueFence frameFence;
+
+        void createLogicalDevice();
+
+        void createColorTarget();
+
+        void createReadbackBuffer();
+
+        void createRenderPass();
+
+        void createPipeline();
+
+        void createCommands();
+
+        void createTimestampPool();
+
+        void recordFrame(uint64_t jobIndex);
+
+    public:
+        /**
+         * \brief Checks if the device can be used for offscreen rendering.
+         */
+        [[nodiscard]] static bool isSuitable(const vk::PhysicalDevice &device);
+
+        /**
+         * \brief Creates a logical device and all offscreen resources on the provided physical device.
+         * \param device physical device to render with.
+         * \param extent size of the rendered frames.
+         */
+        [[nodiscard]] static unique_ptr<OffscreenRenderer> create(const vk::PhysicalDevice &device,
+                                                                  const vk::Extent2D &extent);
+
+        ~OffscreenRenderer() override;
+
+        /**
+         * \brief Renders one frame on the device and reads its RGBA8 pixels back into the provided vector.
+         */
+        void renderFrame(uint64_t jobIndex, vector<uint8_t> &pixels) override;
+
+        void setScene(const SceneDescription &scene) override;
+
+        /**
+         * \brief GPU time of the last frame, if the graphics queue supports timestamps.
+         */
+        [[nodiscard]] std::optional<double> lastGpuFrameMs() const noexcept override;
+
+        /**
+         * \brief Pipeline statistics of the last frame's render pass, or null without device support.
+         */
+        [[nodiscard]] const PipelineStatistics *getPipelineStatistics() const noexcept override;
+
+        [[nodiscard]] string name() const override;
+
+        [[nodiscard]] size_t frameSize() const noexcept override;
+
+        [[nodiscard]] MemoryStats getMemoryStats() const;
+    };
+}
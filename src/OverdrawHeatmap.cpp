@@ -0,0 +1,169 @@
+#include <array>
+#include "DeviceSetup.hpp"
+#include "ShaderReflection.hpp"
+#include "OverdrawHeatmap.hpp"
+#include "reflection/HeatmapVert.hpp"
+#include "reflection/HeatmapFrag.hpp"
+
+using std::array;
+
+using namespace VkTri;
+
+namespace VertexShader = VkTri::Reflection::HeatmapVert;
+namespace FragmentShader = VkTri::Reflection::HeatmapFrag;
+
+static_assert(sizeof(HeatmapConstants) == FragmentShader::PUSH_CONSTANTS.size,
+              "HeatmapConstants does not match the push constant block of heatmap.frag");
+
+OverdrawHeatmap::OverdrawHeatmap(const vk::Device &device, DescriptorLayoutCache &layouts,
+                                 const vk::RenderPass &outputPass)
+{
+    this->device = device;
+    this->createCountPass();
+    this->createPipeline(layouts, outputPass);
+}
+
+void OverdrawHeatmap::createCountPass()
+{
+    vk::AttachmentDescription countAttachment;
+    countAttachment.format = OVERDRAW_FORMAT;
+    countAttachment.samples = vk::SampleCountFlagBits::e1;
+    countAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    countAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    countAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    countAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    // Layout transitions and synchronization around the pass are handled by the frame graph.
+    countAttachment.initialLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    countAttachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+
+    vk::AttachmentReference countRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+
+    vk::SubpassDescription subpass;
+    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &countRef;
+
+    vk::RenderPassCreateInfo renderPassInfo;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &countAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    this->countPass = this->device.createRenderPassUnique(renderPassInfo);
+}
+
+void OverdrawHeatmap::createPipeline(DescriptorLayoutCache &layouts, const vk::RenderPass &outputPass)
+{
+    // Counts are read with texelFetch, the sampler only has to exist.
+    vk::SamplerCreateInfo samplerInfo;
+    samplerInfo.magFilter = vk::Filter::eNearest;
+    samplerInfo.minFilter = vk::Filter::eNearest;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+
+    this->sampler = this->device.createSamplerUnique(samplerInfo);
+
+    this->setLayout = layouts.get(
+            descriptorSetLayoutBindings({VertexShader::INTERFACE, FragmentShader::INTERFACE}, 0, false));
+    auto pushRanges = pushConstantRanges({VertexShader::INTERFACE, FragmentShader::INTERFACE});
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &this->setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushRanges.data();
+
+    this->layout = this->device.createPipelineLayoutUnique(pipelineLayoutInfo);
+
+    auto vertShaderModule = loadShaderModule(this->device, HEATMAP_VERTEX_SHADER_PATH);
+    auto fragShaderModule = loadShaderModule(this->device, HEATMAP_FRAGMENT_SHADER_PATH);
+
+    array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {
+            vk::PipelineShaderStageCreateInfo({}, VertexShader::STAGE, vertShaderModule.get(), "main"),
+            vk::PipelineShaderStageCreateInfo({}, FragmentShader::STAGE, fragShaderModule.get(), "main")};
+
+    // The fullscreen triangle is generated from the vertex index.
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    array<vk::DynamicState, 2> dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    vk::PipelineDynamicStateCreateInfo dynamicState;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+    multisampling.minSampleShading = 1.0f;
+
+    // The heatmap replaces whatever was in the target.
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask =
+            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB |
+            vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    vk::PipelineColorBlendStateCreateInfo colorBlending;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = this->layout.get();
+    pipelineInfo.renderPass = outputPass;
+    pipelineInfo.subpass = 0;
+
+    this->pipeline = this->device.createGraphicsPipelineUnique(nullptr, pipelineInfo).value;
+}
+
+vk::RenderPass OverdrawHeatmap::getCountPass() const noexcept
+{
+    return this->countPass.get();
+}
+
+void OverdrawHeatmap::recordHeatmap(const vk::CommandBuffer &cmd, DescriptorAllocator &descriptors,
+                                    const vk::ImageView &counts, float maxOverdraw) const
+{
+    // The count target is rebuilt along with the frame graph, so its set is allocated per frame.
+    auto countSet = descriptors.allocateTransient(this->setLayout);
+
+    const auto &binding = FragmentShader::DESCRIPTOR_BINDINGS[0];
+    vk::DescriptorImageInfo imageInfo(this->sampler.get(), counts, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    vk::WriteDescriptorSet write;
+    write.dstSet = countSet;
+    write.dstBinding = binding.binding;
+    write.descriptorCount = 1;
+    write.descriptorType = binding.type;
+    write.pImageInfo = &imageInfo;
+
+    this->device.updateDescriptorSets(write, nullptr);
+
+    HeatmapConstants constants{maxOverdraw};
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, this->pipeline.get());
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->layout.get(), 0, countSet, nullptr);
+    cmd.pushConstants(this->layout.get(), FragmentShader::STAGE, 0, sizeof(HeatmapConstants), &constants);
+    cmd.draw(3, 1, 0, 0);
+}
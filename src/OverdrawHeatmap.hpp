@@ -0,0 +1,72 @@
+#pragma once
+
+#include <filesystem>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "DescriptorAllocator.hpp"
+
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    const fs::path HEATMAP_VERTEX_SHADER_PATH("../shaders/heatmap_vert.spv");
+    const fs::path HEATMAP_FRAGMENT_SHADER_PATH("../shaders/heatmap_frag.spv");
+
+    static constexpr vk::Format OVERDRAW_FORMAT = vk::Format::eR16Sfloat; /**< Exact for counts up to 2048 */
+    static constexpr float OVERDRAW_HEATMAP_MAX = 8.0f; /**< Fragments per pixel shown as the hottest color */
+
+    /**
+     * \brief Push constants of heatmap.frag.
+     */
+    struct HeatmapConstants
+    {
+        float maxOverdraw;
+    };
+
+    /**
+     * \brief Turns an overdraw count target into a heatmap.
+     *
+     * \details
+     * The scene is first drawn into an OVERDRAW_FORMAT target inside getCountPass(), with pipelines created with
+     * TriangleShading::Overdraw. Each fragment adds one, so the target ends up holding how many fragments were
+     * shaded per pixel. recordHeatmap() then maps the counts from black (none) through blue (one) to red
+     * (OVERDRAW_HEATMAP_MAX and above) with a fullscreen triangle.
+     */
+    class OverdrawHeatmap
+    {
+    private:
+        vk::Device device;
+        vk::UniqueRenderPass countPass;
+        vk::UniqueSampler sampler;
+        vk::DescriptorSetLayout setLayout; /**< Owned by the layout cache */
+        vk::UniquePipelineLayout layout;
+        vk::UniquePipeline pipeline;
+
+        void createCountPass();
+
+        void createPipeline(DescriptorLayoutCache &layouts, const vk::RenderPass &outputPass);
+
+    public:
+        /**
+         * \param layouts cache the set layout is taken from, which must outlive the heatmap.
+         * \param outputPass render pass whose subpass 0 the heatmap is drawn in.
+         */
+        OverdrawHeatmap(const vk::Device &device, DescriptorLayoutCache &layouts, const vk::RenderPass &outputPass);
+
+        /**
+         * \brief Render pass with a single OVERDRAW_FORMAT attachment, cleared to zero and kept in
+         * eColorAttachmentOptimal.
+         */
+        [[nodiscard]] vk::RenderPass getCountPass() const noexcept;
+
+        /**
+         * \brief Draws the heatmap of the counts inside an active output pass.
+         * \param counts view of the count target, in eShaderReadOnlyOptimal.
+         */
+        void recordHeatmap(const vk::CommandBuffer &cmd, DescriptorAllocator &descriptors,
+                           const vk::ImageView &counts, float maxOverdraw = OVERDRAW_HEATMAP_MAX) const;
+    };
+}
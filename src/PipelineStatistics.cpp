@@ -0,0 +1,81 @@
+#include <fmt/format.h>
+#include "PipelineStatistics.hpp"
+
+using namespace VkTri;
+
+static_assert(sizeof(PipelineStatisticsCounts) == 6u * sizeof(uint64_t),
+              "PipelineStatisticsCounts must have one 64 bit counter per collected statistic");
+
+bool PipelineStatistics::isSupported(const vk::PhysicalDevice &device)
+{
+    return device.getFeatures().pipelineStatisticsQuery == VK_TRUE;
+}
+
+PipelineStatistics::PipelineStatistics(const vk::Device &device, uint32_t frameCount, vector<string> passNames)
+        : device(device), passNames(std::move(passNames)), written(frameCount, false)
+{
+    this->latest.resize(this->passNames.size());
+
+    vk::QueryPoolCreateInfo queryPoolInfo;
+    queryPoolInfo.queryType = vk::QueryType::ePipelineStatistics;
+    queryPoolInfo.queryCount = static_cast<uint32_t>(this->passNames.size()) * frameCount;
+    queryPoolInfo.pipelineStatistics = COLLECTED;
+
+    this->pool = device.createQueryPoolUnique(queryPoolInfo);
+}
+
+PassQueryRange PipelineStatistics::queriesFor(uint32_t frameIndex)
+{
+    this->written[frameIndex] = true;
+    return PassQueryRange{this->pool.get(), frameIndex * static_cast<uint32_t>(this->passNames.size())};
+}
+
+bool PipelineStatistics::collect(uint32_t frameIndex)
+{
+    if (!this->written[frameIndex])
+    {
+        return false;
+    }
+
+    auto passCount = static_cast<uint32_t>(this->passNames.size());
+    auto result = this->device.getQueryPoolResults(this->pool.get(), frameIndex * passCount, passCount,
+                                                   this->latest.size() * sizeof(PipelineStatisticsCounts),
+                                                   this->latest.data(), sizeof(PipelineStatisticsCounts),
+                                                   vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+    {
+        return false;
+    }
+
+    this->written[frameIndex] = false;
+    this->hasResults = true;
+    return true;
+}
+
+const vector<string> &PipelineStatistics::getPassNames() const noexcept
+{
+    return this->passNames;
+}
+
+const vector<PipelineStatisticsCounts> &PipelineStatistics::getLatest() const noexcept
+{
+    return this->latest;
+}
+
+string PipelineStatistics::format() const
+{
+    if (!this->hasResults)
+    {
+        return "No pipeline statistics collected yet.\n";
+    }
+
+    string result;
+    for (size_t i = 0; i < this->passNames.size(); i++)
+    {
+        const auto &counts = this->latest[i];
+        result += fmt::format("{:<12s}Vertices: {:d}\tVS: {:d}\tClipped in/out: {:d}/{:d}\tFS: {:d}\n",
+                              this->passNames[i], counts.inputAssemblyVertices, counts.vertexInvocations,
+                              counts.clippingInvocations, counts.clippingPrimitives, counts.fragmentInvocations);
+    }
+    return result;
+}
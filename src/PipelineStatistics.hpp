@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "FrameGraph.hpp"
+
+using std::string;
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Counters of one pass, in the order the driver writes them for PipelineStatistics::COLLECTED.
+     */
+    struct PipelineStatisticsCounts
+    {
+        uint64_t inputAssemblyVertices = 0u;
+        uint64_t inputAssemblyPrimitives = 0u;
+        uint64_t vertexInvocations = 0u;
+        uint64_t clippingInvocations = 0u; /**< Primitives that reached the clipping stage */
+        uint64_t clippingPrimitives = 0u; /**< Primitives that came out of clipping */
+        uint64_t fragmentInvocations = 0u;
+    };
+
+    /**
+     * \brief Collects pipeline statistics queries for every pass of every frame in flight.
+     *
+     * \details
+     * Each frame slot owns one query per pass. The queries are handed to FrameGraph::execute() and read back
+     * without waiting once the slot's fence has signaled, so collecting them never stalls. Where timestamps say
+     * how long a frame took, these say why: how much geometry went in, how much of it survived clipping, and how
+     * many fragments were shaded.
+     *
+     * Requires the pipelineStatisticsQuery device feature.
+     */
+    class PipelineStatistics
+    {
+    private:
+        vk::Device device;
+        vk::UniqueQueryPool pool;
+        vector<string> passNames;
+        vector<bool> written; /**< Whether each frame slot has queries in flight */
+        vector<PipelineStatisticsCounts> latest; /**< Per pass, from the most recently collected frame */
+        bool hasResults = false;
+
+    public:
+        static constexpr vk::QueryPipelineStatisticFlags COLLECTED =
+                vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+                vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+                vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+                vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+                vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+                vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+        /**
+         * \brief Checks if the device supports the pipelineStatisticsQuery feature.
+         */
+        [[nodiscard]] static bool isSupported(const vk::PhysicalDevice &device);
+
+        /**
+         * \param passNames passes queried each frame, in execution order.
+         */
+        PipelineStatistics(const vk::Device &device, uint32_t frameCount, vector<string> passNames);
+
+        /**
+         * \brief Queries the frame slot's passes should be recorded into. Marks the slot as having results.
+         */
+        [[nodiscard]] PassQueryRange queriesFor(uint32_t frameIndex);
+
+        /**
+         * \brief Reads back the slot's queries, whose frame must have completed.
+         * \return whether new results were available.
+         */
+        bool collect(uint32_t frameIndex);
+
+        [[nodiscard]] const vector<string> &getPassNames() const noexcept;
+
+        /**
+         * \brief Counters of each pass of the last collected frame, all zero before the first one.
+         */
+        [[nodiscard]] const vector<PipelineStatisticsCounts> &getLatest() const noexcept;
+
+        /**
+         * \brief Formats the latest counters as one line per pass.
+         */
+        [[nodiscard]] string format() const;
+    };
+}
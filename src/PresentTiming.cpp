@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+#include "PresentTiming.hpp"
+
+using namespace VkTri;
+
+static constexpr size_t HISTOGRAM_BAR_WIDTH = 40u; /**< Characters of the longest bar */
+
+// =====
+// LatencyHistogram
+// =====
+
+void LatencyHistogram::add(double ms) noexcept
+{
+    ms = std::max(ms, 0.0);
+    auto bound = std::lower_bound(LATENCY_BUCKET_BOUNDS_MS.begin(), LATENCY_BUCKET_BOUNDS_MS.end(), ms);
+    this->counts[static_cast<size_t>(bound - LATENCY_BUCKET_BOUNDS_MS.begin())]++;
+
+    this->minMs = this->samples == 0u ? ms : std::min(this->minMs, ms);
+    this->maxMs = this->samples == 0u ? ms : std::max(this->maxMs, ms);
+    this->sumMs += ms;
+    this->samples++;
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::count() const noexcept
+{
+    return this->samples;
+}
+
+uint64_t LatencyHistogram::bucketCount(size_t bucket) const noexcept
+{
+    return bucket < this->counts.size() ? this->counts[bucket] : 0u;
+}
+
+double LatencyHistogram::mean() const noexcept
+{
+    return this->samples == 0u ? 0.0 : this->sumMs / static_cast<double>(this->samples);
+}
+
+double LatencyHistogram::min() const noexcept
+{
+    return this->minMs;
+}
+
+double LatencyHistogram::max() const noexcept
+{
+    return this->maxMs;
+}
+
+double LatencyHistogram::percentile(double fraction) const noexcept
+{
+    if (this->samples == 0u)
+    {
+        return 0.0;
+    }
+
+    auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(this->samples)));
+    rank = std::clamp<uint64_t>(rank, 1u, this->samples);
+
+    uint64_t seen = 0u;
+    for (size_t i = 0; i < LATENCY_BUCKET_BOUNDS_MS.size(); i++)
+    {
+        seen += this->counts[i];
+        if (seen >= rank)
+        {
+            return std::min(LATENCY_BUCKET_BOUNDS_MS[i], this->maxMs);
+        }
+    }
+
+    return this->maxMs;
+}
+
+string LatencyHistogram::format(const string &title) const
+{
+    if (this->samples == 0u)
+    {
+        return fmt::format("{:s}: no samples\n", title);
+    }
+
+    auto result = fmt::format("{:s}: {:d} samples\tmean {:.2f} ms\tp50 <= {:.2f} ms\tp99 <= {:.2f} ms\t"
+                              "min/max {:.2f}/{:.2f} ms\n", title, this->samples, this->mean(),
+                              this->percentile(0.50), this->percentile(0.99), this->minMs, this->maxMs);
+
+    auto largest = *std::max_element(this->counts.begin(), this->counts.end());
+    for (size_t i = 0; i < this->counts.size(); i++)
+    {
+        if (this->counts[i] == 0u)
+        {
+            continue;
+        }
+
+        // Every non-empty bucket gets at least one character, so rare outliers stay visible.
+        auto width = std::max<size_t>(1u, static_cast<size_t>(this->counts[i] * HISTOGRAM_BAR_WIDTH / largest));
+        auto label = i < LATENCY_BUCKET_BOUNDS_MS.size()
+                     ? fmt::format("<= {:.1f}", LATENCY_BUCKET_BOUNDS_MS[i])
+                     : fmt::format(" > {:.1f}", LATENCY_BUCKET_BOUNDS_MS.back());
+        result += fmt::format("  {:>9s} ms |{:s} {:d}\n", label, string(width, '#'), this->counts[i]);
+    }
+
+    return result;
+}
+
+// =====
+// PresentTimer
+// =====
+
+PresentTimer::PresentTimer(unique_ptr<PresentBackend> backend)
+{
+    this->backend = std::move(backend);
+    this->startWaiter();
+}
+
+PresentTimer::~PresentTimer()
+{
+    this->stopWaiter();
+}
+
+void PresentTimer::startWaiter()
+{
+    if (this->backend)
+    {
+        this->stopping = false;
+        this->waiter = std::thread(&PresentTimer::waiterLoop, this);
+    }
+}
+
+void PresentTimer::stopWaiter()
+{
+    if (this->waiter.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->presentQueued.notify_one();
+        this->waiter.join();
+    }
+}
+
+void PresentTimer::waiterLoop()
+{
+    while (true)
+    {
+        PendingPresent present;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->presentQueued.wait(lock, [this]
+            { return this->stopping || this->queueCount > 0u; });
+
+            // Pending presents are still resolved on shutdown, so the backend is idle when it is destroyed.
+            if (this->queueCount == 0u)
+            {
+                return;
+            }
+
+            present = this->queue[this->queueHead];
+            this->queueHead = (this->queueHead + 1u) % PRESENT_QUEUE_SIZE;
+            this->queueCount--;
+            this->waiting = true;
+        }
+
+        auto presentTime = this->backend->waitForPresent(present.presentId, PRESENT_WAIT_TIMEOUT_NS);
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            // The interval across a lost present would span two frames, so it starts over.
+            if (present.afterMiss)
+            {
+                this->lastPresentTime.reset();
+            }
+
+            if (presentTime)
+            {
+                this->record(present.inputTime, *presentTime);
+            }
+            else
+            {
+                this->missedPresents++;
+                this->lastPresentTime.reset();
+            }
+            this->waiting = false;
+        }
+        this->queueDrained.notify_all();
+    }
+}
+
+void PresentTimer::record(std::optional<double> inputTime, double presentTime)
+{
+    if (inputTime)
+    {
+        this->inputToPresent.add((presentTime - *inputTime) * 1000.0);
+    }
+
+    if (this->lastPresentTime)
+    {
+        this->presentInterval.add((presentTime - *this->lastPresentTime) * 1000.0);
+    }
+    this->lastPresentTime = presentTime;
+}
+
+void PresentTimer::setBackend(unique_ptr<PresentBackend> newBackend)
+{
+    this->flush();
+    this->stopWaiter();
+    this->backend = std::move(newBackend);
+    this->startWaiter();
+}
+
+void PresentTimer::inputEvent(double timestamp) noexcept
+{
+    if (!this->pendingInput)
+    {
+        this->pendingInput = timestamp;
+    }
+}
+
+void PresentTimer::discardInput() noexcept
+{
+    this->pendingInput.reset();
+}
+
+uint64_t PresentTimer::beginPresent() noexcept
+{
+    this->queuedInput = this->pendingInput;
+    this->pendingInput.reset();
+    return ++this->lastPresentId;
+}
+
+void PresentTimer::presented(uint64_t presentId, double returnTime, bool queued)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    if (!queued)
+    {
+        this->missedPresents++;
+        if (this->backend)
+        {
+            this->presentLost = true;
+        }
+        else
+        {
+            this->lastPresentTime.reset();
+        }
+        return;
+    }
+
+    if (!this->backend)
+    {
+        this->record(this->queuedInput, returnTime);
+        return;
+    }
+
+    // A stalled presentation engine must not block the frame loop, so overflowing presents go unmeasured.
+    if (this->queueCount == PRESENT_QUEUE_SIZE)
+    {
+        this->missedPresents++;
+        this->presentLost = true;
+        return;
+    }
+
+    this->queue[(this->queueHead + this->queueCount) % PRESENT_QUEUE_SIZE] = {presentId, this->queuedInput,
+                                                                               this->presentLost};
+    this->presentLost = false;
+    this->queueCount++;
+    lock.unlock();
+    this->presentQueued.notify_one();
+}
+
+void PresentTimer::flush()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->queueDrained.wait(lock, [this]
+    { return this->queueCount == 0u && !this->waiting; });
+}
+
+void PresentTimer::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->inputToPresent.reset();
+    this->presentInterval.reset();
+    this->lastPresentTime.reset();
+    this->missedPresents = 0u;
+}
+
+bool PresentTimer::usesPresentWait() const noexcept
+{
+    return static_cast<bool>(this->backend);
+}
+
+LatencyHistogram PresentTimer::getInputToPresent() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->inputToPresent;
+}
+
+LatencyHistogram PresentTimer::getPresentInterval() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->presentInterval;
+}
+
+uint64_t PresentTimer::getMissedPresents() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->missedPresents;
+}
+
+string PresentTimer::format() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto source = this->backend ? "VK_KHR_present_wait" : "vkQueuePresentKHR return";
+    return fmt::format("Presents timed by {:s}, {:d} missed\n", source, this->missedPresents) +
+           this->inputToPresent.format("Input to present") +
+           this->presentInterval.format("Present interval");
+}
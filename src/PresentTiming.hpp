@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+using std::string;
+using std::unique_ptr;
+
+namespace VkTri
+{
+    /**
+     * \brief Upper bounds of the latency histogram buckets in milliseconds. Longer samples go to an overflow bucket.
+     */
+    static constexpr std::array<double, 12> LATENCY_BUCKET_BOUNDS_MS = {
+            1.0, 2.0, 4.0, 6.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.4, 50.0, 100.0};
+
+    static constexpr size_t PRESENT_QUEUE_SIZE = 8u; /**< Presents that may await their timestamp at once */
+    static constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000u; /**< Longest wait for a single present */
+
+    /**
+     * \brief Fixed-bucket histogram of durations, which never allocates while recording.
+     */
+    class LatencyHistogram
+    {
+    private:
+        std::array<uint64_t, LATENCY_BUCKET_BOUNDS_MS.size() + 1u> counts{}; /**< Last one is the overflow */
+        uint64_t samples = 0u;
+        double sumMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+
+    public:
+        void add(double ms) noexcept;
+
+        void reset() noexcept;
+
+        [[nodiscard]] uint64_t count() const noexcept;
+
+        [[nodiscard]] uint64_t bucketCount(size_t bucket) const noexcept;
+
+        [[nodiscard]] double mean() const noexcept;
+
+        [[nodiscard]] double min() const noexcept;
+
+        [[nodiscard]] double max() const noexcept;
+
+        /**
+         * \brief Upper bound of the bucket holding the nearest-rank percentile, or the maximum if that is lower.
+         */
+        [[nodiscard]] double percentile(double fraction) const noexcept;
+
+        /**
+         * \brief Summary line followed by one bar per non-empty bucket.
+         */
+        [[nodiscard]] string format(const string &title) const;
+    };
+
+    /**
+     * \brief Source of the times at which presents reach the display.
+     *
+     * \details
+     * Implemented with VK_KHR_present_wait by SwapchainPresentWait, and by a scripted mock in the tests.
+     */
+    class PresentBackend
+    {
+    public:
+        virtual ~PresentBackend() = default;
+
+        /**
+         * \brief Blocks until the present with the given id has been displayed.
+         * \param presentId id passed with the present through VK_KHR_present_id.
+         * \param timeoutNs longest time to wait.
+         * \return the time at which the present was displayed in seconds, or nothing on timeout or failure.
+         */
+        virtual std::optional<double> waitForPresent(uint64_t presentId, uint64_t timeoutNs) = 0;
+    };
+
+    /**
+     * \brief Measures when frames are presented, how long after the input they respond to, and how evenly.
+     *
+     * \details
+     * The caller reports input events with inputEvent(), and each present with beginPresent() before queueing it
+     * and presented() once vkQueuePresentKHR has returned. The first input event since the last present is
+     * attributed to the next one, which gives the input-to-present latency of that frame. The interval between
+     * consecutive presents is recorded for every frame.
+     *
+     * With a PresentBackend, a waiter thread waits for each present in order and records the time it was
+     * displayed. Without one, a frame counts as presented when vkQueuePresentKHR returns, which ignores the time
+     * the image spends queued in the presentation engine.
+     *
+     * All times are in seconds on the caller's clock, which the backend must share. Nothing allocates after
+     * construction, and presents that would overflow PRESENT_QUEUE_SIZE are counted as missed.
+     */
+    class PresentTimer
+    {
+    private:
+        struct PendingPresent
+        {
+            uint64_t presentId = 0u;
+            std::optional<double> inputTime;
+            bool afterMiss = false; /**< Whether a present was lost right before this one */
+        };
+
+        unique_ptr<PresentBackend> backend; /**< Null when presents are timed at vkQueuePresentKHR return */
+        uint64_t lastPresentId = 0u;
+        std::optional<double> pendingInput; /**< First input event not yet attributed to a present */
+        std::optional<double> queuedInput; /**< Input of the present between beginPresent() and presented() */
+
+        mutable std::mutex mutex;
+        std::condition_variable presentQueued;
+        std::condition_variable queueDrained;
+        std::array<PendingPresent, PRESENT_QUEUE_SIZE> queue;
+        size_t queueHead = 0u;
+        size_t queueCount = 0u;
+        bool presentLost = false; /**< Whether the last present was not queued for the waiter */
+        bool waiting = false; /**< Whether the waiter thread is blocked on a present it took off the queue */
+        bool stopping = false;
+        std::thread waiter;
+
+        LatencyHistogram inputToPresent;
+        LatencyHistogram presentInterval;
+        std::optional<double> lastPresentTime;
+        uint64_t missedPresents = 0u;
+
+        void waiterLoop();
+
+        /**
+         * \brief Adds a present to the histograms. The mutex must be held.
+         */
+        void record(std::optional<double> inputTime, double presentTime);
+
+        void startWaiter();
+
+        void stopWaiter();
+
+    public:
+        /**
+         * \param backend source of display times, or null to time presents when they are queued.
+         */
+        explicit PresentTimer(unique_ptr<PresentBackend> backend = nullptr);
+
+        ~PresentTimer();
+
+        /**
+         * \brief Replaces the backend, e.g. when the swap chain is recreated, after the pending presents resolved.
+         */
+        void setBackend(unique_ptr<PresentBackend> newBackend);
+
+        /**
+         * \brief Records an input event, only the first one since the last present is kept.
+         */
+        void inputEvent(double timestamp) noexcept;
+
+        /**
+         * \brief Forgets the pending input event, e.g. when it did not lead to a frame.
+         */
+        void discardInput() noexcept;
+
+        /**
+         * \brief Returns the id to pass with the next present through VK_KHR_present_id. Ids start at 1.
+         */
+        [[nodiscard]] uint64_t beginPresent() noexcept;
+
+        /**
+         * \brief Must be called once vkQueuePresentKHR has returned for the id from beginPresent().
+         * \param presentId id returned by beginPresent().
+         * \param returnTime time at which vkQueuePresentKHR returned.
+         * \param queued whether the present was queued, false if it failed and will never be displayed.
+         */
+        void presented(uint64_t presentId, double returnTime, bool queued = true);
+
+        /**
+         * \brief Blocks until every present passed to presented() has been displayed or given up on.
+         */
+        void flush();
+
+        /**
+         * \brief Clears the histograms, e.g. after a change that makes older samples meaningless.
+         */
+        void resetStatistics();
+
+        [[nodiscard]] bool usesPresentWait() const noexcept;
+
+        [[nodiscard]] LatencyHistogram getInputToPresent() const;
+
+        [[nodiscard]] LatencyHistogram getPresentInterval() const;
+
+        /**
+         * \brief Presents that were never displayed, timed out, or did not fit the queue.
+         */
+        [[nodiscard]] uint64_t getMissedPresents() const;
+
+        /**
+         * \brief Both histograms, ready to print.
+         */
+        [[nodiscard]] string format() const;
+    };
+}
@@ -0,0 +1,57 @@
+#include <thread>
+#include "DeviceSetup.hpp"
+#include "PresentWait.hpp"
+
+using namespace VkTri;
+
+SwapchainPresentWait::SwapchainPresentWait(const vk::Device &device, const vk::SwapchainKHR &swapchain,
+                                           std::mutex &swapchainMutex, double (*clock)())
+{
+    this->device = device;
+    this->swapchain = swapchain;
+    this->swapchainMutex = &swapchainMutex;
+    this->clock = clock;
+}
+
+bool SwapchainPresentWait::isSupported(const vk::PhysicalDevice &device)
+{
+    if (!hasDeviceExtension(device, VK_KHR_PRESENT_ID_EXTENSION_NAME) ||
+        !hasDeviceExtension(device, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        return false;
+    }
+
+    auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR,
+            vk::PhysicalDevicePresentWaitFeaturesKHR>();
+    return features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+           features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+}
+
+std::optional<double> SwapchainPresentWait::waitForPresent(uint64_t presentId, uint64_t timeoutNs)
+{
+    auto deadline = this->clock() + static_cast<double>(timeoutNs) * 1e-9;
+    while (true)
+    {
+        vk::Result result;
+        try
+        {
+            std::lock_guard<std::mutex> lock(*this->swapchainMutex);
+            result = this->device.waitForPresentKHR(this->swapchain, presentId, 0u);
+        }
+        catch (const vk::SystemError &)
+        {
+            // An out-of-date or lost swap chain never shows the frame, which is counted as a missed present.
+            return std::nullopt;
+        }
+
+        if (result != vk::Result::eTimeout)
+        {
+            return this->clock();
+        }
+        if (this->clock() >= deadline)
+        {
+            return std::nullopt;
+        }
+        std::this_thread::sleep_for(PRESENT_POLL_INTERVAL);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "PresentTiming.hpp"
+
+namespace VkTri
+{
+    /**
+     * \brief Times presents to a swap chain with VK_KHR_present_wait.
+     *
+     * \details
+     * The extension only reports that a present has been displayed, not when. The time is read from the clock once
+     * vkWaitForPresentKHR reports it, which adds the wake-up latency of the waiting thread.
+     *
+     * The swap chain must be externally synchronized for vkWaitForPresentKHR, like for acquires and presents on
+     * the frame loop's thread. Blocking in the wait while holding their lock would stall the frame loop for up to a
+     * refresh, so the present is polled with a zero timeout under the lock, PRESENT_POLL_INTERVAL apart. While the
+     * frame loop is blocked in an acquire, the poll waits for it, which delays the time by at most that acquire.
+     */
+    class SwapchainPresentWait : public PresentBackend
+    {
+    private:
+        static constexpr std::chrono::microseconds PRESENT_POLL_INTERVAL{250};
+
+        vk::Device device;
+        vk::SwapchainKHR swapchain;
+        std::mutex *swapchainMutex;
+        double (*clock)();
+
+    public:
+        /**
+         * \param swapchainMutex held by the owner of the swap chain around every acquire and present.
+         * \param clock returns the current time in seconds, on the clock the input events are timed with.
+         */
+        SwapchainPresentWait(const vk::Device &device, const vk::SwapchainKHR &swapchain, std::mutex &swapchainMutex,
+                             double (*clock)());
+
+        /**
+         * \brief Whether the device has VK_KHR_present_id and VK_KHR_present_wait, with both features.
+         */
+        static bool isSupported(const vk::PhysicalDevice &device);
+
+        std::optional<double> waitForPresent(uint64_t presentId, uint64_t timeoutNs) override;
+    };
+}
@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <cmath>
+#include "ResolutionScaler.hpp"
+
+using namespace VkTri;
+
+ResolutionScaler::ResolutionScaler(float minScale, float maxScale, float targetFrameMs)
+{
+    this->minScale = std::min(minScale, maxScale);
+    this->maxScale = maxScale;
+    this->targetFrameMs = targetFrameMs;
+    this->scale = maxScale;
+}
+
+float ResolutionScaler::update(float gpuFrameMs)
+{
+    if (gpuFrameMs <= 0.0f)
+    {
+        return this->scale;
+    }
+
+    this->smoothedFrameMs = this->smoothedFrameMs > 0.0f
+                            ? (1.0f - SMOOTHING) * this->smoothedFrameMs + SMOOTHING * gpuFrameMs
+                            : gpuFrameMs;
+
+    auto ratio = this->targetFrameMs / this->smoothedFrameMs;
+    if (std::abs(1.0f - ratio) < DEAD_BAND)
+    {
+        return this->scale;
+    }
+
+    auto desired = this->scale * std::sqrt(ratio);
+    this->scale += (desired - this->scale) * RESPONSE;
+    this->scale = std::clamp(this->scale, this->minScale, this->maxScale);
+
+    return this->scale;
+}
+
+float ResolutionScaler::getScale() const noexcept
+{
+    return this->scale;
+}
+
+float ResolutionScaler::getMaxScale() const noexcept
+{
+    return this->maxScale;
+}
+
+float ResolutionScaler::getSmoothedFrameMs() const noexcept
+{
+    return this->smoothedFrameMs;
+}
+
+uint32_t ResolutionScaler::scaled(uint32_t size) const noexcept
+{
+    return std::max(1u, static_cast<uint32_t>(static_cast<float>(size) * this->scale + 0.5f));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VkTri
+{
+    /**
+     * \brief Chooses an internal render scale from measured GPU frame times.
+     *
+     * \details
+     * GPU cost is assumed to grow with the number of shaded pixels, i.e. with the square of the scale, so the
+     * scale that would hit the target is the current scale times sqrt(target / measured). The controller only moves
+     * part of the way there each frame and ignores errors inside a small dead band, which keeps the resolution from
+     * oscillating when the frame time hovers around the target.
+     */
+    class ResolutionScaler
+    {
+    private:
+        float minScale;
+        float maxScale;
+        float targetFrameMs;
+        float scale;
+        float smoothedFrameMs = 0.0f;
+
+        static constexpr float SMOOTHING = 0.2f; /**< Weight of a new sample in the frame time average */
+        static constexpr float RESPONSE = 0.5f; /**< Fraction of the remaining error corrected per update */
+        static constexpr float DEAD_BAND = 0.05f; /**< Relative frame time error that is tolerated */
+
+    public:
+        /**
+         * \param minScale smallest allowed fraction of the output resolution, per axis.
+         * \param maxScale largest allowed fraction of the output resolution, per axis.
+         * \param targetFrameMs GPU frame time the controller aims for, in milliseconds.
+         */
+        ResolutionScaler(float minScale, float maxScale, float targetFrameMs);
+
+        /**
+         * \brief Feeds a new GPU frame time sample into the controller.
+         * \param gpuFrameMs measured GPU time of a frame rendered at the current scale.
+         * \return the scale to use for the next frame.
+         */
+        float update(float gpuFrameMs);
+
+        [[nodiscard]] float getScale() const noexcept;
+
+        [[nodiscard]] float getMaxScale() const noexcept;
+
+        [[nodiscard]] float getSmoothedFrameMs() const noexcept;
+
+        /**
+         * \brief Applies the current scale to one axis of the output resolution.
+         */
+        [[nodiscard]] uint32_t scaled(uint32_t size) const noexcept;
+    };
+}
@@ -0,0 +1,78 @@
+#include <fstream>
+#include <sstream>
+#include <fmt/format.h>
+#include "SceneDescription.hpp"
+
+using namespace VkTri;
+
+SceneDescription SceneDescription::load(const fs::path &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to open scene {:s}", path.string()));
+    }
+
+    SceneDescription scene;
+    scene.name = path.stem().string();
+
+    string line;
+    for (uint32_t lineNumber = 1u; std::getline(file, line); lineNumber++)
+    {
+        std::istringstream tokens(line);
+        string key;
+        if (!(tokens >> key) || key[0] == '#')
+        {
+            continue;
+        }
+
+        uint32_t value;
+        if (!(tokens >> value))
+        {
+            throw std::runtime_error(fmt::format("{:s}:{:d}: expected a number after '{:s}'", path.string(),
+                                                 lineNumber, key));
+        }
+
+        if (key == "width")
+        {
+            scene.extent.width = value;
+        }
+        else if (key == "height")
+        {
+            scene.extent.height = value;
+        }
+        else if (key == "frames")
+        {
+            scene.frames = value;
+        }
+        else if (key == "warmup")
+        {
+            scene.warmupFrames = value;
+        }
+        else if (key == "triangles")
+        {
+            scene.triangles = value;
+        }
+        else if (key == "quads")
+        {
+            scene.quads = value;
+        }
+        else if (key == "layers")
+        {
+            scene.layers = value;
+        }
+        else
+        {
+            throw std::runtime_error(fmt::format("{:s}:{:d}: unknown key '{:s}'", path.string(), lineNumber, key));
+        }
+    }
+
+    if (scene.extent.width == 0u || scene.extent.height == 0u || scene.frames == 0u || scene.layers == 0u ||
+        scene.layers > UINT16_MAX)
+    {
+        throw std::runtime_error(fmt::format("{:s}: size, frames and layers must be non-zero, layers at most 65535",
+                                             path.string()));
+    }
+
+    return scene;
+}
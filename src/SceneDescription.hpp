@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::string;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    /**
+     * \brief Workload rendered by a FrameRenderer, loaded from a .scene file.
+     *
+     * \details
+     * Scene files hold one "key value" pair per line. Blank lines and lines starting with # are ignored:
+     *
+     *     # 2000 overlay quads over a single triangle
+     *     width 512
+     *     height 512
+     *     frames 240
+     *     warmup 20
+     *     triangles 1
+     *     quads 2000
+     *     layers 4
+     *
+     * Keys that are left out keep the defaults below, which describe the single triangle the app draws.
+     */
+    struct SceneDescription
+    {
+        string name = "triangle"; /**< File name without extension */
+        vk::Extent2D extent{256u, 256u};
+        uint32_t frames = 120u; /**< Frames that are measured */
+        uint32_t warmupFrames = 10u; /**< Frames rendered before measuring starts */
+        uint32_t triangles = 1u; /**< Triangle draws, laid out in a square grid */
+        uint32_t quads = 0u; /**< 2D quads drawn through the batcher on top of the triangles */
+        uint32_t layers = 1u; /**< Layers the quads are spread across */
+
+        /**
+         * \brief Parses a scene file, throwing std::runtime_error on unknown keys or malformed values.
+         */
+        [[nodiscard]] static SceneDescription load(const fs::path &path);
+    };
+}
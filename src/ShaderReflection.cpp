@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <fmt/format.h>
+#include "ShaderReflection.hpp"
+
+using namespace VkTri;
+
+vector<vk::DescriptorSetLayoutBinding>
+VkTri::descriptorSetLayoutBindings(std::initializer_list<ShaderInterface> stages, uint32_t set, bool dynamicBuffers)
+{
+    vector<vk::DescriptorSetLayoutBinding> result;
+
+    for (const auto &stage : stages)
+    {
+        for (size_t i = 0; i < stage.bindingCount; i++)
+        {
+            const auto &info = stage.bindings[i];
+            if (info.set != set)
+            {
+                continue;
+            }
+
+            auto type = info.type;
+            if (dynamicBuffers && type == vk::DescriptorType::eUniformBuffer)
+            {
+                type = vk::DescriptorType::eUniformBufferDynamic;
+            }
+            else if (dynamicBuffers && type == vk::DescriptorType::eStorageBuffer)
+            {
+                type = vk::DescriptorType::eStorageBufferDynamic;
+            }
+
+            auto existing = std::find_if(result.begin(), result.end(),
+                                         [&info](const vk::DescriptorSetLayoutBinding &binding)
+                                         {
+                                             return binding.binding == info.binding;
+                                         });
+
+            if (existing == result.end())
+            {
+                result.emplace_back(info.binding, type, info.count, stage.stage);
+                continue;
+            }
+
+            if (existing->descriptorType != type || existing->descriptorCount != info.count)
+            {
+                throw std::runtime_error(fmt::format("Stages disagree on set {:d}, binding {:d} ({:s})", set,
+                                                     info.binding, info.name));
+            }
+            existing->stageFlags |= stage.stage;
+        }
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const vk::DescriptorSetLayoutBinding &a, const vk::DescriptorSetLayoutBinding &b)
+              {
+                  return a.binding < b.binding;
+              });
+
+    return result;
+}
+
+vector<vk::PushConstantRange> VkTri::pushConstantRanges(std::initializer_list<ShaderInterface> stages)
+{
+    vector<vk::PushConstantRange> result;
+
+    for (const auto &stage : stages)
+    {
+        const auto &info = stage.pushConstants;
+        if (info.size == 0u)
+        {
+            continue;
+        }
+
+        auto existing = std::find_if(result.begin(), result.end(),
+                                     [&info](const vk::PushConstantRange &range)
+                                     {
+                                         return range.offset == info.offset && range.size == info.size;
+                                     });
+
+        if (existing == result.end())
+        {
+            result.emplace_back(stage.stage, info.offset, info.size);
+        }
+        else
+        {
+            existing->stageFlags |= stage.stage;
+        }
+    }
+
+    return result;
+}
+
+vector<vk::VertexInputAttributeDescription> VkTri::vertexAttributeDescriptions(const ShaderInterface &vertexStage,
+                                                                               uint32_t binding)
+{
+    vector<vk::VertexInputAttributeDescription> result;
+    result.reserve(vertexStage.attributeCount);
+
+    for (size_t i = 0; i < vertexStage.attributeCount; i++)
+    {
+        const auto &info = vertexStage.attributes[i];
+        result.emplace_back(info.location, binding, info.format, info.offset);
+    }
+
+    return result;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <vector>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Descriptor binding declared by a shader, as found by shader_reflect.
+     */
+    struct DescriptorBindingInfo
+    {
+        uint32_t set;
+        uint32_t binding;
+        vk::DescriptorType type;
+        uint32_t count; /**< Array size of the binding */
+        uint32_t blockSize; /**< Bytes spanned by a buffer block, 0 for images and samplers */
+        const char *name;
+    };
+
+    /**
+     * \brief Push constant block of a shader. size is 0 when there is none.
+     */
+    struct PushConstantInfo
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    /**
+     * \brief Vertex shader input. Attributes are packed tightly in location order into a single binding.
+     */
+    struct VertexAttributeInfo
+    {
+        uint32_t location;
+        vk::Format format;
+        uint32_t offset;
+        const char *name;
+    };
+
+    /**
+     * \brief Resource interface of one shader stage.
+     *
+     * \details
+     * The shader build generates a header per shader under reflection/, each declaring an INTERFACE constant of
+     * this type in VkTri::Reflection::<ShaderName>. Layouts built from it cannot drift from the shaders.
+     */
+    struct ShaderInterface
+    {
+        vk::ShaderStageFlagBits stage;
+        const DescriptorBindingInfo *bindings;
+        size_t bindingCount;
+        PushConstantInfo pushConstants;
+        const VertexAttributeInfo *attributes;
+        size_t attributeCount;
+        uint32_t vertexStride;
+    };
+
+    /**
+     * \brief Merges the bindings of one descriptor set across the stages of a pipeline.
+     * \param dynamicBuffers whether uniform and storage buffers are bound with dynamic offsets.
+     * \return layout bindings sorted by binding number, with the stage flags of every stage using them.
+     */
+    [[nodiscard]] vector<vk::DescriptorSetLayoutBinding>
+    descriptorSetLayoutBindings(std::initializer_list<ShaderInterface> stages, uint32_t set, bool dynamicBuffers);
+
+    /**
+     * \brief Push constant ranges of a pipeline. Stages sharing an identical range are merged into one.
+     */
+    [[nodiscard]] vector<vk::PushConstantRange> pushConstantRanges(std::initializer_list<ShaderInterface> stages);
+
+    /**
+     * \brief Vertex attributes of a vertex shader, all sourced from the given binding.
+     */
+    [[nodiscard]] vector<vk::VertexInputAttributeDescription> vertexAttributeDescriptions(
+            const ShaderInterface &vertexStage, uint32_t binding);
+}
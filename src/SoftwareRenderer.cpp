@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fmt/format.h>
+#include <glm/vec3.hpp>
+#include "SoftwareRenderer.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace VkTri;
+
+static constexpr uint32_t TILE_PIXELS = SOFTWARE_TILE_SIZE * SOFTWARE_TILE_SIZE;
+static constexpr uint32_t SPAN_WIDTH = 4u; /**< Pixels shaded together by shadeSpan() */
+
+static_assert(SOFTWARE_TILE_SIZE % SPAN_WIDTH == 0u, "Tile rows must be made of whole spans.");
+
+// Same vertices as the constant arrays in triangle.vert.
+static const std::array<glm::vec2, 3> TRIANGLE_POSITIONS = {
+        glm::vec2(0.0f, -0.5f), glm::vec2(0.5f, 0.5f), glm::vec2(-0.5f, 0.5f)};
+static const std::array<glm::vec3, 3> TRIANGLE_COLORS = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)};
+
+unique_ptr<SoftwareRenderer> SoftwareRenderer::create(const vk::Extent2D &extent, uint32_t threadCount)
+{
+    auto renderer = std::make_unique<SoftwareRenderer>();
+    renderer->resize(extent);
+
+    if (threadCount == 0u)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // The thread calling renderFrame() shades tiles too.
+    renderer->workers.reserve(threadCount - 1u);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        renderer->workers.emplace_back(&SoftwareRenderer::workerLoop, renderer.get());
+    }
+
+    return renderer;
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->poolMutex);
+        this->stopping = true;
+    }
+    this->workReady.notify_all();
+
+    for (auto &worker : this->workers)
+    {
+        worker.join();
+    }
+}
+
+void SoftwareRenderer::resize(const vk::Extent2D &newExtent)
+{
+    this->extent = newExtent;
+    this->tilesX = (newExtent.width + SOFTWARE_TILE_SIZE - 1u) / SOFTWARE_TILE_SIZE;
+    this->tilesY = (newExtent.height + SOFTWARE_TILE_SIZE - 1u) / SOFTWARE_TILE_SIZE;
+    this->bins.resize(static_cast<size_t>(this->tilesX) * this->tilesY);
+}
+
+void SoftwareRenderer::setScene(const SceneDescription &newScene)
+{
+    this->scene = newScene;
+}
+
+std::optional<double> SoftwareRenderer::lastGpuFrameMs() const noexcept
+{
+    return std::nullopt;
+}
+
+const PipelineStatistics *SoftwareRenderer::getPipelineStatistics() const noexcept
+{
+    return nullptr;
+}
+
+string SoftwareRenderer::name() const
+{
+#if defined(__SSE2__)
+    const char *instructions = "SSE2";
+#else
+    const char *instructions = "scalar";
+#endif
+    return fmt::format("Software rasterizer ({:d} threads, {:s})", this->workers.size() + 1u, instructions);
+}
+
+size_t SoftwareRenderer::frameSize() const noexcept
+{
+    return static_cast<size_t>(this->extent.width) * this->extent.height * 4u;
+}
+
+// =====
+// Setup
+// =====
+
+void SoftwareRenderer::addTriangle(const std::array<glm::vec2, 3> &positions, const std::array<glm::vec4, 3> &colors,
+                                   Blend blend, bool cullBack)
+{
+    auto p = positions;
+    auto c = colors;
+
+    // Negative for clockwise triangles in framebuffer coordinates, which are the front faces. Degenerate
+    // triangles, NaN included, cover nothing.
+    auto area = (p[2].x - p[0].x) * (p[1].y - p[0].y) - (p[2].y - p[0].y) * (p[1].x - p[0].x);
+    if (!(std::abs(area) > 0.0f) || (cullBack && area > 0.0f))
+    {
+        return;
+    }
+
+    // Wind every triangle the same way so that the inside is positive for all edges.
+    if (area < 0.0f)
+    {
+        std::swap(p[1], p[2]);
+        std::swap(c[1], c[2]);
+        area = -area;
+    }
+
+    // Only pixels whose centers fall within the bounds and the frame can be covered.
+    auto minX = std::max(std::ceil(std::min({p[0].x, p[1].x, p[2].x}) - 0.5f), 0.0f);
+    auto minY = std::max(std::ceil(std::min({p[0].y, p[1].y, p[2].y}) - 0.5f), 0.0f);
+    auto maxX = std::min(std::floor(std::max({p[0].x, p[1].x, p[2].x}) - 0.5f),
+                         static_cast<float>(this->extent.width) - 1.0f);
+    auto maxY = std::min(std::floor(std::max({p[0].y, p[1].y, p[2].y}) - 0.5f),
+                         static_cast<float>(this->extent.height) - 1.0f);
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    SetupTriangle triangle{};
+    triangle.blend = blend;
+    triangle.originX = p[0].x;
+    triangle.originY = p[0].y;
+    triangle.minX = static_cast<uint32_t>(minX);
+    triangle.minY = static_cast<uint32_t>(minY);
+    triangle.maxX = static_cast<uint32_t>(maxX);
+    triangle.maxY = static_cast<uint32_t>(maxY);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        // Edge i is the one opposite vertex i.
+        const auto &from = p[(i + 1u) % 3u];
+        const auto &to = p[(i + 2u) % 3u];
+        triangle.edgeA[i] = to.y - from.y;
+        triangle.edgeB[i] = from.x - to.x;
+        triangle.edgeX[i] = from.x;
+        triangle.edgeY[i] = from.y;
+
+        // The gradient points inside: a top edge has the inside below it, a left edge has it to its right.
+        triangle.topLeft[i] = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] > 0.0f);
+    }
+
+    // Edge i divided by the area is the barycentric weight of vertex i.
+    for (size_t channel = 0; channel < 4; channel++)
+    {
+        triangle.colorBase[channel] = c[0][channel];
+        for (size_t i = 0; i < 3; i++)
+        {
+            triangle.colorA[channel] += c[i][channel] * triangle.edgeA[i] / area;
+            triangle.colorB[channel] += c[i][channel] * triangle.edgeB[i] / area;
+        }
+    }
+
+    auto index = static_cast<uint32_t>(this->triangles.size());
+    this->triangles.push_back(triangle);
+
+    auto firstTileX = triangle.minX / SOFTWARE_TILE_SIZE;
+    auto firstTileY = triangle.minY / SOFTWARE_TILE_SIZE;
+    auto lastTileX = triangle.maxX / SOFTWARE_TILE_SIZE;
+    auto lastTileY = triangle.maxY / SOFTWARE_TILE_SIZE;
+
+    for (auto tileY = firstTileY; tileY <= lastTileY; tileY++)
+    {
+        for (auto tileX = firstTileX; tileX <= lastTileX; tileX++)
+        {
+            auto left = static_cast<float>(tileX * SOFTWARE_TILE_SIZE) + 0.5f;
+            auto top = static_cast<float>(tileY * SOFTWARE_TILE_SIZE) + 0.5f;
+            auto right = left + static_cast<float>(SOFTWARE_TILE_SIZE - 1u);
+            auto bottom = top + static_cast<float>(SOFTWARE_TILE_SIZE - 1u);
+
+            // Evaluate each edge at the tile's extreme pixel centers along its gradient.
+            bool outside = false;
+            bool covered = true;
+            for (size_t i = 0; i < 3 && !outside; i++)
+            {
+                auto a = triangle.edgeA[i];
+                auto b = triangle.edgeB[i];
+                auto highest = a * ((a > 0.0f ? right : left) - triangle.edgeX[i]) +
+                               b * ((b > 0.0f ? bottom : top) - triangle.edgeY[i]);
+                auto lowest = a * ((a > 0.0f ? left : right) - triangle.edgeX[i]) +
+                              b * ((b > 0.0f ? top : bottom) - triangle.edgeY[i]);
+                outside = highest < 0.0f;
+                covered = covered && lowest > 0.0f;
+            }
+
+            if (!outside)
+            {
+                this->bins[tileY * this->tilesX + tileX].push_back(index | (covered ? FULL_TILE_BIT : 0u));
+            }
+        }
+    }
+}
+
+// =======
+// Shading
+// =======
+
+#if defined(__SSE2__)
+
+template <int SHIFT>
+static inline __m128 unpackChannel(__m128i pixels)
+{
+    auto bytes = _mm_and_si128(_mm_srli_epi32(pixels, SHIFT), _mm_set1_epi32(0xFF));
+    return _mm_mul_ps(_mm_cvtepi32_ps(bytes), _mm_set1_ps(1.0f / 255.0f));
+}
+
+static inline __m128 saturate(__m128 value)
+{
+    return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+void SoftwareRenderer::shadeSpan(const SetupTriangle &triangle, bool covered, float x, float y, uint32_t *span)
+{
+    auto xs = _mm_add_ps(_mm_set1_ps(x), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+    auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    if (!covered)
+    {
+        for (size_t i = 0; i < 3; i++)
+        {
+            auto edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[i]),
+                                              _mm_sub_ps(xs, _mm_set1_ps(triangle.edgeX[i]))),
+                                   _mm_set1_ps(triangle.edgeB[i] * (y - triangle.edgeY[i])));
+            auto onEdge = triangle.topLeft[i] ? _mm_cmpeq_ps(edge, _mm_setzero_ps()) : _mm_setzero_ps();
+            inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edge, _mm_setzero_ps()), onEdge));
+        }
+
+        if (_mm_movemask_ps(inside) == 0)
+        {
+            return;
+        }
+    }
+
+    auto dx = _mm_sub_ps(xs, _mm_set1_ps(triangle.originX));
+    auto dy = y - triangle.originY;
+    __m128 color[4];
+    for (size_t channel = 0; channel < 4; channel++)
+    {
+        auto value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.colorA[channel]), dx),
+                                _mm_set1_ps(triangle.colorBase[channel] + triangle.colorB[channel] * dy));
+        color[channel] = saturate(value);
+    }
+
+    auto destination = _mm_load_si128(reinterpret_cast<const __m128i *>(span));
+    if (triangle.blend != Blend::Opaque)
+    {
+        auto alpha = color[3];
+        auto inverseAlpha = _mm_sub_ps(_mm_set1_ps(1.0f), alpha);
+        auto destinationFactor = triangle.blend == Blend::Additive ? _mm_set1_ps(1.0f) : inverseAlpha;
+
+        __m128 previous[4] = {unpackChannel<0>(destination), unpackChannel<8>(destination),
+                              unpackChannel<16>(destination), unpackChannel<24>(destination)};
+        for (size_t channel = 0; channel < 3; channel++)
+        {
+            color[channel] = saturate(_mm_add_ps(_mm_mul_ps(color[channel], alpha),
+                                                 _mm_mul_ps(previous[channel], destinationFactor)));
+        }
+        color[3] = saturate(_mm_add_ps(alpha, _mm_mul_ps(previous[3], inverseAlpha)));
+    }
+
+    // Pixels are packed little-endian, so their bytes read R, G, B, A in memory.
+    auto scale = _mm_set1_ps(255.0f);
+    auto packed = _mm_or_si128(
+            _mm_or_si128(_mm_cvtps_epi32(_mm_mul_ps(color[0], scale)),
+                         _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(color[1], scale)), 8)),
+            _mm_or_si128(_mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(color[2], scale)), 16),
+                         _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(color[3], scale)), 24)));
+
+    auto mask = _mm_castps_si128(inside);
+    auto result = _mm_or_si128(_mm_and_si128(mask, packed), _mm_andnot_si128(mask, destination));
+    _mm_store_si128(reinterpret_cast<__m128i *>(span), result);
+}
+
+#else
+
+void SoftwareRenderer::shadeSpan(const SetupTriangle &triangle, bool covered, float x, float y, uint32_t *span)
+{
+    for (uint32_t lane = 0; lane < SPAN_WIDTH; lane++)
+    {
+        auto px = x + static_cast<float>(lane);
+
+        bool inside = true;
+        for (size_t i = 0; i < 3 && inside && !covered; i++)
+        {
+            auto edge = triangle.edgeA[i] * (px - triangle.edgeX[i]) + triangle.edgeB[i] * (y - triangle.edgeY[i]);
+            inside = edge > 0.0f || (edge == 0.0f && triangle.topLeft[i]);
+        }
+
+        if (!inside)
+        {
+            continue;
+        }
+
+        std::array<float, 4> color{};
+        for (size_t channel = 0; channel < 4; channel++)
+        {
+            auto value = triangle.colorBase[channel] + triangle.colorA[channel] * (px - triangle.originX) +
+                         triangle.colorB[channel] * (y - triangle.originY);
+            color[channel] = std::clamp(value, 0.0f, 1.0f);
+        }
+
+        if (triangle.blend != Blend::Opaque)
+        {
+            auto alpha = color[3];
+            auto destinationFactor = triangle.blend == Blend::Additive ? 1.0f : 1.0f - alpha;
+            for (size_t channel = 0; channel < 4; channel++)
+            {
+                auto previous = static_cast<float>((span[lane] >> (8u * channel)) & 0xFFu) / 255.0f;
+                auto factor = channel == 3u ? 1.0f - alpha : destinationFactor;
+                auto source = channel == 3u ? alpha : color[channel] * alpha;
+                color[channel] = std::clamp(source + previous * factor, 0.0f, 1.0f);
+            }
+        }
+
+        // Pixels are packed little-endian, so their bytes read R, G, B, A in memory.
+        uint32_t packed = 0u;
+        for (size_t channel = 0; channel < 4; channel++)
+        {
+            packed |= static_cast<uint32_t>(std::nearbyint(color[channel] * 255.0f)) << (8u * channel);
+        }
+        span[lane] = packed;
+    }
+}
+
+#endif
+
+void SoftwareRenderer::rasterizeTile(uint32_t tileIndex)
+{
+    alignas(16) std::array<uint32_t, TILE_PIXELS> tile;
+    tile.fill(this->clearValue);
+
+    auto tileX = (tileIndex % this->tilesX) * SOFTWARE_TILE_SIZE;
+    auto tileY = (tileIndex / this->tilesX) * SOFTWARE_TILE_SIZE;
+
+    for (auto entry : this->bins[tileIndex])
+    {
+        const auto &triangle = this->triangles[entry & ~FULL_TILE_BIT];
+        bool covered = (entry & FULL_TILE_BIT) != 0u;
+
+        // Small triangles only touch a few rows and spans of the tile.
+        auto firstRow = std::max(triangle.minY, tileY) - tileY;
+        auto lastRow = std::min(triangle.maxY - tileY, SOFTWARE_TILE_SIZE - 1u);
+        auto firstColumn = (std::max(triangle.minX, tileX) - tileX) / SPAN_WIDTH * SPAN_WIDTH;
+        auto lastColumn = std::min(triangle.maxX - tileX, SOFTWARE_TILE_SIZE - 1u);
+
+        for (auto row = firstRow; row <= lastRow; row++)
+        {
+            auto y = static_cast<float>(tileY + row) + 0.5f;
+            for (auto column = firstColumn; column <= lastColumn; column += SPAN_WIDTH)
+            {
+                SoftwareRenderer::shadeSpan(triangle, covered, static_cast<float>(tileX + column) + 0.5f, y,
+                                            &tile[row * SOFTWARE_TILE_SIZE + column]);
+            }
+        }
+    }
+
+    // Tiles on the right and bottom borders may stick out of the frame.
+    auto width = std::min(SOFTWARE_TILE_SIZE, this->extent.width - tileX);
+    auto height = std::min(SOFTWARE_TILE_SIZE, this->extent.height - tileY);
+    for (uint32_t row = 0; row < height; row++)
+    {
+        auto offset = (static_cast<size_t>(tileY + row) * this->extent.width + tileX) * 4u;
+        std::memcpy(this->target + offset, &tile[row * SOFTWARE_TILE_SIZE], width * 4u);
+    }
+}
+
+// ==========
+// Scheduling
+// ==========
+
+void SoftwareRenderer::rasterizeTiles()
+{
+    auto tileCount = static_cast<uint32_t>(this->bins.size());
+    for (auto tile = this->nextTile.fetch_add(1u); tile < tileCount; tile = this->nextTile.fetch_add(1u))
+    {
+        this->rasterizeTile(tile);
+    }
+}
+
+void SoftwareRenderer::workerLoop()
+{
+    uint64_t lastGeneration = 0u;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->poolMutex);
+            this->workReady.wait(lock, [&] { return this->stopping || this->generation != lastGeneration; });
+            if (this->stopping)
+            {
+                return;
+            }
+            lastGeneration = this->generation;
+        }
+
+        this->rasterizeTiles();
+
+        std::lock_guard<std::mutex> lock(this->poolMutex);
+        if (--this->busyWorkers == 0u)
+        {
+            this->workDone.notify_one();
+        }
+    }
+}
+
+void SoftwareRenderer::renderFrame(uint64_t jobIndex, vector<uint8_t> &pixels)
+{
+    pixels.resize(this->frameSize());
+    this->target = pixels.data();
+
+    auto clearColor = FrameRenderer::jobClearColor(jobIndex);
+    std::memcpy(&this->clearValue, clearColor.data(), sizeof(this->clearValue));
+
+    this->triangles.clear();
+    for (auto &bin : this->bins)
+    {
+        bin.clear();
+    }
+
+    // Same transforms as triangle.vert followed by the viewport transform.
+    glm::vec2 size(static_cast<float>(this->extent.width), static_cast<float>(this->extent.height));
+    auto transform = SceneUniforms::rotated(0.1f * static_cast<float>(jobIndex), size.x / size.y).transform;
+    for (uint32_t i = 0; i < this->scene.triangles; i++)
+    {
+        auto constants = FrameRenderer::gridCell(this->scene.triangles, i);
+
+        std::array<glm::vec2, 3> positions;
+        std::array<glm::vec4, 3> colors;
+        for (size_t vertex = 0; vertex < 3; vertex++)
+        {
+            auto position = TRIANGLE_POSITIONS[vertex] * constants.scale + constants.offset;
+            auto clip = transform * glm::vec4(position, 0.0f, 1.0f);
+            positions[vertex] = (glm::vec2(clip) / clip.w + 1.0f) * 0.5f * size;
+            colors[vertex] = glm::vec4(TRIANGLE_COLORS[vertex] * glm::vec3(constants.tint), 1.0f);
+        }
+        this->addTriangle(positions, colors, Blend::Opaque, true);
+    }
+
+    // Overlay vertices are already in pixels. Textured draws blend like solid ones.
+    if (this->scene.quads > 0u)
+    {
+        FrameRenderer::buildOverlay(this->scene, this->extent, jobIndex, this->overlay);
+
+        const auto &vertices = this->overlay.getVertices();
+        const auto &indices = this->overlay.getIndices();
+        for (const auto &draw : this->overlay.getDraws())
+        {
+            auto blend = draw.pipeline == Pipeline2D::Additive ? Blend::Additive : Blend::Alpha;
+            for (auto i = draw.firstIndex; i + 3u <= draw.firstIndex + draw.indexCount; i += 3u)
+            {
+                const auto &a = vertices[indices[i]];
+                const auto &b = vertices[indices[i + 1u]];
+                const auto &c = vertices[indices[i + 2u]];
+                this->addTriangle({a.position, b.position, c.position}, {a.color, b.color, c.color}, blend, false);
+            }
+        }
+    }
+
+    this->nextTile.store(0u);
+    {
+        std::lock_guard<std::mutex> lock(this->poolMutex);
+        this->generation++;
+        this->busyWorkers = static_cast<uint32_t>(this->workers.size());
+    }
+    this->workReady.notify_all();
+
+    this->rasterizeTiles();
+
+    std::unique_lock<std::mutex> lock(this->poolMutex);
+    this->workDone.wait(lock, [this] { return this->busyWorkers == 0u; });
+    this->target = nullptr;
+}
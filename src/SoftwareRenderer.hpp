@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "FrameRenderer.hpp"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+namespace VkTri
+{
+    static constexpr uint32_t SOFTWARE_TILE_SIZE = 8u; /**< Width and height of a tile in pixels */
+
+    /**
+     * \brief Renders the scene on the CPU, for machines without a usable Vulkan device.
+     *
+     * \details
+     * Frames go through the same FrameRenderer interface as OffscreenRenderer and match its output: the grid of
+     * triangles with interpolated vertex colors and back faces culled, then the overlay quads with their blend
+     * modes. Textured 2D primitives are drawn with their vertex color only.
+     *
+     * Each frame is set up on the calling thread. Triangles are transformed to pixel coordinates, turned into
+     * edge functions and attribute planes, and binned into 8x8 tiles. Tiles are then shaded in parallel by a pool
+     * of worker threads and the calling thread. A tile is shaded into a local buffer that stays in cache and is
+     * written to the frame once, and tiles a triangle fully covers skip the edge tests. Pixels are evaluated four
+     * at a time with SSE2 where available, with a scalar fallback elsewhere. Rasterization follows the Vulkan
+     * rules: samples at pixel centers and the top-left fill convention.
+     *
+     * Bins and vertex data keep their capacity between frames, so frames stop allocating once every tile has seen
+     * its busiest frame.
+     */
+    class SoftwareRenderer : public FrameRenderer
+    {
+    private:
+        enum class Blend : uint8_t
+        {
+            Opaque,
+            Alpha, /**< Pipeline2D::Solid */
+            Additive /**< Pipeline2D::Additive */
+        };
+
+        /**
+         * \brief Triangle ready for rasterization, in pixel coordinates.
+         *
+         * \details
+         * Edge i evaluates to edgeA[i] * (x - edgeX[i]) + edgeB[i] * (y - edgeY[i]) and is positive on the inside.
+         * Color channel c interpolates to colorBase[c] + colorA[c] * (x - originX) + colorB[c] * (y - originY).
+         * Both are kept relative to a vertex so that samples lying exactly on an edge evaluate to exactly zero.
+         */
+        struct SetupTriangle
+        {
+            std::array<float, 3> edgeA;
+            std::array<float, 3> edgeB;
+            std::array<float, 3> edgeX;
+            std::array<float, 3> edgeY;
+            std::array<bool, 3> topLeft; /**< Whether samples exactly on the edge are inside */
+            float originX;
+            float originY;
+            uint32_t minX; /**< Bounds of the pixels the triangle may cover, inclusive */
+            uint32_t minY;
+            uint32_t maxX;
+            uint32_t maxY;
+            std::array<float, 4> colorBase;
+            std::array<float, 4> colorA;
+            std::array<float, 4> colorB;
+            Blend blend;
+        };
+
+        static constexpr uint32_t FULL_TILE_BIT = 0x80000000u; /**< Set on bin entries that cover the whole tile */
+
+        vk::Extent2D extent;
+        uint32_t tilesX = 0u;
+        uint32_t tilesY = 0u;
+
+        SceneDescription scene;
+        Batcher2D overlay;
+
+        vector<SetupTriangle> triangles; /**< Current frame's triangles, in draw order */
+        vector<vector<uint32_t>> bins; /**< Per tile, indices into triangles in draw order */
+        uint8_t *target = nullptr; /**< Frame being rendered, valid during renderFrame() */
+        uint32_t clearValue = 0u; /**< Packed RGBA8 clear color of the current frame */
+
+        vector<std::thread> workers;
+        std::mutex poolMutex;
+        std::condition_variable workReady;
+        std::condition_variable workDone;
+        uint64_t generation = 0u; /**< Incremented for every frame handed to the workers */
+        uint32_t busyWorkers = 0u;
+        bool stopping = false;
+        std::atomic<uint32_t> nextTile{0u};
+
+        /**
+         * \brief Sets up a triangle and bins it into every tile it may cover.
+         * \param positions vertices in pixel coordinates.
+         * \param colors RGBA vertex colors.
+         * \param blend how the triangle combines with the frame.
+         * \param cullBack whether counter-clockwise triangles are discarded, matching TrianglePipeline.
+         */
+        void addTriangle(const std::array<glm::vec2, 3> &positions, const std::array<glm::vec4, 3> &colors,
+                         Blend blend, bool cullBack);
+
+        /**
+         * \brief Shades four horizontally adjacent pixels of a tile buffer with the triangle.
+         * \param covered whether the triangle is known to cover the pixels, which skips the edge tests.
+         * \param x center of the first pixel.
+         * \param y center of the pixels.
+         * \param span first of the four pixels, 16-byte aligned.
+         */
+        static void shadeSpan(const SetupTriangle &triangle, bool covered, float x, float y, uint32_t *span);
+
+        void rasterizeTile(uint32_t tileIndex);
+
+        /**
+         * \brief Shades tiles until none are left in the current frame.
+         */
+        void rasterizeTiles();
+
+        void workerLoop();
+
+    public:
+        /**
+         * \brief Creates a renderer and its worker threads.
+         * \param extent size of the rendered frames.
+         * \param threadCount threads shading tiles, including the one calling renderFrame(). 0 uses every core.
+         */
+        [[nodiscard]] static unique_ptr<SoftwareRenderer> create(const vk::Extent2D &extent,
+                                                                 uint32_t threadCount = 0u);
+
+        ~SoftwareRenderer() override;
+
+        /**
+         * \brief Changes the size of subsequent frames.
+         */
+        void resize(const vk::Extent2D &newExtent);
+
+        /**
+         * \brief Renders one frame on the CPU directly into the provided vector.
+         */
+        void renderFrame(uint64_t jobIndex, vector<uint8_t> &pixels) override;
+
+        void setScene(const SceneDescription &scene) override;
+
+        /**
+         * \brief Always empty, there is no GPU involved.
+         */
+        [[nodiscard]] std::optional<double> lastGpuFrameMs() const noexcept override;
+
+        /**
+         * \brief Always null, there is no GPU involved.
+         */
+        [[nodiscard]] const PipelineStatistics *getPipelineStatistics() const noexcept override;
+
+        [[nodiscard]] string name() const override;
+
+        [[nodiscard]] size_t frameSize() const noexcept override;
+    };
+}
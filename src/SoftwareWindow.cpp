@@ -0,0 +1,90 @@
+#include <stdexcept>
+#include "SoftwareWindow.hpp"
+
+using namespace VkTri;
+
+unique_ptr<SoftwareWindow> SoftwareWindow::create(uint32_t width, uint32_t height)
+{
+    auto softwareWindow = std::make_unique<SoftwareWindow>();
+
+    // The default hints ask for an OpenGL context, whose fixed-function pixel path is all that is used.
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    softwareWindow->window = glfwCreateWindow(static_cast<int>(width), static_cast<int>(height),
+                                              "Vulkan Triangle (software)", nullptr, nullptr);
+    if (softwareWindow->window == nullptr)
+    {
+        // Headless machines and drivers without OpenGL, the same ones that lack Vulkan, end up here.
+        throw std::runtime_error("Failed to create an OpenGL window for the software renderer.");
+    }
+    glfwMakeContextCurrent(softwareWindow->window);
+    glfwSwapInterval(1);
+
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(softwareWindow->window, &framebufferWidth, &framebufferHeight);
+    softwareWindow->renderer = SoftwareRenderer::create(vk::Extent2D(static_cast<uint32_t>(framebufferWidth),
+                                                                     static_cast<uint32_t>(framebufferHeight)));
+
+    glfwSetWindowUserPointer(softwareWindow->window, softwareWindow.get());
+    glfwSetWindowRefreshCallback(softwareWindow->window, SoftwareWindow::onWindowRefresh);
+    glfwSetFramebufferSizeCallback(softwareWindow->window, SoftwareWindow::onFramebufferResize);
+
+    return softwareWindow;
+}
+
+SoftwareWindow::~SoftwareWindow()
+{
+    this->renderer.reset();
+    if (this->window != nullptr)
+    {
+        glfwDestroyWindow(this->window);
+    }
+}
+
+void SoftwareWindow::onWindowRefresh(GLFWwindow *window)
+{
+    auto softwareWindow = static_cast<SoftwareWindow *>(glfwGetWindowUserPointer(window));
+    softwareWindow->redrawNeeded = true;
+}
+
+void SoftwareWindow::onFramebufferResize(GLFWwindow *window, int width, int height)
+{
+    auto softwareWindow = static_cast<SoftwareWindow *>(glfwGetWindowUserPointer(window));
+    softwareWindow->redrawNeeded = true;
+}
+
+void SoftwareWindow::run()
+{
+    while (!glfwWindowShouldClose(this->window))
+    {
+        if (this->redrawNeeded)
+        {
+            this->drawFrame();
+        }
+        glfwWaitEvents();
+    }
+}
+
+void SoftwareWindow::drawFrame()
+{
+    int width, height;
+    glfwGetFramebufferSize(this->window, &width, &height);
+
+    // Minimized, nothing to draw until the window is restored.
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+
+    this->renderer->resize(vk::Extent2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
+    this->renderer->renderFrame(0u, this->pixels);
+
+    // Rows are stored top to bottom, so they are drawn downwards from the top-left corner.
+    glViewport(0, 0, width, height);
+    glRasterPos2f(-1.0f, 1.0f);
+    glPixelZoom(1.0f, -1.0f);
+    glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, this->pixels.data());
+
+    glfwSwapBuffers(this->window);
+    this->redrawNeeded = false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+extern "C"
+{
+#include <glfw3.h>
+}
+
+#include "SoftwareRenderer.hpp"
+
+using std::vector;
+using std::unique_ptr;
+
+namespace VkTri
+{
+    /**
+     * \brief Shows the triangle in a window on machines without a usable Vulkan device.
+     *
+     * \details
+     * Frames are drawn by SoftwareRenderer at the size of the window's framebuffer. The window has a plain OpenGL
+     * context, used for nothing but copying each finished frame to the screen with glDrawPixels. Like TriangleApp,
+     * it only redraws when the window was exposed or resized, and sleeps in glfwWaitEvents() in between.
+     */
+    class SoftwareWindow
+    {
+    private:
+        GLFWwindow *window = nullptr;
+        unique_ptr<SoftwareRenderer> renderer;
+        vector<uint8_t> pixels;
+        bool redrawNeeded = true;
+
+        static void onWindowRefresh(GLFWwindow *window);
+
+        static void onFramebufferResize(GLFWwindow *window, int width, int height);
+
+        void drawFrame();
+
+    public:
+        /**
+         * \brief Opens the window and starts the renderer's threads. GLFW must be initialized.
+         * \throws std::runtime_error if no OpenGL window can be created.
+         */
+        [[nodiscard]] static unique_ptr<SoftwareWindow> create(uint32_t width, uint32_t height);
+
+        ~SoftwareWindow();
+
+        /**
+         * \brief Shows frames until the window is closed.
+         */
+        void run();
+    };
+}
@@ -4,9 +4,11 @@
 #include <array>
 #include <algorithm>
 #include <fstream>
-#include <thread>
 #include <cstring>
+#include <cmath>
 #include <fmt/format.h>
+#include <glm/gtc/constants.hpp>
+#include "DeviceSetup.hpp"
 #include "TriangleApp.hpp"
 
 using std::array;
@@ -31,7 +33,7 @@ shared_ptr<TriangleApp> TriangleApp::create()
     auto triApp = std::make_shared<TriangleApp>();
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     triApp->window = glfwCreateWindow(TriangleApp::WIDTH, TriangleApp::HEIGHT, "Vulkan Triangle", nullptr, nullptr);
 
@@ -40,9 +42,20 @@ shared_ptr<TriangleApp> TriangleApp::create()
     triApp->createSurface();
     triApp->pickPhysicalDevice();
     triApp->createLogicalDevice();
-    triApp->createSemaphores();
+    triApp->createSyncObjects();
     triApp->createSwapChain();
+    triApp->createRenderPass();
+    triApp->createFrameGraph();
     triApp->createGraphicsPipeline();
+    triApp->createCommandBuffers();
+
+    glfwSetWindowUserPointer(triApp->window, triApp.get());
+    glfwSetWindowRefreshCallback(triApp->window, TriangleApp::onWindowRefresh);
+    glfwSetFramebufferSizeCallback(triApp->window, TriangleApp::onFramebufferResize);
+    glfwSetWindowIconifyCallback(triApp->window, TriangleApp::onWindowIconify);
+    glfwSetKeyCallback(triApp->window, TriangleApp::onKey);
+    glfwSetCursorPosCallback(triApp->window, TriangleApp::onCursorPos);
+    glfwSetMouseButtonCallback(triApp->window, TriangleApp::onMouseButton);
 
     glfwShowWindow(triApp->window);
 
@@ -53,17 +66,256 @@ void TriangleApp::run()
 {
     while (!glfwWindowShouldClose(this->window))
     {
-        glfwPollEvents();
+        if (this->animating || this->needsFrame())
+        {
+            glfwPollEvents();
+        }
+        else
+        {
+            this->waitForDamage();
+        }
+
+        // Input that does not lead to a frame would otherwise be charged to whichever frame comes next.
+        if (!this->animating && !this->needsFrame())
+        {
+            this->presentTimer.discardInput();
+            continue;
+        }
+
+        // Nothing can be shown until the window is restored or resized, which wakes glfwWaitEvents(). Polling
+        // here would spin in animation mode.
+        if (this->windowIconified)
+        {
+            this->presentTimer.discardInput();
+            glfwWaitEvents();
+            continue;
+        }
+
+        if (this->swapChainOutOfDate && !this->recreateSwapChain())
+        {
+            this->presentTimer.discardInput();
+            glfwWaitEvents();
+            continue;
+        }
+
+        if (this->redrawDeadline.has_value() && glfwGetTime() >= this->redrawDeadline.value())
+        {
+            this->redrawDeadline.reset();
+        }
 
-        // Reduce CPU usage by making the thread sleep.
-        // This should be changed to follow the rendering pipeline later.
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        // Cleared before rendering, so an invalidate() racing with this frame still produces another one.
+        this->sceneDirty = false;
+        this->drawFrame();
     }
     this->cleanup();
 }
 
+// ============
+// Damage
+// ============
+
+bool TriangleApp::needsFrame() const
+{
+    if (this->windowIconified)
+    {
+        return false;
+    }
+
+    return this->sceneDirty || this->swapChainOutOfDate ||
+           (this->redrawDeadline.has_value() && glfwGetTime() >= this->redrawDeadline.value());
+}
+
+void TriangleApp::waitForDamage()
+{
+    if (!this->deletionQueue.empty())
+    {
+        for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; slot++)
+        {
+            this->frameCompletion->wait(slot);
+        }
+        this->completedFrames = this->submittedFrames;
+        this->deletionQueue.collect(this->completedFrames);
+    }
+
+    if (this->redrawDeadline.has_value())
+    {
+        auto remaining = this->redrawDeadline.value() - glfwGetTime();
+        if (remaining > 0.0)
+        {
+            glfwWaitEventsTimeout(remaining);
+        }
+
+        if (glfwGetTime() >= this->redrawDeadline.value())
+        {
+            this->redrawDeadline.reset();
+            this->sceneDirty = true;
+        }
+    }
+    else
+    {
+        glfwWaitEvents();
+    }
+}
+
+void TriangleApp::invalidate()
+{
+    this->sceneDirty = true;
+    glfwPostEmptyEvent();
+}
+
+void TriangleApp::scheduleRedraw(double delaySeconds)
+{
+    auto deadline = glfwGetTime() + delaySeconds;
+    if (!this->redrawDeadline.has_value() || deadline < this->redrawDeadline.value())
+    {
+        this->redrawDeadline = deadline;
+    }
+}
+
+void TriangleApp::setAnimating(bool animate)
+{
+    if (animate && !this->animating)
+    {
+        // Resume from the current angle instead of catching up on the time spent idle.
+        this->lastFrameTime = glfwGetTime();
+    }
+    this->animating = animate;
+    std::clog << fmt::format("Animation mode {:s}\n", animate ? "on" : "off");
+    this->invalidate();
+}
+
+bool TriangleApp::isAnimating() const noexcept
+{
+    return this->animating;
+}
+
+void TriangleApp::setOverdrawView(bool enabled)
+{
+    if (enabled == this->showOverdraw)
+    {
+        return;
+    }
+
+    // The overdraw pass and its count target are part of the frame graph, which frames in flight still use.
+    this->showOverdraw = enabled;
+    this->retireFrameGraph();
+    this->createFrameGraph();
+
+    std::clog << fmt::format("Overdraw view {:s}\n", enabled ? "on" : "off");
+    this->invalidate();
+}
+
+bool TriangleApp::isOverdrawView() const noexcept
+{
+    return this->showOverdraw;
+}
+
+void TriangleApp::onWindowRefresh(GLFWwindow *window)
+{
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->sceneDirty = true;
+}
+
+void TriangleApp::onFramebufferResize(GLFWwindow *window, int width, int height)
+{
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->swapChainOutOfDate = true;
+}
+
+void TriangleApp::onWindowIconify(GLFWwindow *window, int iconified)
+{
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->windowIconified = iconified == GLFW_TRUE;
+    if (!app->windowIconified)
+    {
+        app->sceneDirty = true;
+    }
+}
+
+void TriangleApp::onKey(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+    {
+        return;
+    }
+
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->presentTimer.inputEvent(glfwGetTime());
+    switch (key)
+    {
+        case GLFW_KEY_A:
+            app->setAnimating(!app->animating);
+            break;
+        case GLFW_KEY_G:
+            app->showFrameTimes = !app->showFrameTimes;
+            app->invalidate();
+            break;
+        case GLFW_KEY_O:
+            app->setOverdrawView(!app->showOverdraw);
+            break;
+        case GLFW_KEY_P:
+            app->printFrameStatistics();
+            break;
+        default:
+            break;
+    }
+}
+
+void TriangleApp::onCursorPos(GLFWwindow *window, double x, double y)
+{
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->presentTimer.inputEvent(glfwGetTime());
+}
+
+void TriangleApp::onMouseButton(GLFWwindow *window, int button, int action, int mods)
+{
+    auto app = static_cast<TriangleApp *>(glfwGetWindowUserPointer(window));
+    app->presentTimer.inputEvent(glfwGetTime());
+}
+
+MemoryStats TriangleApp::getMemoryStats() const
+{
+    return this->memoryTracker->snapshot();
+}
+
 void TriangleApp::cleanup()
 {
+    if (this->logicalDevice)
+    {
+        this->logicalDevice->waitIdle();
+    }
+    this->deletionQueue.flush();
+    this->presentTimer.setBackend(nullptr);
+
+    // Members would otherwise be destroyed in declaration order, which would release the surface and device
+    // before the objects created from them.
+    this->pipelineStatistics.reset();
+    this->timestampPool.reset();
+    this->frameCompletion.reset();
+    this->renderingDoneSemaphores.clear();
+    this->imgAvailableSemaphores.clear();
+    this->commandBuffers.clear();
+    this->commandPool.reset();
+    this->overlayRenderer.reset();
+    this->overlayFramebuffers.clear();
+    this->overlayPass.reset();
+    this->descriptors.reset();
+    this->uniformRing.reset();
+    this->pipeline = TrianglePipeline();
+    this->overdrawPipeline = TrianglePipeline();
+    this->overdrawHeatmap.reset();
+    this->descriptorLayouts.reset();
+    this->overdrawFramebuffer.reset();
+    this->sceneFramebuffer.reset();
+    this->frameGraph.reset();
+    this->memoryTracker.reset();
+    this->renderPass.reset();
+    this->swapChainImageViews.clear();
+    this->swapChain.reset();
+    this->logicalDevice.reset();
+    this->surface.reset();
+    this->instance.reset();
+
     glfwDestroyWindow(this->window);
     this->window = nullptr;
 }
@@ -92,7 +344,7 @@ vector<uint8_t> TriangleApp::readFile(const fs::path &filePath)
 
 void TriangleApp::setupDebugMessenger()
 {
-    if (!enableValidationLayers) return;
+    if (!this->validationEnabled) return;
 
     auto messageSeverity =
             vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning |
@@ -139,15 +391,13 @@ vk::Bool32 TriangleApp::debugCallback(vk::DebugUtilsMessageSeverityFlagBitsEXT s
 void TriangleApp::createInstance()
 {
     // Set up dynamic extension loading.
-    vk::DynamicLoader dynaLoader;
-    auto vkGetInstanceProcAddr = dynaLoader.getProcAddress<PFN_vkGetInstanceProcAddr>(
-            "vkGetInstanceProcAddr");
-    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+    loadVulkan();
 
-    // Check for Validation Layers if they are in use
-    if (enableValidationLayers && !this->checkValidationLayerSupport())
+    // Check for Validation Layers if they are in use, a machine without them still runs the app
+    if (this->validationEnabled && !this->checkValidationLayerSupport())
     {
-        throw std::runtime_error("Validation layers requested but not available.");
+        std::clog << "Validation layers requested but not available, continuing without them.\n";
+        this->validationEnabled = false;
     }
 
     // Set up app info
@@ -163,17 +413,17 @@ void TriangleApp::createInstance()
     createInfo.pApplicationInfo = &appInfo;
 
     // Set up required extensions
-    auto requiredExts = TriangleApp::getRequiredExtensions();
+    auto requiredExts = this->getRequiredExtensions();
 
     if (!TriangleApp::checkExtensionSupport(requiredExts.data(), requiredExts.size()))
     {
-        throw std::runtime_error("Missing required Vulkan extensions.");
+        throw VulkanUnavailable("Missing required Vulkan extensions.");
     }
 
     createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExts.size());
     createInfo.ppEnabledExtensionNames = requiredExts.data();
 
-    if (enableValidationLayers)
+    if (this->validationEnabled)
     {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
         createInfo.ppEnabledLayerNames = validationLayers.data();
@@ -184,7 +434,14 @@ void TriangleApp::createInstance()
     }
 
     // Add instance to the dispatch loader.
-    this->instance = vk::createInstanceUnique(createInfo);
+    try
+    {
+        this->instance = vk::createInstanceUnique(createInfo);
+    }
+    catch (const vk::SystemError &err)
+    {
+        throw VulkanUnavailable(fmt::format("Failed to create a Vulkan instance: {:s}", err.what()));
+    }
     VULKAN_HPP_DEFAULT_DISPATCHER.init(*this->instance);
 }
 
@@ -308,9 +565,14 @@ void TriangleApp::createSwapChain()
     createInfo.imageFormat = surfaceFormat.format;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1u;
-    createInfo.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
+    // The scene is rendered offscreen and blitted into the swap chain image, then the overlay is drawn on top.
+    createInfo.imageUsage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eColorAttachment;
+    if ((swapChainSupport.capabilities.supportedUsageFlags & createInfo.imageUsage) != createInfo.imageUsage)
+    {
+        throw std::runtime_error("Swap chain images cannot be used as a transfer destination and color attachment.");
+    }
 
-    auto queueIndices = this->checkQueueFamilies(this->physicalDevice);
+    const auto &queueIndices = this->queueFamilies;
     array<uint32_t, 2> queueFamilyIndices = {queueIndices.graphicsFamily.value(), queueIndices.presentFamily.value()};
 
     // Deal with the situation in which the required queues are different
@@ -331,148 +593,717 @@ void TriangleApp::createSwapChain()
     createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
+    // Lets the presentation engine hand resources over from the swap chain being replaced, if any.
+    createInfo.oldSwapchain = this->swapChain.get();
 
-    vk::UniqueSwapchainKHR uniqueSC;
-    try
+    // Passing the old swap chain here must not race with the waiter thread, so presents still pending on it
+    // resolve first and the waiter lets go of it. It is only retired below, not destroyed yet.
+    this->presentTimer.setBackend(nullptr);
+
+    auto swapChain = this->logicalDevice->createSwapchainKHRUnique(createInfo);
+    if (this->swapChain)
     {
-        uniqueSC = logicalDevice->createSwapchainKHRUnique(createInfo);
+        this->deletionQueue.defer(this->submittedFrames, std::move(this->swapChain));
     }
-    catch (const std::runtime_error &err)
+    this->swapChain = std::move(swapChain);
+    this->swapChainImages = this->logicalDevice->getSwapchainImagesKHR(this->swapChain.get());
+
+    this->swapChainImageFormat = surfaceFormat.format;
+    this->swapChainExtent = extent;
+
+    if (this->presentWaitSupported)
     {
-        throw err;
+        this->presentTimer.setBackend(std::make_unique<SwapchainPresentWait>(
+                this->logicalDevice.get(), this->swapChain.get(), this->swapChainMutex, glfwGetTime));
     }
 
-    this->swapChain = &uniqueSC.get();
+    if (!this->swapChainImageViews.empty())
+    {
+        this->deletionQueue.defer(this->submittedFrames, std::move(this->swapChainImageViews));
+        this->swapChainImageViews.clear();
+    }
+    for (const auto &image : this->swapChainImages)
+    {
+        vk::ImageViewCreateInfo viewInfo;
+        viewInfo.image = image;
+        viewInfo.viewType = vk::ImageViewType::e2D;
+        viewInfo.format = this->swapChainImageFormat;
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+        this->swapChainImageViews.push_back(this->logicalDevice->createImageViewUnique(viewInfo));
+    }
+}
 
-    this->swapChainImageFormat = surfaceFormat.format;
-    this->swapChainExtent = extent;
+bool TriangleApp::recreateSwapChain()
+{
+    int width, height;
+    glfwGetFramebufferSize(this->window, &width, &height);
+    if (width == 0 || height == 0)
+    {
+        return false;
+    }
+
+    // Frames in flight keep using the old swap chain and frame graph. Both are retired rather than waited for,
+    // and the old swap chain is passed on as oldSwapchain so presentation can continue during the switch.
+    this->retireFrameGraph();
+    this->createSwapChain();
+    this->createFrameGraph();
+
+    this->swapChainOutOfDate = false;
+    this->sceneDirty = true;
+    return true;
+}
+
+void TriangleApp::createSyncObjects()
+{
+    this->imgAvailableSemaphores.clear();
+    this->renderingDoneSemaphores.clear();
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        this->imgAvailableSemaphores.push_back(this->logicalDevice->createSemaphoreUnique({}));
+        this->renderingDoneSemaphores.push_back(this->logicalDevice->createSemaphoreUnique({}));
+    }
+
+    this->frameCompletion = std::make_unique<FrameCompletion>(this->logicalDevice.get(), MAX_FRAMES_IN_FLIGHT,
+                                                              this->syncFdSupported);
+    std::clog << fmt::format("Frame completion fds: {:s}\n",
+                             this->syncFdSupported ? "sync files" : "eventfd fallback");
+
+    // GPU timestamps drive the resolution scaler.
+    auto graphicsFamily = this->queueFamilies.graphicsFamily.value();
+    auto validBits = this->physicalDevice.getQueueFamilyProperties()[graphicsFamily].timestampValidBits;
+    if (validBits == 0u)
+    {
+        std::clog << "Graphics queue does not support timestamps, render scale is fixed.\n";
+        return;
+    }
+
+    this->timestampPeriod = this->physicalDevice.getProperties().limits.timestampPeriod;
+    this->timestampMask = validBits >= 64u ? ~0ull : (1ull << validBits) - 1u;
+    this->timestampsWritten.assign(MAX_FRAMES_IN_FLIGHT, false);
+
+    vk::QueryPoolCreateInfo queryPoolInfo;
+    queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+    queryPoolInfo.queryCount = 2u * MAX_FRAMES_IN_FLIGHT;
+    this->timestampPool = this->logicalDevice->createQueryPoolUnique(queryPoolInfo);
+}
+
+// ===========
+// Frame Graph
+// ===========
+
+void TriangleApp::createFrameGraph()
+{
+    auto formatProps = this->physicalDevice.getFormatProperties(this->swapChainImageFormat);
+    if (!(formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eBlitSrc))
+    {
+        throw std::runtime_error("Swap chain format cannot be used as a blit source.");
+    }
+    this->blitFilter = (formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)
+                       ? vk::Filter::eLinear : vk::Filter::eNearest;
+
+    // Step the scene target down until it fits in the memory budget.
+    float sceneScale = MAX_RENDER_SCALE;
+    while (true)
+    {
+        try
+        {
+            this->buildFrameGraph(sceneScale);
+            break;
+        }
+        catch (const OutOfMemoryBudget &err)
+        {
+            this->frameGraph.reset();
+
+            // Retired frame graphs still hold their memory. Waiting for them is better than a smaller target.
+            if (!this->deletionQueue.empty())
+            {
+                this->logicalDevice->waitIdle();
+                this->deletionQueue.flush();
+                continue;
+            }
+
+            if (sceneScale <= MIN_RENDER_SCALE)
+            {
+                throw;
+            }
+
+            std::clog << fmt::format("{:s}\nRetrying with a smaller scene target.\n", err.what());
+            sceneScale = std::max(MIN_RENDER_SCALE, sceneScale - 0.25f);
+        }
+    }
+
+    if (sceneScale < this->resolutionScaler.getMaxScale())
+    {
+        this->resolutionScaler = ResolutionScaler(MIN_RENDER_SCALE, sceneScale, TARGET_GPU_FRAME_MS);
+    }
+
+    std::clog << MemoryTracker::format(this->memoryTracker->snapshot());
 }
 
-void TriangleApp::createSemaphores()
+void TriangleApp::retireFrameGraph()
 {
-    this->imgAvailableSemaphore = this->logicalDevice->createSemaphoreUnique({});
-    this->renderingDoneSemaphore = this->logicalDevice->createSemaphoreUnique({});
+    this->deletionQueue.defer(this->submittedFrames, std::move(this->overlayFramebuffers));
+    this->overlayFramebuffers.clear();
+    this->deletionQueue.defer(this->submittedFrames, std::move(this->overdrawFramebuffer));
+    this->deletionQueue.defer(this->submittedFrames, std::move(this->sceneFramebuffer));
+    this->deletionQueue.defer(this->submittedFrames, std::move(this->frameGraph));
+}
+
+void TriangleApp::buildFrameGraph(float sceneScale)
+{
+    this->sceneExtent.width = std::max(1u, static_cast<uint32_t>(this->swapChainExtent.width * sceneScale));
+    this->sceneExtent.height = std::max(1u, static_cast<uint32_t>(this->swapChainExtent.height * sceneScale));
+
+    this->frameGraph = std::make_unique<FrameGraph>(this->physicalDevice, this->logicalDevice.get(),
+                                                    *this->memoryTracker);
+    auto &graph = *this->frameGraph;
+
+    this->sceneColor = graph.createImage("scene color", this->swapChainImageFormat, this->sceneExtent);
+    this->backbuffer = graph.importImage("backbuffer", this->swapChainImageFormat, this->swapChainExtent,
+                                         vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR);
+
+    vector<PassAccess> sceneAccesses = {{this->sceneColor, ResourceAccess::ColorAttachmentWrite}};
+    if (this->showOverdraw)
+    {
+        this->overdrawCounts = graph.createImage("overdraw counts", OVERDRAW_FORMAT, this->sceneExtent);
+
+        graph.addPass("overdraw", {{this->overdrawCounts, ResourceAccess::ColorAttachmentWrite}},
+                      [this](const vk::CommandBuffer &cmd, const FrameGraph &)
+                      {
+                          this->recordOverdrawPass(cmd);
+                      });
+
+        sceneAccesses.push_back({this->overdrawCounts, ResourceAccess::SampledRead});
+    }
+
+    graph.addPass("scene", sceneAccesses,
+                  [this](const vk::CommandBuffer &cmd, const FrameGraph &passGraph)
+                  {
+                      this->recordScenePass(cmd, passGraph);
+                  });
+
+    graph.addPass("upscale", {{this->sceneColor, ResourceAccess::TransferSrc},
+                              {this->backbuffer, ResourceAccess::TransferDst}},
+                  [this](const vk::CommandBuffer &cmd, const FrameGraph &passGraph)
+                  {
+                      this->recordUpscalePass(cmd, passGraph);
+                  });
+
+    graph.addPass("overlay", {{this->backbuffer, ResourceAccess::ColorAttachmentWrite}},
+                  [this](const vk::CommandBuffer &cmd, const FrameGraph &)
+                  {
+                      this->recordOverlayPass(cmd);
+                  });
+
+    graph.compile();
+
+    auto sceneView = graph.getImageView(this->sceneColor);
+
+    vk::FramebufferCreateInfo framebufferInfo;
+    framebufferInfo.renderPass = this->renderPass.get();
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &sceneView;
+    framebufferInfo.width = this->sceneExtent.width;
+    framebufferInfo.height = this->sceneExtent.height;
+    framebufferInfo.layers = 1;
+
+    this->sceneFramebuffer = this->logicalDevice->createFramebufferUnique(framebufferInfo);
+
+    if (this->showOverdraw)
+    {
+        auto countView = graph.getImageView(this->overdrawCounts);
+        framebufferInfo.renderPass = this->overdrawHeatmap->getCountPass();
+        framebufferInfo.pAttachments = &countView;
+
+        this->overdrawFramebuffer = this->logicalDevice->createFramebufferUnique(framebufferInfo);
+    }
+
+    framebufferInfo.renderPass = this->overlayPass.get();
+    framebufferInfo.width = this->swapChainExtent.width;
+    framebufferInfo.height = this->swapChainExtent.height;
+    for (const auto &imageView : this->swapChainImageViews)
+    {
+        framebufferInfo.pAttachments = &imageView.get();
+        this->overlayFramebuffers.push_back(this->logicalDevice->createFramebufferUnique(framebufferInfo));
+    }
+
+    // The pass list changes with the overdraw view, and the queries with it.
+    if (this->pipelineStatisticsSupported)
+    {
+        if (this->pipelineStatistics)
+        {
+            this->deletionQueue.defer(this->submittedFrames, std::move(this->pipelineStatistics));
+        }
+        this->pipelineStatistics = std::make_unique<PipelineStatistics>(this->logicalDevice.get(),
+                                                                        MAX_FRAMES_IN_FLIGHT, graph.getPassNames());
+    }
+
+    std::clog << fmt::format(FMT_STRING("Scene target\tWidth: {:d}px\tHeight: {:d}px\n"), this->sceneExtent.width,
+                             this->sceneExtent.height);
+}
+
+void TriangleApp::recordOverdrawPass(const vk::CommandBuffer &cmd)
+{
+    vk::ClearValue clearValue;
+    clearValue.color = vk::ClearColorValue(array<float, 4>{0.0f, 0.0f, 0.0f, 0.0f});
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = this->overdrawHeatmap->getCountPass();
+    renderPassInfo.framebuffer = this->overdrawFramebuffer.get();
+    renderPassInfo.renderArea = vk::Rect2D({0, 0}, this->renderExtent);
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearValue;
+
+    cmd.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(this->renderExtent.width),
+                          static_cast<float>(this->renderExtent.height), 0.0f, 1.0f);
+    cmd.setViewport(0, viewport);
+    cmd.setScissor(0, vk::Rect2D({0, 0}, this->renderExtent));
+
+    this->drawTriangle(cmd, this->overdrawPipeline);
+
+    cmd.endRenderPass();
+}
+
+void TriangleApp::recordScenePass(const vk::CommandBuffer &cmd, const FrameGraph &graph)
+{
+    vk::ClearValue clearValue;
+    clearValue.color = vk::ClearColorValue(array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = this->renderPass.get();
+    renderPassInfo.framebuffer = this->sceneFramebuffer.get();
+    renderPassInfo.renderArea = vk::Rect2D({0, 0}, this->renderExtent);
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearValue;
+
+    cmd.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(this->renderExtent.width),
+                          static_cast<float>(this->renderExtent.height), 0.0f, 1.0f);
+    cmd.setViewport(0, viewport);
+    cmd.setScissor(0, vk::Rect2D({0, 0}, this->renderExtent));
+
+    if (this->showOverdraw)
+    {
+        this->overdrawHeatmap->recordHeatmap(cmd, *this->descriptors, graph.getImageView(this->overdrawCounts));
+    }
+    else
+    {
+        this->drawTriangle(cmd, this->pipeline);
+    }
+
+    cmd.endRenderPass();
+}
+
+void TriangleApp::drawTriangle(const vk::CommandBuffer &cmd, const TrianglePipeline &trianglePipeline)
+{
+    // The transform keeps the triangle's shape relative to the output, whatever the render scale.
+    auto aspect = static_cast<float>(this->swapChainExtent.width) / static_cast<float>(this->swapChainExtent.height);
+    auto uniformOffset = this->uniformRing->push(SceneUniforms::rotated(this->sceneAngle, aspect));
+
+    trianglePipeline.bind(cmd, this->uniformSet, uniformOffset, DrawConstants());
+    cmd.draw(3, 1, 0, 0);
+}
+
+void TriangleApp::recordUpscalePass(const vk::CommandBuffer &cmd, const FrameGraph &graph)
+{
+    vk::ImageBlit blit;
+    blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    blit.srcOffsets[1] = vk::Offset3D(static_cast<int32_t>(this->renderExtent.width),
+                                      static_cast<int32_t>(this->renderExtent.height), 1);
+    blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+    blit.dstOffsets[1] = vk::Offset3D(static_cast<int32_t>(this->swapChainExtent.width),
+                                      static_cast<int32_t>(this->swapChainExtent.height), 1);
+    cmd.blitImage(graph.getImage(this->sceneColor), vk::ImageLayout::eTransferSrcOptimal,
+                  graph.getImage(this->backbuffer), vk::ImageLayout::eTransferDstOptimal, blit, this->blitFilter);
+
+    // The overlay does not scale with the render resolution, so its cost must not drive the scaler.
+    if (this->timestampPool)
+    {
+        cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampPool.get(),
+                           this->currentFrame * 2u + 1u);
+        this->timestampsWritten[this->currentFrame] = true;
+    }
+}
+
+void TriangleApp::recordOverlayPass(const vk::CommandBuffer &cmd)
+{
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = this->overlayPass.get();
+    renderPassInfo.framebuffer = this->overlayFramebuffers[this->acquiredImage].get();
+    renderPassInfo.renderArea = vk::Rect2D({0, 0}, this->swapChainExtent);
+
+    cmd.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+
+    vk::Viewport viewport(0.0f, 0.0f, static_cast<float>(this->swapChainExtent.width),
+                          static_cast<float>(this->swapChainExtent.height), 0.0f, 1.0f);
+    cmd.setViewport(0, viewport);
+    cmd.setScissor(0, vk::Rect2D({0, 0}, this->swapChainExtent));
+
+    this->overlayRenderer->record(cmd, this->currentFrame, this->overlay, this->swapChainExtent);
+
+    cmd.endRenderPass();
+}
+
+vk::Extent2D TriangleApp::getRenderExtent() const
+{
+    // The scale is relative to the output, and the result can never exceed what was allocated.
+    return vk::Extent2D(std::min(this->resolutionScaler.scaled(this->swapChainExtent.width), this->sceneExtent.width),
+                        std::min(this->resolutionScaler.scaled(this->swapChainExtent.height),
+                                 this->sceneExtent.height));
+}
+
+void TriangleApp::printFrameStatistics() const
+{
+    if (!this->frameTimeHistory.empty())
+    {
+        auto latest = this->frameTimeHistory.size() < FRAME_TIME_HISTORY
+                      ? this->frameTimeHistory.size() - 1u
+                      : (this->frameTimeCursor + FRAME_TIME_HISTORY - 1u) % FRAME_TIME_HISTORY;
+        std::clog << fmt::format("GPU frame time: {:.3f}ms at {:d}x{:d}\n", this->frameTimeHistory[latest],
+                                 this->renderExtent.width, this->renderExtent.height);
+    }
+
+    if (this->pipelineStatistics)
+    {
+        std::clog << this->pipelineStatistics->format();
+    }
+    else
+    {
+        std::clog << "Pipeline statistics queries are not supported by the device.\n";
+    }
+
+    std::clog << this->presentTimer.format();
+}
+
+void TriangleApp::updateRenderScale(uint32_t frame)
+{
+    if (!this->timestampPool || !this->timestampsWritten[frame])
+    {
+        return;
+    }
+
+    // The frame's fence has signaled, so the results are available without waiting.
+    array<uint64_t, 2> timestamps{};
+    auto result = this->logicalDevice->getQueryPoolResults(this->timestampPool.get(), frame * 2u, 2u,
+                                                           sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+                                                           vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+    {
+        return;
+    }
+
+    auto ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+    auto gpuFrameMs = static_cast<float>(static_cast<double>(ticks) * this->timestampPeriod / 1.0e6);
+    this->resolutionScaler.update(gpuFrameMs);
+
+    if (this->frameTimeHistory.size() < FRAME_TIME_HISTORY)
+    {
+        this->frameTimeHistory.push_back(gpuFrameMs);
+    }
+    else
+    {
+        this->frameTimeHistory[this->frameTimeCursor] = gpuFrameMs;
+        this->frameTimeCursor = (this->frameTimeCursor + 1u) % FRAME_TIME_HISTORY;
+    }
 }
 
 // =================
 // Graphics Pipeline
 // =================
 
+void TriangleApp::createRenderPass()
+{
+    vk::AttachmentDescription colorAttachment;
+    colorAttachment.format = this->swapChainImageFormat;
+    colorAttachment.samples = vk::SampleCountFlagBits::e1;
+    colorAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    colorAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    colorAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    colorAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    // Layout transitions and synchronization around the pass are handled by the frame graph.
+    colorAttachment.initialLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    colorAttachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+
+    vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+
+    vk::SubpassDescription subpass;
+    subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorRef;
+
+    vk::RenderPassCreateInfo renderPassInfo;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    this->renderPass = this->logicalDevice->createRenderPassUnique(renderPassInfo);
+
+    // Same attachment format, so the pass is compatible with pipelines created for the scene pass.
+    colorAttachment.loadOp = vk::AttachmentLoadOp::eLoad;
+    this->overlayPass = this->logicalDevice->createRenderPassUnique(renderPassInfo);
+}
+
 void TriangleApp::createGraphicsPipeline()
 {
-    // Set up shader stages
-    auto vertShaderData = readFile(VERTEX_SHADER_PATH);
-    auto fragShaderData = readFile(FRAGMENT_SHADER_PATH);
-
-    auto vertShaderModule = this->createShaderModule(vertShaderData);
-    auto fragShaderModule = this->createShaderModule(fragShaderData);
-
-    vk::PipelineShaderStageCreateInfo vertShaderStageInfo;
-    vertShaderStageInfo.stage = vk::ShaderStageFlagBits::eVertex;
-    vertShaderStageInfo.module = vertShaderModule.get();
-    vertShaderStageInfo.pName = "main";
-
-    vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
-    fragShaderStageInfo.stage = vk::ShaderStageFlagBits::eFragment;
-    fragShaderStageInfo.module = fragShaderModule.get();
-    fragShaderStageInfo.pName = "main";
-
-    array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
-
-    // Set up vertex input
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
-
-    // Set up input assembly
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
-    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    // Set up viewport
-    vk::Viewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(this->swapChainExtent.width);
-    viewport.height = static_cast<float>(this->swapChainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    vk::Rect2D scissor;
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent = swapChainExtent;
-
-    vk::PipelineViewportStateCreateInfo viewportState;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    // Set up rasterizer
-    vk::PipelineRasterizationStateCreateInfo rasterizer;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = vk::PolygonMode::eFill;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
-    rasterizer.frontFace = vk::FrontFace::eClockwise;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f;
-    rasterizer.depthBiasClamp = 0.0f;
-    rasterizer.depthBiasSlopeFactor = 0.0f;
-
-    // Set up multisampling
-    vk::PipelineMultisampleStateCreateInfo multisampling;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-    // Set up color blending
-    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
-    colorBlendAttachment.colorWriteMask =
-            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB |
-            vk::ColorComponentFlagBits::eA;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
-    colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eZero;
-    colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
-
-    vk::PipelineColorBlendStateCreateInfo colorBlending;
-    colorBlending.logicOpEnable = VK_TRUE;
-    colorBlending.logicOp = vk::LogicOp::eCopy;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-
-    // Set up pipeline layout
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-    this->pipelineLayout = this->logicalDevice->createPipelineLayoutUnique(pipelineLayoutInfo);
-}
-
-vk::UniqueShaderModule TriangleApp::createShaderModule(const vector<uint8_t> &data)
-{
-    vk::ShaderModuleCreateInfo createInfo;
-    createInfo.codeSize = data.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(data.data());
-
-    return this->logicalDevice->createShaderModuleUnique(createInfo);
+    this->descriptorLayouts = std::make_unique<DescriptorLayoutCache>(this->logicalDevice.get());
+    this->descriptors = std::make_unique<DescriptorAllocator>(this->logicalDevice.get(), MAX_FRAMES_IN_FLIGHT);
+
+    this->pipeline = TrianglePipeline::create(this->logicalDevice.get(), this->renderPass.get(),
+                                              *this->descriptorLayouts);
+
+    this->uniformRing = std::make_unique<UniformRing>(this->physicalDevice, this->logicalDevice.get(),
+                                                      *this->memoryTracker, UNIFORM_RING_FRAME_SIZE,
+                                                      MAX_FRAMES_IN_FLIGHT, vk::BufferUsageFlagBits::eUniformBuffer);
+    this->uniformSet = this->pipeline.allocateUniformSet(this->logicalDevice.get(), *this->descriptors,
+                                                         this->uniformRing->getBuffer());
+
+    this->overlayRenderer = std::make_unique<Batch2DRenderer>(this->physicalDevice, this->logicalDevice.get(),
+                                                              *this->memoryTracker, *this->descriptorLayouts,
+                                                              this->overlayPass.get(), MAX_FRAMES_IN_FLIGHT);
+
+    this->overdrawHeatmap = std::make_unique<OverdrawHeatmap>(this->logicalDevice.get(), *this->descriptorLayouts,
+                                                              this->renderPass.get());
+    this->overdrawPipeline = TrianglePipeline::create(this->logicalDevice.get(),
+                                                      this->overdrawHeatmap->getCountPass(),
+                                                      *this->descriptorLayouts, TriangleShading::Overdraw);
+    this->frameTimeHistory.reserve(FRAME_TIME_HISTORY);
+}
+
+void TriangleApp::createCommandBuffers()
+{
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    poolInfo.queueFamilyIndex = this->queueFamilies.graphicsFamily.value();
+
+    this->commandPool = this->logicalDevice->createCommandPoolUnique(poolInfo);
+
+    vk::CommandBufferAllocateInfo allocInfo;
+    allocInfo.commandPool = this->commandPool.get();
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+
+    this->commandBuffers = this->logicalDevice->allocateCommandBuffersUnique(allocInfo);
+}
+
+void TriangleApp::recordCommandBuffer(const vk::CommandBuffer &cmd, uint32_t imageIndex)
+{
+    this->renderExtent = this->getRenderExtent();
+    this->frameGraph->setImportedImage(this->backbuffer, this->swapChainImages[imageIndex],
+                                       this->swapChainImageViews[imageIndex].get());
+
+    auto now = glfwGetTime();
+    if (this->animating)
+    {
+        auto angle = this->sceneAngle + static_cast<float>(now - this->lastFrameTime) * ROTATION_SPEED;
+        this->sceneAngle = std::fmod(angle, 2.0f * glm::pi<float>());
+    }
+    this->lastFrameTime = now;
+
+    // The slot's previous frame has finished, so its region of the ring can be overwritten.
+    this->uniformRing->beginFrame(this->currentFrame);
+    this->descriptors->beginFrame(this->currentFrame);
+    auto &arena = this->frameArenas[this->currentFrame];
+    arena.reset();
+    this->buildOverlay();
+
+    vk::CommandBufferBeginInfo beginInfo;
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    cmd.begin(beginInfo);
+
+    if (this->timestampPool)
+    {
+        cmd.resetQueryPool(this->timestampPool.get(), this->currentFrame * 2u, 2u);
+        cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, this->timestampPool.get(), this->currentFrame * 2u);
+    }
+
+    if (this->pipelineStatistics)
+    {
+        this->frameGraph->execute(cmd, arena, this->pipelineStatistics->queriesFor(this->currentFrame));
+    }
+    else
+    {
+        this->frameGraph->execute(cmd, arena);
+    }
+
+    cmd.end();
+
+    this->uniformRing->flush();
+}
+
+void TriangleApp::buildOverlay()
+{
+    this->overlay.begin();
+
+    if (this->showFrameTimes && !this->frameTimeHistory.empty())
+    {
+        const glm::vec2 origin(16.0f, 16.0f);
+        const float barWidth = 3.0f;
+        const float graphHeight = 96.0f;
+        const float pixelsPerMs = graphHeight / (2.0f * TARGET_GPU_FRAME_MS);
+        const glm::vec2 size(barWidth * FRAME_TIME_HISTORY, graphHeight);
+
+        this->overlay.addRect(0, Pipeline2D::Solid, 0, origin, origin + size, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+
+        auto count = this->frameTimeHistory.size();
+        auto oldest = count < FRAME_TIME_HISTORY ? 0u : this->frameTimeCursor;
+        for (size_t i = 0; i < count; i++)
+        {
+            auto frameMs = this->frameTimeHistory[(oldest + i) % count];
+            auto height = std::min(frameMs * pixelsPerMs, graphHeight);
+            auto color = frameMs > TARGET_GPU_FRAME_MS ? glm::vec4(0.9f, 0.2f, 0.2f, 0.9f)
+                                                       : glm::vec4(0.2f, 0.8f, 0.3f, 0.9f);
+
+            glm::vec2 barMin(origin.x + barWidth * i, origin.y + graphHeight - height);
+            glm::vec2 barMax(origin.x + barWidth * (i + 1u) - 1.0f, origin.y + graphHeight);
+            this->overlay.addRect(1, Pipeline2D::Solid, 0, barMin, barMax, color);
+        }
+
+        // Target frame time, halfway up the graph.
+        auto targetY = origin.y + graphHeight - TARGET_GPU_FRAME_MS * pixelsPerMs;
+        this->overlay.addRect(2, Pipeline2D::Additive, 0, glm::vec2(origin.x, targetY - 1.0f),
+                              glm::vec2(origin.x + size.x, targetY), glm::vec4(0.4f, 0.4f, 0.4f, 1.0f));
+    }
+
+    this->overlay.end();
+}
+
+void TriangleApp::drawFrame()
+{
+    this->frameCompletion->wait(this->currentFrame);
+
+    if (this->beginFrame(UINT64_MAX))
+    {
+        this->submitFrame();
+    }
+}
+
+bool TriangleApp::beginFrame(uint64_t acquireTimeout)
+{
+    if (this->frameBegun)
+    {
+        throw std::runtime_error("beginFrame() called twice without submitFrame().");
+    }
+
+    if (!this->frameCompletion->isComplete(this->currentFrame))
+    {
+        return false;
+    }
+
+    // Frames complete in submission order, so everything up to this slot's last frame is done.
+    this->completedFrames = std::max(this->completedFrames, this->slotFrames[this->currentFrame]);
+    this->deletionQueue.collect(this->completedFrames);
+
+    // This slot's previous frame is done, so its GPU time can steer the resolution of the next one.
+    this->updateRenderScale(this->currentFrame);
+    if (this->pipelineStatistics)
+    {
+        this->pipelineStatistics->collect(this->currentFrame);
+    }
+
+    if (this->swapChainOutOfDate)
+    {
+        return false;
+    }
+
+    auto &imgAvailable = this->imgAvailableSemaphores[this->currentFrame].get();
+    vk::ResultValue<uint32_t> acquired(vk::Result::eNotReady, 0u);
+    try
+    {
+        std::lock_guard<std::mutex> lock(this->swapChainMutex);
+        acquired = this->logicalDevice->acquireNextImageKHR(this->swapChain.get(), acquireTimeout,
+                                                            imgAvailable, nullptr);
+    }
+    catch (const vk::OutOfDateKHRError &)
+    {
+        this->swapChainOutOfDate = true;
+        return false;
+    }
+
+    if (acquired.result != vk::Result::eSuccess && acquired.result != vk::Result::eSuboptimalKHR)
+    {
+        // eTimeout or eNotReady: nothing was acquired and the semaphore stays unsignaled.
+        return false;
+    }
+
+    this->acquiredImage = acquired.value;
+
+    auto &cmd = this->commandBuffers[this->currentFrame].get();
+    cmd.reset({});
+    this->recordCommandBuffer(cmd, this->acquiredImage);
+
+    this->frameBegun = true;
+    return true;
+}
+
+void TriangleApp::submitFrame()
+{
+    if (!this->frameBegun)
+    {
+        throw std::runtime_error("submitFrame() called without a successful beginFrame().");
+    }
+    this->frameBegun = false;
+
+    auto &imgAvailable = this->imgAvailableSemaphores[this->currentFrame].get();
+    auto &renderingDone = this->renderingDoneSemaphores[this->currentFrame].get();
+    auto &cmd = this->commandBuffers[this->currentFrame].get();
+
+    // The frame graph's first use of the swap chain image is the blit destination.
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTransfer;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &imgAvailable;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &renderingDone;
+
+    this->graphicsQueue.submit(submitInfo, this->frameCompletion->fenceFor(this->currentFrame));
+    this->frameCompletion->submitted(this->currentFrame);
+    this->slotFrames[this->currentFrame] = ++this->submittedFrames;
+
+    vk::PresentInfoKHR presentInfo;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &renderingDone;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &this->swapChain.get();
+    presentInfo.pImageIndices = &this->acquiredImage;
+
+    auto presentId = this->presentTimer.beginPresent();
+    vk::PresentIdKHR presentIdInfo(1u, &presentId);
+    if (this->presentWaitSupported)
+    {
+        presentInfo.pNext = &presentIdInfo;
+    }
+
+    bool queued = true;
+    try
+    {
+        std::lock_guard<std::mutex> lock(this->swapChainMutex);
+        if (this->presentQueue.presentKHR(presentInfo) == vk::Result::eSuboptimalKHR)
+        {
+            this->swapChainOutOfDate = true;
+        }
+    }
+    catch (const vk::OutOfDateKHRError &)
+    {
+        this->swapChainOutOfDate = true;
+        queued = false;
+    }
+    this->presentTimer.presented(presentId, glfwGetTime(), queued);
+
+    this->currentFrame = (this->currentFrame + 1u) % MAX_FRAMES_IN_FLIGHT;
+}
+
+int TriangleApp::getCompletionFd() const
+{
+    return this->frameCompletion->fd(this->currentFrame);
 }
 
 // ============
@@ -483,14 +1314,13 @@ bool TriangleApp::checkDeviceExtensionSupport(const vk::PhysicalDevice &device)
 {
     auto availableExts = device.enumerateDeviceExtensionProperties();
 
-    std::set<string> requiredExts(this->deviceExtensions.begin(), this->deviceExtensions.end());
-
-    for (const auto &ext : availableExts)
+    return std::all_of(this->deviceExtensions.begin(), this->deviceExtensions.end(), [&availableExts](const char *name)
     {
-        requiredExts.erase(ext.extensionName);
-    }
-
-    return requiredExts.empty();
+        return std::any_of(availableExts.begin(), availableExts.end(), [name](const vk::ExtensionProperties &ext)
+        {
+            return std::strcmp(ext.extensionName, name) == 0;
+        });
+    });
 }
 
 uint32_t TriangleApp::getDeviceScore(const vk::PhysicalDevice &device)
@@ -560,7 +1390,7 @@ void TriangleApp::pickPhysicalDevice()
     auto devices = this->instance->enumeratePhysicalDevices();
     if (devices.empty())
     {
-        throw std::runtime_error("Failed to find any GPUs with Vulkan support.");
+        throw VulkanUnavailable("Failed to find any GPUs with Vulkan support.");
     }
 
     std::multimap<uint32_t, vk::PhysicalDevice> suitableDevices;
@@ -573,16 +1403,17 @@ void TriangleApp::pickPhysicalDevice()
 
     if (suitableDevices.empty() || suitableDevices.rbegin()->first == 0)
     {
-        throw std::runtime_error("Failed to find a suitable GPU.");
+        throw VulkanUnavailable("Failed to find a suitable GPU.");
     }
 
     this->physicalDevice = suitableDevices.rbegin()->second;
+    this->queueFamilies = this->checkQueueFamilies(this->physicalDevice);
     std::clog << fmt::format("Selected device: {:s}\n", this->physicalDevice.getProperties().deviceName);
 }
 
 void TriangleApp::createLogicalDevice()
 {
-    auto indices = this->checkQueueFamilies(this->physicalDevice);
+    const auto &indices = this->queueFamilies;
 
     vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -596,16 +1427,51 @@ void TriangleApp::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Pipeline statistics are a debugging aid, the app runs without them.
     auto deviceFeatures = vk::PhysicalDeviceFeatures();
+    this->pipelineStatisticsSupported = PipelineStatistics::isSupported(this->physicalDevice);
+    deviceFeatures.pipelineStatisticsQuery = this->pipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
 
     auto createInfo = vk::DeviceCreateInfo();
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(this->deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = this->deviceExtensions.data();
 
-    if (enableValidationLayers)
+    // Present timing falls back to the return of vkQueuePresentKHR without present_wait.
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures(VK_TRUE);
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures(VK_TRUE, &presentWaitFeatures);
+    this->presentWaitSupported = SwapchainPresentWait::isSupported(this->physicalDevice);
+    if (this->presentWaitSupported)
+    {
+        createInfo.pNext = &presentIdFeatures;
+    }
+
+    // Optional extensions are enabled only when the device has them.
+    auto enabledExtensions = this->deviceExtensions;
+    this->memoryBudgetSupported = MemoryTracker::isBudgetExtensionSupported(this->physicalDevice);
+    if (this->memoryBudgetSupported)
+    {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    this->syncFdSupported = FrameCompletion::isSyncFdSupported(this->physicalDevice);
+    if (this->syncFdSupported)
+    {
+        enabledExtensions.push_back(VK_KHR_EXTERNAL_FENCE_FD_EXTENSION_NAME);
+    }
+
+    if (this->presentWaitSupported)
+    {
+        enabledExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+    std::clog << fmt::format("Present timing: {:s}\n",
+                             this->presentWaitSupported ? "VK_KHR_present_wait" : "vkQueuePresentKHR return");
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
+    if (this->validationEnabled)
     {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
         createInfo.ppEnabledLayerNames = validationLayers.data();
@@ -629,6 +1495,9 @@ void TriangleApp::createLogicalDevice()
 
     this->graphicsQueue = this->logicalDevice->getQueue(indices.graphicsFamily.value(), 0);
     this->presentQueue = this->logicalDevice->getQueue(indices.presentFamily.value(), 0);
+
+    this->memoryTracker = std::make_unique<MemoryTracker>(this->physicalDevice, this->logicalDevice.get(),
+                                                          this->memoryBudgetSupported);
 }
 
 bool TriangleApp::checkExtensionSupport(const char **required, const uint32_t &count)
@@ -677,7 +1546,7 @@ bool TriangleApp::checkExtensionSupport(const char **required, const uint32_t &c
 bool TriangleApp::checkValidationLayerSupport()
 {
     uint32_t layerCount;
-    vk::enumerateInstanceLayerProperties(&layerCount, nullptr, vk::DispatchLoaderStatic());
+    vk::enumerateInstanceLayerProperties(&layerCount, nullptr);
 
     vector<vk::LayerProperties> availableLayers(layerCount);
     vk::enumerateInstanceLayerProperties(&layerCount, availableLayers.data());
@@ -717,8 +1586,14 @@ bool TriangleApp::checkValidationLayerSupport()
     return false;
 }
 
-vector<const char *> TriangleApp::getRequiredExtensions()
+vector<const char *> TriangleApp::getRequiredExtensions() const
 {
+    // Checked first, since glfwGetRequiredInstanceExtensions() reports a missing loader through the error callback.
+    if (!glfwVulkanSupported())
+    {
+        throw VulkanUnavailable("GLFW found no Vulkan loader with window surface support.");
+    }
+
     uint32_t glfwExtensionCount = 0u;
     const auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
@@ -729,7 +1604,7 @@ vector<const char *> TriangleApp::getRequiredExtensions()
         extensions.push_back(glfwExtensions[i]);
     }
 
-    if (enableValidationLayers)
+    if (this->validationEnabled)
     {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
@@ -764,7 +1639,7 @@ QueueFamilyIndices TriangleApp::checkQueueFamilies(const vk::PhysicalDevice &dev
 vector<vk::ExtensionProperties> TriangleApp::getAvailableExtensions()
 {
     uint32_t count = 0u;
-    vk::enumerateInstanceExtensionProperties(nullptr, &count, nullptr, vk::DispatchLoaderStatic());
+    vk::enumerateInstanceExtensionProperties(nullptr, &count, nullptr);
 
     vector<vk::ExtensionProperties> extensions(count);
     vk::enumerateInstanceExtensionProperties(nullptr, &count, extensions.data());
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <optional>
+#include <atomic>
+#include <mutex>
 
 #define GLFW_INCLUDE_VULKAN
 extern "C"
@@ -16,16 +19,29 @@ extern "C"
 
 #include <vulkan/vulkan.hpp>
 
+#include "TrianglePipeline.hpp"
+#include "ResolutionScaler.hpp"
+#include "FrameGraph.hpp"
+#include "MemoryTracker.hpp"
+#include "FrameCompletion.hpp"
+#include "UniformRing.hpp"
+#include "DescriptorAllocator.hpp"
+#include "Batcher2D.hpp"
+#include "Batch2DRenderer.hpp"
+#include "PipelineStatistics.hpp"
+#include "OverdrawHeatmap.hpp"
+#include "DeletionQueue.hpp"
+#include "FrameArena.hpp"
+#include "PresentWait.hpp"
+
 using std::string;
 using std::vector;
 using std::shared_ptr;
+using std::unique_ptr;
 namespace fs = std::filesystem;
 
 namespace VkTri
 {
-    const fs::path VERTEX_SHADER_PATH("../shaders/vert.spv");
-    const fs::path FRAGMENT_SHADER_PATH("../shaders/frag.spv");
-
     static const uint32_t DISCRETE_SCORE = 1000u;
     static const uint32_t INTEGRATED_SCORE = 500u;
     static const uint32_t VIRTUAL_SCORE = 750u;
@@ -49,31 +65,109 @@ namespace VkTri
         vector<vk::PresentModeKHR> presentModes;
     };
 
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2u; /**< Frames the CPU may record ahead of the GPU */
+
+    static constexpr float MIN_RENDER_SCALE = 0.5f; /**< Smallest internal resolution, relative to the window */
+    static constexpr float MAX_RENDER_SCALE = 1.0f; /**< Largest internal resolution, relative to the window */
+    static constexpr float TARGET_GPU_FRAME_MS = 8.0f; /**< GPU frame time the resolution scaler aims for */
+
+    static constexpr vk::DeviceSize UNIFORM_RING_FRAME_SIZE = 64u * 1024u; /**< Uniform bytes per frame in flight */
+    static constexpr float ROTATION_SPEED = 1.0f; /**< Radians per second the triangle turns in animation mode */
+    static constexpr size_t FRAME_TIME_HISTORY = 120u; /**< GPU frame times shown by the frame time overlay */
+
     class TriangleApp
     {
     private:
         vk::UniqueInstance instance; /**< Application Vulkan instance */
         vk::PhysicalDevice physicalDevice; /**< Physical device in use by the application */
+        QueueFamilyIndices queueFamilies; /**< Queue families of physicalDevice, found once when it is picked */
         vk::UniqueDevice logicalDevice; /**< Unique instance of logical Vulkan device. */
         vk::Queue graphicsQueue; /**< Graphics queue used with the logical device. */
         vk::Queue presentQueue; /**< Presentation queue used with the logical device. */
 
+        vk::UniqueSwapchainKHR swapChain;
+        std::mutex swapChainMutex; /**< Held to acquire from, present to and wait on the swap chain */
+        vector<vk::Image> swapChainImages;
+        vk::Format swapChainImageFormat;
+        vk::Extent2D swapChainExtent;
+        vector<vk::UniqueImageView> swapChainImageViews;
+
+        unique_ptr<MemoryTracker> memoryTracker; /**< Accounts for every device allocation made by the app */
+
         /**
-         * \brief Pointer to the application swap chain
+         * \brief Frame graph describing the scene and upscale passes.
          *
          * \details
-         * Giving the instance direct ownership of the UniqueSwapChain object causes the object to
-         * be deleted out of sequence. A pointer is used instead to allow Vulkan to manage the object
-         * lifetime.
+         * The scene color target is a transient graph image allocated at the largest render scale. Lower scales
+         * only render into its top-left corner, so changing the internal resolution never reallocates anything. The
+         * rendered region is blitted to the imported swap chain image with linear filtering.
          */
-        vk::SwapchainKHR *swapChain;
-        vk::UniqueSemaphore imgAvailableSemaphore;
-        vk::UniqueSemaphore renderingDoneSemaphore;
-        vk::Format swapChainImageFormat;
-        vk::Extent2D swapChainExtent;
-        vector<vk::UniqueImageView> swapChainImageViews;
+        unique_ptr<FrameGraph> frameGraph;
+        ResourceHandle sceneColor = 0u;
+        ResourceHandle backbuffer = 0u;
+        vk::Extent2D sceneExtent; /**< Allocated size of the scene target */
+        vk::Extent2D renderExtent; /**< Size the scene is rendered at in the frame being recorded */
+        vk::Filter blitFilter = vk::Filter::eLinear;
+        ResolutionScaler resolutionScaler{MIN_RENDER_SCALE, MAX_RENDER_SCALE, TARGET_GPU_FRAME_MS};
+
+        vk::UniqueRenderPass renderPass;
+        vk::UniqueFramebuffer sceneFramebuffer;
+        unique_ptr<DescriptorLayoutCache> descriptorLayouts; /**< Set layouts of every pipeline the app creates */
+        unique_ptr<DescriptorAllocator> descriptors; /**< Transient pools are reset at the start of each frame */
+        TrianglePipeline pipeline;
+        unique_ptr<UniformRing> uniformRing; /**< SceneUniforms of each frame, written with a memcpy */
+        std::array<FrameArena, MAX_FRAMES_IN_FLIGHT> frameArenas; /**< Transient CPU data of each frame slot */
+        vk::DescriptorSet uniformSet; /**< Points at uniformRing, written once at creation */
+        float sceneAngle = 0.0f; /**< Rotation of the triangle, advanced while animating */
+        double lastFrameTime = 0.0; /**< glfwGetTime() value of the last recorded frame */
+
+        Batcher2D overlay; /**< 2D primitives drawn over the scene, rebuilt every frame */
+        unique_ptr<Batch2DRenderer> overlayRenderer;
+        vk::UniqueRenderPass overlayPass; /**< Draws onto the upscaled swap chain image, keeping its contents */
+        vector<vk::UniqueFramebuffer> overlayFramebuffers; /**< One per swap chain image */
+        bool showFrameTimes = false;
+        vector<float> frameTimeHistory; /**< GPU frame times in milliseconds, used as a ring once full */
+        size_t frameTimeCursor = 0u; /**< Oldest entry of frameTimeHistory once it is full */
+
+        unique_ptr<OverdrawHeatmap> overdrawHeatmap;
+        TrianglePipeline overdrawPipeline; /**< Draws into the overdraw count target instead of the scene */
+        ResourceHandle overdrawCounts = 0u; /**< Only part of the frame graph while showOverdraw is set */
+        vk::UniqueFramebuffer overdrawFramebuffer;
+        bool showOverdraw = false;
+
+        vk::UniqueCommandPool commandPool;
+        vector<vk::UniqueCommandBuffer> commandBuffers;
+        vector<vk::UniqueSemaphore> imgAvailableSemaphores;
+        vector<vk::UniqueSemaphore> renderingDoneSemaphores;
+        unique_ptr<FrameCompletion> frameCompletion; /**< Completion of each frame slot, pollable as an fd */
+        uint32_t currentFrame = 0u;
+        uint64_t submittedFrames = 0u; /**< Number of the last submitted frame, counting from 1 */
+        std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> slotFrames{}; /**< Frame number last submitted from each slot */
+        uint64_t completedFrames = 0u; /**< Every frame up to this number has finished on the GPU */
+        DeletionQueue deletionQueue; /**< Replaced resources, kept until the frames using them complete */
+        uint32_t acquiredImage = 0u; /**< Swap chain image of the frame between beginFrame() and submitFrame() */
+        bool frameBegun = false;
+
+        /**
+         * \brief Damage tracking
+         *
+         * \details
+         * run() only records and presents when one of these asks for it, and otherwise sleeps in glfwWaitEvents()
+         * without any timer wakeups. Animation mode bypasses all of it and renders continuously.
+         */
+        std::atomic<bool> sceneDirty{true};
+        bool animating = false;
+        bool swapChainOutOfDate = false;
+        bool windowIconified = false;
+        std::optional<double> redrawDeadline; /**< glfwGetTime() value at which a scheduled redraw is due */
+
+        vk::UniqueQueryPool timestampPool; /**< Two timestamps per frame in flight, bracketing the GPU work */
+        vector<bool> timestampsWritten;
+        float timestampPeriod = 0.0f; /**< Nanoseconds per timestamp tick, 0 if timestamps are unsupported */
+        uint64_t timestampMask = 0u;
+        unique_ptr<PipelineStatistics> pipelineStatistics; /**< Null without the pipelineStatisticsQuery feature */
+        PresentTimer presentTimer; /**< Input-to-present latency and present intervals, on the glfwGetTime() clock */
 
-        vk::UniquePipelineLayout pipelineLayout;
     protected:
         // Validation layers
         const vector<const char *> validationLayers = {
@@ -86,6 +180,8 @@ namespace VkTri
         static constexpr bool enableValidationLayers = true;
 #endif // NDEBUG
 
+        bool validationEnabled = enableValidationLayers; /**< Cleared when the layers are requested but not installed */
+
         GLFWwindow *window; /**< Application window */
 
         /**
@@ -109,6 +205,11 @@ namespace VkTri
                 VK_KHR_SWAPCHAIN_EXTENSION_NAME
         };
 
+        bool memoryBudgetSupported = false; /**< Whether VK_EXT_memory_budget is enabled on the logical device */
+        bool syncFdSupported = false; /**< Whether VK_KHR_external_fence_fd is enabled on the logical device */
+        bool presentWaitSupported = false; /**< Whether VK_KHR_present_id and VK_KHR_present_wait are enabled */
+        bool pipelineStatisticsSupported = false; /**< Whether pipelineStatisticsQuery is enabled on the device */
+
         bool checkDeviceExtensionSupport(const vk::PhysicalDevice &device);
 
         /**
@@ -132,7 +233,7 @@ namespace VkTri
          * \brief Polls the libraries in-use for the Vulkan extensions they require.
          * \return vector containing the names of the required extensions.
          */
-        static vector<const char *> getRequiredExtensions();
+        vector<const char *> getRequiredExtensions() const;
 
         QueueFamilyIndices checkQueueFamilies(const vk::PhysicalDevice &device);
 
@@ -161,15 +262,123 @@ namespace VkTri
 
         void createSwapChain();
 
-        void createSemaphores();
+        /**
+         * \brief Rebuilds the swap chain and everything sized after it.
+         * \return false if the window currently has no area to render to.
+         */
+        bool recreateSwapChain();
+
+        void createSyncObjects();
+
+        // ===========
+        // Frame Graph
+        // ===========
+
+        /**
+         * \brief Declares the frame's passes and compiles them, which allocates the scene target.
+         *
+         * \details
+         * If the scene target does not fit the memory budget at the largest render scale, smaller scales are tried
+         * down to MIN_RENDER_SCALE, and the resolution scaler is capped accordingly.
+         */
+        void createFrameGraph();
+
+        /**
+         * \brief Hands the frame graph and the framebuffers built on it to the deletion queue.
+         */
+        void retireFrameGraph();
+
+        /**
+         * \brief Builds and compiles the frame graph with a scene target at the given scale.
+         *
+         * \details
+         * In overdraw view, an extra pass draws the scene into an overdraw count target, and the scene pass shows
+         * its heatmap instead of the triangle. The overlay pass always comes last and draws straight into the swap
+         * chain image.
+         */
+        void buildFrameGraph(float sceneScale);
+
+        void recordOverdrawPass(const vk::CommandBuffer &cmd);
+
+        void recordScenePass(const vk::CommandBuffer &cmd, const FrameGraph &graph);
+
+        /**
+         * \brief Pushes this frame's scene uniforms and draws the triangle with the given pipeline.
+         */
+        void drawTriangle(const vk::CommandBuffer &cmd, const TrianglePipeline &trianglePipeline);
+
+        /**
+         * \brief Blits the scene to the swap chain image, which ends the GPU time the resolution scaler sees.
+         */
+        void recordUpscalePass(const vk::CommandBuffer &cmd, const FrameGraph &graph);
+
+        /**
+         * \brief Draws the overlay at the output resolution, after the upscale, so it stays sharp at any scale.
+         */
+        void recordOverlayPass(const vk::CommandBuffer &cmd);
+
+        /**
+         * \brief Extent the scene is rendered at this frame, as chosen by the resolution scaler.
+         */
+        [[nodiscard]] vk::Extent2D getRenderExtent() const;
+
+        /**
+         * \brief Reads back the GPU timestamps of a finished frame and feeds them to the resolution scaler.
+         */
+        void updateRenderScale(uint32_t frame);
+
+        /**
+         * \brief Prints the GPU time and pipeline statistics of the last completed frame, and the present timings.
+         */
+        void printFrameStatistics() const;
 
         // =================
         // Graphics Pipeline
         // =================
 
+        void createRenderPass();
+
         void createGraphicsPipeline();
 
-        vk::UniqueShaderModule createShaderModule(const vector<uint8_t> &data);
+        void createCommandBuffers();
+
+        void recordCommandBuffer(const vk::CommandBuffer &cmd, uint32_t imageIndex);
+
+        /**
+         * \brief Fills the overlay batch for the frame being recorded, e.g. with the frame time graph.
+         */
+        void buildOverlay();
+
+        /**
+         * \brief Renders and presents a single frame, blocking until a frame slot and an image are free.
+         */
+        void drawFrame();
+
+        /**
+         * \brief Whether the loop has a reason to produce a frame right now.
+         */
+        [[nodiscard]] bool needsFrame() const;
+
+        /**
+         * \brief Sleeps until the next window event, or until a scheduled redraw is due.
+         *
+         * \details
+         * Resources retired by the last frames, e.g. the swap chain and frame graph replaced by a resize, are
+         * destroyed before going to sleep, since no frame will collect them until the next input.
+         */
+        void waitForDamage();
+
+        static void onWindowRefresh(GLFWwindow *window);
+
+        static void onFramebufferResize(GLFWwindow *window, int width, int height);
+
+        static void onWindowIconify(GLFWwindow *window, int iconified);
+
+        static void onKey(GLFWwindow *window, int key, int scancode, int action, int mods);
+
+        static void onCursorPos(GLFWwindow *window, double x, double y);
+
+        static void onMouseButton(GLFWwindow *window, int button, int action, int mods);
 
         // ===========
         // Debug Setup
@@ -195,6 +404,68 @@ namespace VkTri
 
         void run();
 
+        /**
+         * \brief Starts a frame if that can be done without blocking, and records its commands.
+         *
+         * \details
+         * Returns false when the next frame slot is still in flight on the GPU, or when no swap chain image can be
+         * acquired within acquireTimeout. In the first case, getCompletionFd() becomes readable once the slot frees up.
+         *
+         * \param acquireTimeout nanoseconds to wait for a swap chain image, 0 to never block.
+         * \return whether a frame was started and must be finished with submitFrame().
+         */
+        bool beginFrame(uint64_t acquireTimeout = 0u);
+
+        /**
+         * \brief Submits and presents the frame started by beginFrame(). Does not wait for the GPU.
+         */
+        void submitFrame();
+
+        /**
+         * \brief Marks the scene as changed, so the next loop iteration renders a frame.
+         *
+         * \details
+         * Safe to call from any thread. It wakes the loop if it is sleeping in glfwWaitEvents().
+         */
+        void invalidate();
+
+        /**
+         * \brief Requests a redraw after a delay, e.g. for content that changes on a clock.
+         */
+        void scheduleRedraw(double delaySeconds);
+
+        /**
+         * \brief Switches between continuous rendering and rendering only on damage.
+         */
+        void setAnimating(bool animate);
+
+        [[nodiscard]] bool isAnimating() const noexcept;
+
+        /**
+         * \brief Switches the scene between normal shading and an overdraw heatmap.
+         * \details
+         * Rebuilds the frame graph without waiting on the GPU. The old graph and its framebuffers go to the
+         * deletion queue and are destroyed once the frames in flight that use them have completed.
+         */
+        void setOverdrawView(bool enabled);
+
+        [[nodiscard]] bool isOverdrawView() const noexcept;
+
+        /**
+         * \brief File descriptor that becomes readable when the next frame slot finishes on the GPU.
+         *
+         * \details
+         * This is a sync file exported from the slot's fence when VK_KHR_external_fence_fd is available, otherwise
+         * an eventfd. Returns -1 when the slot is already free and beginFrame() will not be held up by the GPU.
+         * The descriptor remains owned by the app.
+         */
+        [[nodiscard]] int getCompletionFd() const;
+
+        /**
+         * \brief Per-heap usage and budget, along with the app's own allocations by category.
+         */
+        [[nodiscard]] MemoryStats getMemoryStats() const;
+
         TriangleApp();
 
         ~TriangleApp();
@@ -205,6 +476,10 @@ namespace VkTri
 
         [[nodiscard]] static vector<vk::ExtensionProperties> getAvailableExtensions();
 
+        /**
+         * \brief Opens the window and sets up the device, swap chain and everything drawn with them.
+         * \throws VulkanUnavailable if there is no loader, no driver or no suitable device.
+         */
         [[nodiscard]] static shared_ptr<TriangleApp> create();
 
         [[nodiscard]] static vector<uint8_t> readFile(const fs::path &filePath);
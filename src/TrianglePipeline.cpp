@@ -0,0 +1,191 @@
+#include <array>
+#include <glm/gtc/matrix_transform.hpp>
+#include "DeviceSetup.hpp"
+#include "ShaderReflection.hpp"
+#include "TrianglePipeline.hpp"
+#include "reflection/TriangleVert.hpp"
+#include "reflection/TriangleFrag.hpp"
+#include "reflection/TriangleOverdrawFrag.hpp"
+
+using std::array;
+
+using namespace VkTri;
+
+namespace VertexShader = VkTri::Reflection::TriangleVert;
+namespace FragmentShader = VkTri::Reflection::TriangleFrag;
+namespace OverdrawShader = VkTri::Reflection::TriangleOverdrawFrag;
+
+// The CPU side structs are written by hand, the shader blocks they feed are reflected.
+static_assert(sizeof(DrawConstants) == VertexShader::PUSH_CONSTANTS.size,
+              "DrawConstants does not match the push constant block of triangle.vert");
+static_assert(VertexShader::DESCRIPTOR_BINDINGS.size() == 1u &&
+              sizeof(SceneUniforms) == VertexShader::DESCRIPTOR_BINDINGS[0].blockSize,
+              "SceneUniforms does not match the uniform block of triangle.vert");
+
+SceneUniforms SceneUniforms::rotated(float angle, float aspect)
+{
+    SceneUniforms uniforms;
+    uniforms.transform = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / aspect, 1.0f, 1.0f)) *
+                         glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+    return uniforms;
+}
+
+TrianglePipeline TrianglePipeline::create(const vk::Device &device, const vk::RenderPass &renderPass,
+                                          DescriptorLayoutCache &layouts, TriangleShading shading)
+{
+    TrianglePipeline result;
+    bool overdraw = shading == TriangleShading::Overdraw;
+    const auto &fragmentInterface = overdraw ? OverdrawShader::INTERFACE : FragmentShader::INTERFACE;
+
+    // Set up shader stages
+    auto vertShaderModule = loadShaderModule(device, VERTEX_SHADER_PATH);
+    auto fragShaderModule = loadShaderModule(device, overdraw ? FRAGMENT_OVERDRAW_SHADER_PATH : FRAGMENT_SHADER_PATH);
+
+    vk::PipelineShaderStageCreateInfo vertShaderStageInfo;
+    vertShaderStageInfo.stage = VertexShader::STAGE;
+    vertShaderStageInfo.module = vertShaderModule.get();
+    vertShaderStageInfo.pName = "main";
+
+    vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
+    fragShaderStageInfo.stage = fragmentInterface.stage;
+    fragShaderStageInfo.module = fragShaderModule.get();
+    fragShaderStageInfo.pName = "main";
+
+    array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
+
+    // Set up vertex input. The triangle is generated in the vertex shader today, so both lists come out empty.
+    auto vertexAttributes = vertexAttributeDescriptions(VertexShader::INTERFACE, 0);
+    vk::VertexInputBindingDescription vertexBinding(0, VertexShader::VERTEX_STRIDE, vk::VertexInputRate::eVertex);
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = vertexAttributes.empty() ? 0u : 1u;
+    vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
+
+    // Set up input assembly
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are supplied at record time.
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    array<vk::DynamicState, 2> dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+    vk::PipelineDynamicStateCreateInfo dynamicState;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    // Set up rasterizer
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = vk::PolygonMode::eFill;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = vk::CullModeFlagBits::eBack;
+    rasterizer.frontFace = vk::FrontFace::eClockwise;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    // Set up multisampling
+    vk::PipelineMultisampleStateCreateInfo multisampling;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+    multisampling.minSampleShading = 1.0f;
+
+    // Set up color blending
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask =
+            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB |
+            vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+    colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+    colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+
+    // Overdraw counts add up in the red channel.
+    if (overdraw)
+    {
+        colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR;
+        colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eOne;
+        colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOne;
+    }
+
+    // Logic ops replace blending entirely, so they stay disabled.
+    vk::PipelineColorBlendStateCreateInfo colorBlending;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = vk::LogicOp::eCopy;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    // Set up descriptor set layout. Buffers are dynamic so they can point into a UniformRing.
+    result.setLayout = layouts.get(
+            descriptorSetLayoutBindings({VertexShader::INTERFACE, fragmentInterface}, 0, true));
+
+    // Set up pipeline layout
+    auto pushRanges = pushConstantRanges({VertexShader::INTERFACE, fragmentInterface});
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &result.setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushRanges.data();
+
+    result.layout = device.createPipelineLayoutUnique(pipelineLayoutInfo);
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = result.layout.get();
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+
+    result.pipeline = device.createGraphicsPipelineUnique(nullptr, pipelineInfo).value;
+
+    return result;
+}
+
+vk::DescriptorSet TrianglePipeline::allocateUniformSet(const vk::Device &device, DescriptorAllocator &descriptors,
+                                                       const vk::Buffer &uniformBuffer) const
+{
+    auto uniformSet = descriptors.allocatePersistent(this->setLayout);
+
+    // The range covers one SceneUniforms, and the dynamic offset selects which one.
+    const auto &binding = VertexShader::DESCRIPTOR_BINDINGS[0];
+    vk::DescriptorBufferInfo bufferInfo(uniformBuffer, 0, binding.blockSize);
+
+    vk::WriteDescriptorSet write;
+    write.dstSet = uniformSet;
+    write.dstBinding = binding.binding;
+    write.descriptorCount = 1;
+    write.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+    write.pBufferInfo = &bufferInfo;
+
+    device.updateDescriptorSets(write, nullptr);
+
+    return uniformSet;
+}
+
+void TrianglePipeline::bind(const vk::CommandBuffer &cmd, const vk::DescriptorSet &uniformSet,
+                            uint32_t dynamicOffset, const DrawConstants &constants) const
+{
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, this->pipeline.get());
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, this->layout.get(), 0, uniformSet, dynamicOffset);
+    this->push(cmd, constants);
+}
+
+void TrianglePipeline::push(const vk::CommandBuffer &cmd, const DrawConstants &constants) const
+{
+    cmd.pushConstants(this->layout.get(), VertexShader::STAGE, 0, sizeof(DrawConstants), &constants);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <filesystem>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "DescriptorAllocator.hpp"
+
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    const fs::path VERTEX_SHADER_PATH("../shaders/vert.spv");
+    const fs::path FRAGMENT_SHADER_PATH("../shaders/frag.spv");
+    const fs::path FRAGMENT_OVERDRAW_SHADER_PATH("../shaders/frag_overdraw.spv");
+
+    /**
+     * \brief What the triangle pipeline writes to its color attachment.
+     */
+    enum class TriangleShading
+    {
+        Color, /**< Vertex colors, blended over the target */
+        Overdraw /**< One per fragment, added up in a single channel target such as OVERDRAW_FORMAT */
+    };
+
+    /**
+     * \brief Per-frame data read by the triangle shaders, matching the std140 block at set 0, binding 0.
+     */
+    struct SceneUniforms
+    {
+        glm::mat4 transform{1.0f}; /**< Applied to every vertex after the per-draw offset and scale */
+
+        /**
+         * \brief Rotates by the given angle, then squeezes x so the result keeps its shape at the given aspect.
+         */
+        [[nodiscard]] static SceneUniforms rotated(float angle, float aspect);
+    };
+
+    /**
+     * \brief Per-draw data pushed as push constants to the vertex stage.
+     */
+    struct DrawConstants
+    {
+        glm::vec4 tint{1.0f}; /**< Multiplied with the vertex colors */
+        glm::vec2 offset{0.0f}; /**< Translation in model space */
+        glm::vec2 scale{1.0f}; /**< Scale in model space, applied before the offset */
+    };
+
+    static_assert(sizeof(DrawConstants) <= 128u, "Push constants must fit the guaranteed minimum of 128 bytes.");
+
+    /**
+     * \brief Graphics pipeline used to draw the triangle, along with its layouts.
+     *
+     * \details
+     * Viewport and scissor are dynamic state so one pipeline can be used with any render target size.
+     *
+     * SceneUniforms are read through a single dynamic uniform buffer descriptor, meant to point at a UniformRing.
+     * The set is written once, and each frame only passes a new dynamic offset when binding it.
+     */
+    struct TrianglePipeline
+    {
+        vk::DescriptorSetLayout setLayout; /**< Owned by the DescriptorLayoutCache the pipeline was created with */
+        vk::UniquePipelineLayout layout;
+        vk::UniquePipeline pipeline;
+
+        /**
+         * \brief Builds the triangle pipeline for subpass 0 of the provided render pass.
+         * \param device logical device that will own the pipeline.
+         * \param renderPass render pass the pipeline must be compatible with.
+         * \param layouts cache the descriptor set layout is taken from, which must outlive the pipeline.
+         * \param shading fragment stage to build the pipeline with. Both share the same layouts.
+         * \return the pipeline and its layout.
+         */
+        [[nodiscard]] static TrianglePipeline create(const vk::Device &device, const vk::RenderPass &renderPass,
+                                                     DescriptorLayoutCache &layouts,
+                                                     TriangleShading shading = TriangleShading::Color);
+
+        /**
+         * \brief Allocates a persistent set and points its uniform binding at the provided buffer.
+         * \param uniformBuffer buffer the dynamic offsets are relative to, usually UniformRing::getBuffer().
+         */
+        [[nodiscard]] vk::DescriptorSet allocateUniformSet(const vk::Device &device, DescriptorAllocator &descriptors,
+                                                           const vk::Buffer &uniformBuffer) const;
+
+        /**
+         * \brief Binds the pipeline and its uniform set, and pushes the per-draw constants.
+         */
+        void bind(const vk::CommandBuffer &cmd, const vk::DescriptorSet &uniformSet, uint32_t dynamicOffset,
+                  const DrawConstants &constants) const;
+
+        /**
+         * \brief Updates the per-draw constants of a pipeline that is already bound.
+         */
+        void push(const vk::CommandBuffer &cmd, const DrawConstants &constants) const;
+    };
+}
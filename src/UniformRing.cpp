@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <array>
+#include <fmt/format.h>
+#include "DeviceSetup.hpp"
+#include "UniformRing.hpp"
+
+using namespace VkTri;
+
+UniformRing::UniformRing(const vk::PhysicalDevice &physicalDevice, const vk::Device &device,
+                         MemoryTracker &memoryTracker, vk::DeviceSize frameSize, uint32_t frameCount,
+                         vk::BufferUsageFlags usage)
+{
+    auto limits = physicalDevice.getProperties().limits;
+
+    this->device = device;
+    this->frameCount = frameCount;
+    this->atomSize = limits.nonCoherentAtomSize;
+
+    this->alignment = 1u;
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+    {
+        this->alignment = std::max(this->alignment, limits.minUniformBufferOffsetAlignment);
+    }
+    if (usage & vk::BufferUsageFlagBits::eStorageBuffer)
+    {
+        this->alignment = std::max(this->alignment, limits.minStorageBufferOffsetAlignment);
+    }
+    if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer))
+    {
+        // Keeps 32-bit indices and vec4 vertex attributes naturally aligned.
+        this->alignment = std::max<vk::DeviceSize>(this->alignment, 16u);
+    }
+    this->alignment = std::max(this->alignment, this->atomSize);
+
+    // Frame regions start on an aligned boundary, so offsets within a region stay aligned as well.
+    this->frameSize = (frameSize + this->alignment - 1u) / this->alignment * this->alignment;
+
+    vk::BufferCreateInfo bufferInfo;
+    bufferInfo.size = this->frameSize * frameCount;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+    this->buffer = device.createBufferUnique(bufferInfo);
+    auto requirements = device.getBufferMemoryRequirements(this->buffer.get());
+
+    // Prefer memory the GPU reads at full speed (UMA or resizable BAR), then plain coherent host memory.
+    const std::array<vk::MemoryPropertyFlags, 3> preferences = {
+            vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::MemoryPropertyFlagBits::eHostVisible
+    };
+
+    for (const auto &properties : preferences)
+    {
+        try
+        {
+            findMemoryType(physicalDevice, requirements.memoryTypeBits, properties);
+        }
+        catch (const std::runtime_error &)
+        {
+            continue;
+        }
+
+        this->memory = memoryTracker.allocate(requirements, properties, MemoryCategory::Buffer);
+        this->coherent = static_cast<bool>(properties & vk::MemoryPropertyFlagBits::eHostCoherent);
+        break;
+    }
+
+    if (!this->memory)
+    {
+        throw std::runtime_error("Failed to find host visible memory for the uniform ring.");
+    }
+
+    device.bindBufferMemory(this->buffer.get(), this->memory.get(), 0);
+    this->mapped = static_cast<uint8_t *>(device.mapMemory(this->memory.get(), 0, VK_WHOLE_SIZE));
+}
+
+UniformRing::~UniformRing()
+{
+    if (this->mapped != nullptr)
+    {
+        this->device.unmapMemory(this->memory.get());
+    }
+}
+
+void UniformRing::beginFrame(uint32_t frameIndex)
+{
+    this->frame = frameIndex % this->frameCount;
+    this->head = 0u;
+}
+
+RingAllocation UniformRing::allocate(vk::DeviceSize size)
+{
+    auto offset = (this->head + this->alignment - 1u) / this->alignment * this->alignment;
+    if (offset + size > this->frameSize)
+    {
+        throw std::runtime_error(fmt::format("Uniform ring exhausted: {:d} bytes requested, {:d} of {:d} in use.",
+                                             size, this->head, this->frameSize));
+    }
+    this->head = offset + size;
+
+    auto frameBase = this->frameSize * this->frame;
+
+    RingAllocation allocation;
+    allocation.data = this->mapped + frameBase + offset;
+    allocation.offset = static_cast<uint32_t>(frameBase + offset);
+    return allocation;
+}
+
+void UniformRing::flush()
+{
+    if (this->coherent || this->head == 0u)
+    {
+        return;
+    }
+
+    auto size = (this->head + this->atomSize - 1u) / this->atomSize * this->atomSize;
+    this->device.flushMappedMemoryRanges(
+            vk::MappedMemoryRange(this->memory.get(), this->frameSize * this->frame,
+                                  std::min(size, this->frameSize)));
+}
+
+vk::Buffer UniformRing::getBuffer() const noexcept
+{
+    return this->buffer.get();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstring>
+
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include <vulkan/vulkan.hpp>
+
+#include "MemoryTracker.hpp"
+
+namespace VkTri
+{
+    /**
+     * \brief Space handed out by UniformRing::allocate().
+     */
+    struct RingAllocation
+    {
+        void *data = nullptr; /**< Mapped pointer to write the data through */
+        uint32_t offset = 0u; /**< Offset into getBuffer(), usable as a dynamic offset or a vertex/index offset */
+    };
+
+    /**
+     * \brief Persistently mapped buffer sub-allocated linearly for per-frame shader data or streamed geometry.
+     *
+     * \details
+     * The buffer is split into one region per frame in flight. Each frame's region is rewound in beginFrame()
+     * once the GPU is done with it, and allocations within it are aligned for use as dynamic uniform or storage
+     * buffer offsets. The descriptor pointing at the ring is written once, so updating per-frame data costs a
+     * memcpy and a dynamic offset. Nothing is mapped, unmapped or written to descriptors per frame.
+     */
+    class UniformRing
+    {
+    private:
+        vk::Device device;
+        vk::UniqueBuffer buffer;
+        DeviceAllocation memory;
+        uint8_t *mapped = nullptr;
+        bool coherent = true;
+
+        vk::DeviceSize frameSize;
+        vk::DeviceSize alignment;
+        vk::DeviceSize atomSize; /**< nonCoherentAtomSize, used to round flushed ranges */
+        uint32_t frameCount;
+
+        uint32_t frame = 0u;
+        vk::DeviceSize head = 0u; /**< Offset of the next allocation within the current frame's region */
+
+    public:
+        /**
+         * \param frameSize bytes available to each frame.
+         * \param frameCount number of frames in flight.
+         * \param usage eUniformBuffer, eStorageBuffer, eVertexBuffer and/or eIndexBuffer.
+         */
+        UniformRing(const vk::PhysicalDevice &physicalDevice, const vk::Device &device, MemoryTracker &memoryTracker,
+                    vk::DeviceSize frameSize, uint32_t frameCount, vk::BufferUsageFlags usage);
+
+        ~UniformRing();
+
+        /**
+         * \brief Rewinds the region of the given frame. The GPU must be done with that frame.
+         */
+        void beginFrame(uint32_t frameIndex);
+
+        /**
+         * \brief Reserves aligned space in the current frame's region.
+         */
+        RingAllocation allocate(vk::DeviceSize size);
+
+        /**
+         * \brief Copies a value into the ring.
+         * \return the dynamic offset to bind it with.
+         */
+        template<typename T>
+        uint32_t push(const T &value)
+        {
+            auto allocation = this->allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation.offset;
+        }
+
+        /**
+         * \brief Makes the current frame's writes visible to the device. A no-op on coherent memory.
+         */
+        void flush();
+
+        [[nodiscard]] vk::Buffer getBuffer() const noexcept;
+    };
+}
@@ -2,9 +2,18 @@
 #define EXIT_FAILURE 1
 
 #include "TriangleApp.hpp"
+#include "DeviceFarm.hpp"
+#include "ComputeRunner.hpp"
+#include "DeviceSetup.hpp"
+#ifdef VK_TRI_SOFTWARE_WINDOW
+#include "SoftwareWindow.hpp"
+#endif
 
 #include <iostream>
 #include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <string>
 
 #include <fmt/format.h>
 
@@ -12,13 +21,136 @@ using namespace VkTri;
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
 
+#ifdef NDEBUG
+static constexpr bool enableValidationLayers = false;
+#else
+static constexpr bool enableValidationLayers = true;
+#endif // NDEBUG
+
 void errHandler(int num, const char* desc)
 {
     throw std::runtime_error(fmt::format(FMT_STRING("GLFW Error ({:d}): {:s}"), num, desc));
 }
 
-int main()
+/**
+ * \brief Renders a batch of frames on every suitable device without opening a window.
+ * \param jobCount number of frames to render.
+ * \return process exit code.
+ */
+int runOffscreen(uint64_t jobCount)
 {
+    auto farm = DeviceFarm::create(vk::Extent2D(TriangleApp::WIDTH, TriangleApp::HEIGHT), enableValidationLayers);
+    farm->calibrate(4);
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = farm->render(jobCount);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Every frame is cleared to a color derived from its job, so the first pixel proves the ordering.
+    uint64_t misplaced = 0u;
+    for (uint64_t i = 0; i < results.size(); i++)
+    {
+        auto expected = FrameRenderer::jobClearColor(i);
+        if (results[i].jobIndex != i || std::memcmp(results[i].pixels.data(), expected.data(), expected.size()) != 0)
+        {
+            misplaced++;
+        }
+    }
+
+    std::cout << fmt::format("Rendered {:d} frames on {:d} device(s) in {:.3f}s ({:.1f} frames/s)\n",
+                             jobCount, farm->deviceCount(), elapsed.count(), jobCount / elapsed.count());
+    for (const auto &deviceStats : farm->getStats())
+    {
+        std::cout << fmt::format("\t{:s}: {:d} frames, {:.1f} frames/s\n", deviceStats.deviceName,
+                                 deviceStats.jobsRendered, deviceStats.framesPerSecond);
+    }
+
+    if (misplaced != 0u)
+    {
+        std::cerr << fmt::format("{:d} frame(s) came back out of order or with the wrong contents.\n", misplaced);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * \brief Runs the compute kernels on every device with a compute queue, without creating a window or surface.
+ * \param elementCount number of floats each kernel processes.
+ * \param batchSize runs of each kernel recorded into one submission.
+ * \return process exit code.
+ */
+int runCompute(uint32_t elementCount, uint32_t batchSize)
+{
+    auto instance = createHeadlessInstance("Vulkan Triangle Compute", enableValidationLayers);
+
+    bool failed = false;
+    for (const auto &device : instance->enumeratePhysicalDevices())
+    {
+        if (!ComputeRunner::isSuitable(device))
+        {
+            continue;
+        }
+
+        auto runner = ComputeRunner::create(device, elementCount);
+        auto report = runner->run(batchSize);
+
+        std::cout << fmt::format("{:s}: {:d} elements, {:d} runs per submission, timed on the {:s}\n",
+                                 report.deviceName, elementCount, batchSize, report.gpuTimestamps ? "GPU" : "CPU");
+        for (const auto &kernel : report.kernels)
+        {
+            std::cout << fmt::format("\t{:<8s}{:>3d} dispatch(es){:>10.3f} ms/run{:>9.2f} GB/s\t{:s}\n",
+                                     kernel.kernel, kernel.dispatchesPerRun, kernel.msPerRun,
+                                     kernel.gigabytesPerSecond, kernel.correct ? "ok" : "WRONG RESULT");
+            failed = failed || !kernel.correct;
+        }
+        std::cout << fmt::format("\tdispatch overhead {:.2f} us in a batch, {:.2f} us per submit and wait\n",
+                                 report.dispatchOverheadUs, report.submitOverheadUs);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * \brief Shows the triangle rendered on the CPU, for when Vulkan is unavailable.
+ * \return process exit code.
+ */
+int runSoftwareWindow()
+{
+#ifdef VK_TRI_SOFTWARE_WINDOW
+    unique_ptr<SoftwareWindow> window;
+    try
+    {
+        window = SoftwareWindow::create(TriangleApp::WIDTH, TriangleApp::HEIGHT);
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << fmt::format("{:s} Use --offscreen to render without a window.\n", err.what());
+        return EXIT_FAILURE;
+    }
+    window->run();
+    return EXIT_SUCCESS;
+#else
+    std::cerr << "Built without OpenGL, so software frames can't be shown. Use --offscreen to render them.\n";
+    return EXIT_FAILURE;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "--offscreen") == 0)
+    {
+        uint64_t jobCount = argc >= 3 ? std::stoull(argv[2]) : 64u;
+        return runOffscreen(jobCount);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--compute") == 0)
+    {
+        auto elementCount = static_cast<uint32_t>(argc >= 3 ? std::stoul(argv[2]) : 1u << 22u);
+        auto batchSize = static_cast<uint32_t>(argc >= 4 ? std::stoul(argv[3]) : 16u);
+        return runCompute(elementCount, batchSize);
+    }
+
     // Init the library
     if (!glfwInit())
     {
@@ -28,7 +160,20 @@ int main()
 
     glfwSetErrorCallback(errHandler);
 
-    auto triApp = TriangleApp::create();
+    shared_ptr<TriangleApp> triApp;
+    try
+    {
+        triApp = TriangleApp::create();
+    }
+    catch (const VulkanUnavailable &err)
+    {
+        // No loader, no driver or no suitable device. The software renderer needs none of them.
+        std::clog << fmt::format("Vulkan is unavailable ({:s}), falling back to the software renderer.\n",
+                                 err.what());
+        auto result = runSoftwareWindow();
+        glfwTerminate();
+        return result;
+    }
 
     triApp->run();
 
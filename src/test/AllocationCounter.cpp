@@ -0,0 +1,149 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+static std::atomic<uint64_t> allocationCount{0u};
+
+uint64_t VkTri::heapAllocationCount() noexcept
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Counts and performs one allocation, returning null on failure like malloc.
+ */
+static void *countedAlloc(size_t size) noexcept
+{
+    allocationCount.fetch_add(1u, std::memory_order_relaxed);
+    return std::malloc(size != 0u ? size : 1u);
+}
+
+static void *countedAlignedAlloc(size_t size, std::align_val_t alignment) noexcept
+{
+    allocationCount.fetch_add(1u, std::memory_order_relaxed);
+
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    auto align = static_cast<size_t>(alignment);
+    auto rounded = (size + align - 1u) / align * align;
+    return std::aligned_alloc(align, rounded != 0u ? rounded : align);
+}
+
+// Every replaceable form is replaced, since the library is free to implement any of them without the others.
+
+void *operator new(size_t size)
+{
+    if (void *memory = countedAlloc(size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (void *memory = countedAlloc(size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *memory = countedAlignedAlloc(size, alignment))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void *memory = countedAlignedAlloc(size, alignment))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedAlloc(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VkTri
+{
+    /**
+     * \brief Number of times the global operator new has been called since the program started.
+     *
+     * \details
+     * Only available in test executables that compile AllocationCounter.cpp, which replaces the global
+     * operator new and operator delete in all their forms, so array, nothrow and over-aligned allocations are
+     * counted as well.
+     */
+    [[nodiscard]] uint64_t heapAllocationCount() noexcept;
+}
@@ -0,0 +1,131 @@
+#include "Batcher2D.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace VkTri;
+
+static constexpr uint32_t TEXTURE_COUNT = 8u;
+static constexpr uint16_t LAYER_COUNT = 4u;
+
+/**
+ * \brief Counts the draws a renderer would issue without sorting, i.e. one per state change in submission order.
+ */
+static size_t unsortedDraws(const vector<std::pair<Pipeline2D, uint32_t>> &states)
+{
+    size_t draws = 0u;
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        if (i == 0u || states[i] != states[i - 1u])
+        {
+            draws++;
+        }
+    }
+    return draws;
+}
+
+int main(int argc, char **argv)
+{
+    size_t primitivesPerFrame = argc > 1 ? std::stoul(argv[1]) : 20000u;
+    size_t frames = argc > 2 ? std::stoul(argv[2]) : 200u;
+
+    // A UI-like mix: mostly solid quads, some additive highlights and textured glyph quads, over a few layers.
+    std::mt19937 random(1234u);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1024.0f);
+    std::uniform_int_distribution<uint32_t> kind(0u, 9u);
+    std::uniform_int_distribution<uint32_t> texture(1u, TEXTURE_COUNT);
+    std::uniform_int_distribution<uint32_t> layer(0u, LAYER_COUNT - 1u);
+
+    struct Submission
+    {
+        uint16_t layer;
+        Pipeline2D pipeline;
+        uint32_t texture;
+        bool triangle;
+        glm::vec2 min;
+        glm::vec2 max;
+    };
+
+    vector<Submission> submissions(primitivesPerFrame);
+    vector<std::pair<Pipeline2D, uint32_t>> states(primitivesPerFrame);
+    size_t triangleCount = 0u;
+    for (size_t i = 0; i < primitivesPerFrame; i++)
+    {
+        auto &submission = submissions[i];
+        auto roll = kind(random);
+        submission.layer = static_cast<uint16_t>(layer(random));
+        submission.pipeline = roll < 6u ? Pipeline2D::Solid : (roll < 7u ? Pipeline2D::Additive : Pipeline2D::Textured);
+        submission.texture = submission.pipeline == Pipeline2D::Textured ? texture(random) : 0u;
+        submission.triangle = roll % 3u == 0u;
+        submission.min = glm::vec2(coordinate(random), coordinate(random));
+        submission.max = submission.min + glm::vec2(8.0f, 8.0f);
+        states[i] = {submission.pipeline, submission.texture};
+        triangleCount += submission.triangle ? 1u : 0u;
+    }
+
+    Batcher2D batcher;
+    const glm::vec4 color(1.0f, 1.0f, 1.0f, 0.5f);
+
+    auto run = [&]()
+    {
+        batcher.begin();
+        for (const auto &submission : submissions)
+        {
+            if (submission.triangle)
+            {
+                batcher.addTriangle(submission.layer, submission.pipeline, submission.texture,
+                                    Vertex2D{submission.min, glm::vec2(0.0f), color},
+                                    Vertex2D{glm::vec2(submission.max.x, submission.min.y), glm::vec2(1.0f, 0.0f),
+                                             color},
+                                    Vertex2D{submission.max, glm::vec2(1.0f), color});
+            }
+            else
+            {
+                batcher.addRect(submission.layer, submission.pipeline, submission.texture, submission.min,
+                                submission.max, color);
+            }
+        }
+        batcher.end();
+    };
+
+    // Warm up so the batcher's buffers reach their steady-state capacity.
+    run();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        run();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto expectedIndices = triangleCount * 3u + (primitivesPerFrame - triangleCount) * 6u;
+    if (batcher.getIndices().size() != expectedIndices || batcher.primitiveCount() != primitivesPerFrame)
+    {
+        std::cerr << fmt::format("Batch has {:d} indices, expected {:d}\n", batcher.getIndices().size(),
+                                 expectedIndices);
+        return EXIT_FAILURE;
+    }
+
+    // Sorting leaves at most one draw per distinct state per layer.
+    auto maxDraws = static_cast<size_t>(LAYER_COUNT) * (TEXTURE_COUNT + 2u);
+    if (batcher.getDraws().size() > maxDraws)
+    {
+        std::cerr << fmt::format("Batch has {:d} draws, expected at most {:d}\n", batcher.getDraws().size(),
+                                 maxDraws);
+        return EXIT_FAILURE;
+    }
+
+    std::clog << fmt::format("Primitives per frame: {:d}\n", primitivesPerFrame);
+    std::clog << fmt::format("Primitives per second: {:.3f}M\n",
+                             static_cast<double>(primitivesPerFrame * frames) / elapsed / 1.0e6);
+    std::clog << fmt::format("CPU time per frame: {:.3f}ms\n", elapsed * 1.0e3 / static_cast<double>(frames));
+    std::clog << fmt::format("Draws per frame: {:d} (unsorted: {:d})\n", batcher.getDraws().size(),
+                             unsortedDraws(states));
+
+    return EXIT_SUCCESS;
+}
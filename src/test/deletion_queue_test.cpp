@@ -0,0 +1,143 @@
+#include "DeletionQueue.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace VkTri;
+
+/**
+ * \brief Stands in for a GPU resource and records when it is destroyed.
+ */
+class TrackedResource
+{
+private:
+    int id;
+    std::vector<int> *destroyed;
+
+public:
+    TrackedResource(int id, std::vector<int> &destroyed) : id(id), destroyed(&destroyed)
+    {}
+
+    TrackedResource(TrackedResource &&other) noexcept
+            : id(other.id), destroyed(std::exchange(other.destroyed, nullptr))
+    {}
+
+    TrackedResource(const TrackedResource &) = delete;
+
+    TrackedResource &operator=(const TrackedResource &) = delete;
+
+    TrackedResource &operator=(TrackedResource &&) = delete;
+
+    ~TrackedResource()
+    {
+        if (this->destroyed != nullptr)
+        {
+            this->destroyed->push_back(this->id);
+        }
+    }
+};
+
+static void expect(bool condition, const std::string &message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+static void expectDestroyed(const std::vector<int> &destroyed, const std::vector<int> &expected, const char *when)
+{
+    expect(destroyed == expected, fmt::format("{:s}: destroyed [{:d}], expected [{:d}]", when,
+                                              fmt::join(destroyed, ", "), fmt::join(expected, ", ")));
+}
+
+/**
+ * \brief A resource lives until the frame it was retired in has completed, and no longer.
+ */
+static void testRetireByFrame()
+{
+    std::vector<int> destroyed;
+    DeletionQueue queue;
+
+    queue.defer(0u, TrackedResource(0, destroyed));
+    queue.defer(1u, TrackedResource(1, destroyed));
+    queue.defer(3u, TrackedResource(3, destroyed));
+    expect(queue.size() == 3u, fmt::format("Queue holds {:d} entries instead of 3", queue.size()));
+    expectDestroyed(destroyed, {}, "After defer");
+
+    // Frame 0 means no frame used the resource, so it goes as soon as anything is collected.
+    expect(queue.collect(0u) == 1u, "collect(0) did not destroy exactly the unused resource");
+    expectDestroyed(destroyed, {0}, "Frame 0 complete");
+
+    expect(queue.collect(2u) == 1u, "collect(2) did not destroy exactly the resource of frame 1");
+    expectDestroyed(destroyed, {0, 1}, "Frame 2 complete");
+
+    expect(queue.collect(2u) == 0u, "Collecting the same frame twice destroyed something");
+    expect(queue.collect(3u) == 1u, "collect(3) did not destroy the resource of frame 3");
+    expectDestroyed(destroyed, {0, 1, 3}, "Frame 3 complete");
+    expect(queue.empty(), "Queue is not empty after its last frame completed");
+}
+
+/**
+ * \brief Resources of the same frame are destroyed in the order they were deferred.
+ */
+static void testOrdering()
+{
+    std::vector<int> destroyed;
+    DeletionQueue queue;
+
+    // Like retireFrameGraph(): framebuffers go before the frame graph that owns their images.
+    for (int id = 0; id < 4; id++)
+    {
+        queue.defer(5u, TrackedResource(id, destroyed));
+    }
+    queue.defer(6u, TrackedResource(4, destroyed));
+
+    expect(queue.collect(5u) == 4u, "collect(5) did not destroy the four resources of frame 5");
+    expectDestroyed(destroyed, {0, 1, 2, 3}, "Frame 5 complete");
+}
+
+/**
+ * \brief flush() destroys everything regardless of frame, and accepts any movable type.
+ */
+static void testFlush()
+{
+    std::vector<int> destroyed;
+    DeletionQueue queue;
+
+    std::vector<TrackedResource> views;
+    views.emplace_back(1, destroyed);
+    views.emplace_back(2, destroyed);
+    queue.defer(10u, std::move(views));
+    queue.defer(11u, std::make_unique<TrackedResource>(3, destroyed));
+    queue.defer(12u, TrackedResource(4, destroyed));
+
+    expect(queue.collect(9u) == 0u, "Resources were destroyed before their frame completed");
+    queue.flush();
+    expectDestroyed(destroyed, {1, 2, 3, 4}, "After flush");
+    expect(queue.empty() && queue.size() == 0u, "Queue is not empty after flush");
+}
+
+int main()
+{
+    try
+    {
+        testRetireByFrame();
+        testOrdering();
+        testFlush();
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+#include "DescriptorAllocator.hpp"
+#include "DeviceSetup.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+using namespace VkTri;
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+/**
+ * \brief Pool bookkeeping of the intercepted descriptor functions.
+ *
+ * \details
+ * Drivers are free to hand out more sets than a pool's maxSets, and software ICDs often do. The interceptors
+ * enforce the limit themselves, so the allocator sees eErrorOutOfPoolMemory at the same point on every driver.
+ * They can also fail the next allocation with any result, which no driver does on demand.
+ */
+struct PoolState
+{
+    uint32_t maxSets = 0u;
+    uint32_t allocatedSets = 0u;
+    uint32_t resets = 0u;
+};
+
+static PFN_vkCreateDescriptorPool driverCreateDescriptorPool = nullptr;
+static PFN_vkDestroyDescriptorPool driverDestroyDescriptorPool = nullptr;
+static PFN_vkResetDescriptorPool driverResetDescriptorPool = nullptr;
+static PFN_vkAllocateDescriptorSets driverAllocateDescriptorSets = nullptr;
+
+static std::map<VkDescriptorPool, PoolState> pools;
+static vector<uint32_t> createdPoolSizes; /**< maxSets of every pool, in creation order */
+static VkResult nextAllocationResult = VK_SUCCESS;
+
+static VKAPI_ATTR VkResult VKAPI_CALL createDescriptorPool(VkDevice device,
+                                                           const VkDescriptorPoolCreateInfo *pCreateInfo,
+                                                           const VkAllocationCallbacks *pAllocator,
+                                                           VkDescriptorPool *pDescriptorPool)
+{
+    auto result = driverCreateDescriptorPool(device, pCreateInfo, pAllocator, pDescriptorPool);
+    if (result == VK_SUCCESS)
+    {
+        pools[*pDescriptorPool].maxSets = pCreateInfo->maxSets;
+        createdPoolSizes.push_back(pCreateInfo->maxSets);
+    }
+    return result;
+}
+
+static VKAPI_ATTR void VKAPI_CALL destroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool,
+                                                        const VkAllocationCallbacks *pAllocator)
+{
+    pools.erase(descriptorPool);
+    driverDestroyDescriptorPool(device, descriptorPool, pAllocator);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL resetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool,
+                                                          VkDescriptorPoolResetFlags flags)
+{
+    auto &pool = pools.at(descriptorPool);
+    pool.allocatedSets = 0u;
+    pool.resets++;
+    return driverResetDescriptorPool(device, descriptorPool, flags);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL allocateDescriptorSets(VkDevice device,
+                                                             const VkDescriptorSetAllocateInfo *pAllocateInfo,
+                                                             VkDescriptorSet *pDescriptorSets)
+{
+    auto &pool = pools.at(pAllocateInfo->descriptorPool);
+    if (nextAllocationResult != VK_SUCCESS)
+    {
+        return std::exchange(nextAllocationResult, VK_SUCCESS);
+    }
+    if (pool.allocatedSets + pAllocateInfo->descriptorSetCount > pool.maxSets)
+    {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
+    auto result = driverAllocateDescriptorSets(device, pAllocateInfo, pDescriptorSets);
+    if (result == VK_SUCCESS)
+    {
+        pool.allocatedSets += pAllocateInfo->descriptorSetCount;
+    }
+    return result;
+}
+
+static void interceptDescriptorPools()
+{
+    auto &dispatcher = VULKAN_HPP_DEFAULT_DISPATCHER;
+    driverCreateDescriptorPool = std::exchange(dispatcher.vkCreateDescriptorPool, createDescriptorPool);
+    driverDestroyDescriptorPool = std::exchange(dispatcher.vkDestroyDescriptorPool, destroyDescriptorPool);
+    driverResetDescriptorPool = std::exchange(dispatcher.vkResetDescriptorPool, resetDescriptorPool);
+    driverAllocateDescriptorSets = std::exchange(dispatcher.vkAllocateDescriptorSets, allocateDescriptorSets);
+}
+
+static void expect(bool condition, const string &message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+static uint32_t totalResets()
+{
+    uint32_t resets = 0u;
+    for (const auto &entry : pools)
+    {
+        resets += entry.second.resets;
+    }
+    return resets;
+}
+
+static vk::UniqueDevice createDevice(const vk::Instance &instance)
+{
+    auto devices = instance.enumeratePhysicalDevices();
+    if (devices.empty())
+    {
+        throw std::runtime_error("Failed to find a Vulkan device.");
+    }
+
+    auto family = findQueueFamily(devices[0], vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute);
+    if (!family.has_value())
+    {
+        family = findQueueFamily(devices[0], vk::QueueFlagBits::eCompute);
+    }
+
+    float queuePriority = 1.0f;
+    vk::DeviceQueueCreateInfo queueCreateInfo;
+    queueCreateInfo.queueFamilyIndex = family.value();
+    queueCreateInfo.queueCount = 1u;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    vk::DeviceCreateInfo createInfo;
+    createInfo.queueCreateInfoCount = 1u;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+
+    return devices[0].createDeviceUnique(createInfo);
+}
+
+/**
+ * \brief Pools double from 64 sets per pool, up to 4096.
+ */
+static void testGrowth(const vk::Device &device, const vk::DescriptorSetLayout &layout)
+{
+    createdPoolSizes.clear();
+    DescriptorAllocator allocator(device, 1u);
+
+    // 64 + 128 + ... + 2048 sets fill the first six pools, the next set needs a seventh.
+    const vector<uint32_t> expectedSizes = {64u, 128u, 256u, 512u, 1024u, 2048u, 4096u, 4096u};
+    const uint32_t setCount = 64u + 128u + 256u + 512u + 1024u + 2048u + 4096u + 1u;
+    for (uint32_t i = 0; i < setCount; i++)
+    {
+        static_cast<void>(allocator.allocateTransient(layout));
+        if (i == 63u || i == 64u)
+        {
+            expect(allocator.poolCount() == i / 64u + 1u,
+                   fmt::format("{:d} pool(s) after {:d} sets", allocator.poolCount(), i + 1u));
+        }
+    }
+
+    expect(createdPoolSizes == expectedSizes,
+           fmt::format("Pools were created with {:d} sets", fmt::join(createdPoolSizes, ", ")));
+    expect(allocator.poolCount() == expectedSizes.size(),
+           fmt::format("Allocator reports {:d} pools instead of {:d}", allocator.poolCount(), expectedSizes.size()));
+}
+
+/**
+ * \brief A full or fragmented pool moves allocation on to the next pool, any other failure is an error.
+ */
+static void testRollover(const vk::Device &device, const vk::DescriptorSetLayout &layout)
+{
+    DescriptorAllocator allocator(device, 1u);
+    static_cast<void>(allocator.allocateTransient(layout));
+
+    nextAllocationResult = VK_ERROR_FRAGMENTED_POOL;
+    static_cast<void>(allocator.allocateTransient(layout));
+    expect(allocator.poolCount() == 2u, "Fragmented pool did not roll over to a new pool");
+
+    nextAllocationResult = VK_ERROR_OUT_OF_POOL_MEMORY;
+    static_cast<void>(allocator.allocateTransient(layout));
+    expect(allocator.poolCount() == 3u, "Exhausted pool did not roll over to a new pool");
+
+    nextAllocationResult = VK_ERROR_OUT_OF_HOST_MEMORY;
+    bool threw = false;
+    try
+    {
+        static_cast<void>(allocator.allocateTransient(layout));
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    expect(threw && allocator.poolCount() == 3u, "Out of host memory was treated as a full pool");
+
+    // A set that does not fit a pool just created for it would not fit any other pool.
+    DescriptorAllocator empty(device, 1u);
+    nextAllocationResult = VK_ERROR_OUT_OF_POOL_MEMORY;
+    threw = false;
+    try
+    {
+        static_cast<void>(empty.allocateTransient(layout));
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    expect(threw && empty.poolCount() == 1u, "Set that does not fit a fresh pool kept creating pools");
+}
+
+/**
+ * \brief beginFrame() resets the pools of its frame slot only, and their pools are reused afterwards.
+ */
+static void testBeginFrame(const vk::Device &device, const vk::DescriptorSetLayout &layout)
+{
+    DescriptorAllocator allocator(device, 2u);
+    auto resetsBefore = totalResets();
+
+    static_cast<void>(allocator.allocatePersistent(layout));
+    for (uint32_t i = 0; i < 100u; i++)
+    {
+        static_cast<void>(allocator.allocateTransient(layout));
+    }
+    expect(allocator.poolCount() == 3u, fmt::format("{:d} pools after frame 0", allocator.poolCount()));
+
+    allocator.beginFrame(1u);
+    expect(totalResets() == resetsBefore, "Frame slot without pools reset a pool");
+    for (uint32_t i = 0; i < 10u; i++)
+    {
+        static_cast<void>(allocator.allocateTransient(layout));
+    }
+    expect(allocator.poolCount() == 4u, "Second frame slot shares pools with the first");
+
+    allocator.beginFrame(0u);
+    expect(totalResets() == resetsBefore + 2u,
+           fmt::format("Frame 0 reset {:d} pools instead of its 2", totalResets() - resetsBefore));
+    for (uint32_t i = 0; i < 100u; i++)
+    {
+        static_cast<void>(allocator.allocateTransient(layout));
+    }
+    expect(allocator.poolCount() == 4u, "Steady-state frame created a pool");
+
+    // 64 persistent sets fit the persistent pool, which frame resets must not have emptied.
+    for (uint32_t i = 0; i < 63u; i++)
+    {
+        static_cast<void>(allocator.allocatePersistent(layout));
+    }
+    expect(allocator.poolCount() == 4u, "Persistent pool was reset by beginFrame()");
+    static_cast<void>(allocator.allocatePersistent(layout));
+    expect(allocator.poolCount() == 5u, "Persistent pool holds more sets than it was created with");
+}
+
+int main()
+{
+    try
+    {
+        auto instance = createHeadlessInstance("Vulkan Triangle Descriptor Allocator Test", false);
+        interceptDescriptorPools();
+        auto device = createDevice(instance.get());
+
+        vk::DescriptorSetLayoutBinding binding(0u, vk::DescriptorType::eUniformBuffer, 1u,
+                                               vk::ShaderStageFlagBits::eCompute);
+        DescriptorLayoutCache layouts(device.get());
+        auto layout = layouts.get({binding});
+
+        testGrowth(device.get(), layout);
+        testRollover(device.get(), layout);
+        testBeginFrame(device.get(), layout);
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "AllocationCounter.hpp"
+#include "FrameArena.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+using namespace VkTri;
+
+static constexpr uint32_t WARMUP_FRAMES = 512u; /**< One full period of the frame sizes recordFrame() uses */
+static constexpr uint32_t FRAMES = 256u;
+
+struct alignas(32) WideRecord
+{
+    uint64_t values[4];
+};
+
+/**
+ * \brief Alignment beyond what plain operator new guarantees, so it is allocated through the align_val_t forms.
+ */
+struct alignas(2 * __STDCPP_DEFAULT_NEW_ALIGNMENT__) OverAligned
+{
+    uint8_t bytes[2 * __STDCPP_DEFAULT_NEW_ALIGNMENT__];
+};
+
+/**
+ * \brief An allocation the counter misses would let a frame that touches the heap pass.
+ */
+static void checkCounter()
+{
+    // Volatile, so the compiler cannot elide the allocations.
+    void *volatile sink = nullptr;
+    auto before = heapAllocationCount();
+
+    sink = new uint32_t;
+    delete static_cast<uint32_t *>(sink);
+    sink = new uint32_t[4];
+    delete[] static_cast<uint32_t *>(sink);
+    sink = new(std::nothrow) uint32_t;
+    delete static_cast<uint32_t *>(sink);
+    sink = new OverAligned;
+    if (reinterpret_cast<uintptr_t>(sink) % alignof(OverAligned) != 0u)
+    {
+        throw std::runtime_error("Over-aligned allocation is misaligned");
+    }
+    delete static_cast<OverAligned *>(sink);
+    sink = new OverAligned[2];
+    delete[] static_cast<OverAligned *>(sink);
+    sink = new(std::nothrow) OverAligned;
+    delete static_cast<OverAligned *>(sink);
+
+    auto counted = heapAllocationCount() - before;
+    if (counted != 6u)
+    {
+        throw std::runtime_error(fmt::format("Counted {:d} of 6 heap allocations", counted));
+    }
+}
+
+/**
+ * \brief Allocates a frame's worth of arrays whose total size varies from frame to frame.
+ */
+static void recordFrame(FrameArena &arena, uint32_t frame)
+{
+    auto count = 64u + (frame * 97u) % 512u;
+
+    auto *indices = arena.allocate<uint32_t>(count);
+    auto *records = arena.allocate<WideRecord>(count / 4u);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        indices[i] = frame + i;
+    }
+
+    if (reinterpret_cast<uintptr_t>(records) % alignof(WideRecord) != 0u)
+    {
+        throw std::runtime_error(fmt::format("Frame {:d}: misaligned allocation", frame));
+    }
+
+    auto *copy = arena.copy(indices, count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (copy[i] != frame + i)
+        {
+            throw std::runtime_error(fmt::format("Frame {:d}: allocations overlap", frame));
+        }
+    }
+}
+
+int main()
+{
+    try
+    {
+        checkCounter();
+
+        // Starts far too small, so the first frames have to overflow and grow the arena.
+        FrameArena arena(256u);
+
+        for (uint32_t frame = 0; frame < WARMUP_FRAMES; frame++)
+        {
+            arena.reset();
+            recordFrame(arena, frame);
+        }
+
+        // Warm-up saw the largest frame, so later frames must fit without the heap.
+        auto before = heapAllocationCount();
+        for (uint32_t frame = 0; frame < FRAMES; frame++)
+        {
+            arena.reset();
+            recordFrame(arena, frame);
+        }
+        auto allocations = heapAllocationCount() - before;
+
+        std::clog << fmt::format("Frame arena grew to {:d} bytes, {:d} heap allocation(s) in {:d} frames\n",
+                                 arena.getCapacity(), allocations, FRAMES);
+        if (allocations != 0u)
+        {
+            std::cerr << "Warmed-up frames allocated on the heap.\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include "FrameGraph.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace VkTri;
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+static constexpr vk::Extent2D EXTENT(64u, 64u);
+static constexpr vk::DeviceSize IMAGE_SIZE = 64u * 64u * 4u;
+
+struct TestGraph
+{
+    FrameGraph graph;
+    ResourceHandle swapChain;
+    ResourceHandle scene;
+    ResourceHandle depth;
+    ResourceHandle bloom;
+    ResourceHandle post;
+};
+
+static void expect(bool condition, const string &message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+/**
+ * \brief Scene pass, a bloom pass nothing reads, two post passes and a blit to the swap chain.
+ */
+static void buildGraph(TestGraph &test)
+{
+    auto &graph = test.graph;
+    auto color = vk::Format::eR8G8B8A8Unorm;
+    test.swapChain = graph.importImage("swapchain", vk::Format::eB8G8R8A8Unorm, EXTENT, vk::ImageLayout::eUndefined,
+                                       vk::ImageLayout::ePresentSrcKHR);
+    test.scene = graph.createImage("scene", color, EXTENT);
+    test.depth = graph.createImage("depth", vk::Format::eD32Sfloat, EXTENT);
+    test.bloom = graph.createImage("bloom", color, EXTENT);
+    test.post = graph.createImage("post", color, EXTENT);
+
+    PassExecutor noop = [](const vk::CommandBuffer &, const FrameGraph &)
+    {};
+    graph.addPass("scene", {{test.scene, ResourceAccess::ColorAttachmentWrite},
+                            {test.depth, ResourceAccess::DepthStencilAttachmentWrite}}, noop);
+    graph.addPass("bloom", {{test.scene, ResourceAccess::SampledRead},
+                            {test.bloom, ResourceAccess::ColorAttachmentWrite}}, noop);
+    graph.addPass("post", {{test.scene, ResourceAccess::SampledRead},
+                           {test.post, ResourceAccess::ColorAttachmentWrite}}, noop);
+    graph.addPass("outline", {{test.scene, ResourceAccess::SampledRead},
+                              {test.post, ResourceAccess::ColorAttachmentWrite}}, noop);
+    graph.addPass("blit", {{test.post, ResourceAccess::TransferSrc},
+                           {test.swapChain, ResourceAccess::TransferDst}}, noop);
+}
+
+/**
+ * \brief Finds the barrier of a resource in a batch and checks its transition.
+ */
+static void expectBarrier(const BarrierBatch &batch, const string &where, ResourceHandle resource,
+                          vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::AccessFlags srcAccess,
+                          vk::AccessFlags dstAccess)
+{
+    for (size_t i = 0; i < batch.barriers.size(); i++)
+    {
+        if (batch.resources[i] != resource)
+        {
+            continue;
+        }
+
+        const auto &barrier = batch.barriers[i];
+        expect(barrier.oldLayout == oldLayout && barrier.newLayout == newLayout,
+               fmt::format("{:s}: resource {:d} goes from {:s} to {:s}", where, resource,
+                           vk::to_string(barrier.oldLayout), vk::to_string(barrier.newLayout)));
+        expect(barrier.srcAccessMask == srcAccess && barrier.dstAccessMask == dstAccess,
+               fmt::format("{:s}: resource {:d} has access {:s} -> {:s}", where, resource,
+                           vk::to_string(barrier.srcAccessMask), vk::to_string(barrier.dstAccessMask)));
+        return;
+    }
+
+    throw std::runtime_error(fmt::format("{:s}: no barrier for resource {:d}", where, resource));
+}
+
+static void testCulling(const TestGraph &test)
+{
+    expect(test.graph.isPassCulled("bloom"), "Pass whose output is never read was not culled");
+    for (const auto &name : {"scene", "post", "outline", "blit"})
+    {
+        expect(!test.graph.isPassCulled(name), fmt::format("Pass {:s} was culled", name));
+    }
+    expect(test.graph.getMemorySlot(test.bloom) < 0, "Image only used by a culled pass got memory");
+}
+
+static void testAliasing(const TestGraph &test)
+{
+    // Depth is dead after the scene pass, so post can reuse its memory. Scene is read until the outline pass.
+    auto &graph = test.graph;
+    expect(graph.getMemorySlot(test.swapChain) < 0, "Imported image got transient memory");
+    expect(graph.getMemorySlot(test.post) == graph.getMemorySlot(test.depth), "Post does not alias depth");
+    expect(graph.getMemorySlot(test.scene) != graph.getMemorySlot(test.depth), "Scene aliases depth");
+    expect(graph.getTransientMemorySize() == 2u * IMAGE_SIZE,
+           fmt::format("Expected {:d} bytes of transient memory, got {:d}", 2u * IMAGE_SIZE,
+                       graph.getTransientMemorySize()));
+}
+
+static void testBarriers(const TestGraph &test)
+{
+    using Layout = vk::ImageLayout;
+    using Access = vk::AccessFlagBits;
+    auto &graph = test.graph;
+    auto colorAccess = Access::eColorAttachmentRead | Access::eColorAttachmentWrite;
+    auto depthAccess = Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite;
+
+    // First uses wait for the last user of the same memory in the previous frame, which only read it.
+    auto &scene = graph.getPassBarriers("scene");
+    expect(scene.barriers.size() == 2u, fmt::format("Scene pass has {:d} barriers", scene.barriers.size()));
+    expectBarrier(scene, "scene", test.scene, Layout::eUndefined, Layout::eColorAttachmentOptimal, {}, colorAccess);
+    expectBarrier(scene, "scene", test.depth, Layout::eUndefined, Layout::eDepthStencilAttachmentOptimal, {},
+                  depthAccess);
+    expect(scene.srcStages == (vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer),
+           "Scene pass waits on the wrong stages");
+
+    expect(graph.getPassBarriers("bloom").barriers.empty(), "Culled pass has barriers");
+
+    // Post takes over the depth memory, so it waits for the depth writes.
+    auto &post = graph.getPassBarriers("post");
+    expect(post.barriers.size() == 2u, fmt::format("Post pass has {:d} barriers", post.barriers.size()));
+    expectBarrier(post, "post", test.scene, Layout::eColorAttachmentOptimal, Layout::eShaderReadOnlyOptimal,
+                  colorAccess, Access::eShaderRead);
+    expectBarrier(post, "post", test.post, Layout::eUndefined, Layout::eColorAttachmentOptimal, depthAccess,
+                  colorAccess);
+
+    // Reading the scene again in the same layout needs nothing, writing post again does.
+    auto &outline = graph.getPassBarriers("outline");
+    expect(outline.barriers.size() == 1u, fmt::format("Outline pass has {:d} barriers", outline.barriers.size()));
+    expectBarrier(outline, "outline", test.post, Layout::eColorAttachmentOptimal, Layout::eColorAttachmentOptimal,
+                  colorAccess, colorAccess);
+
+    auto &blit = graph.getPassBarriers("blit");
+    expect(blit.barriers.size() == 2u, fmt::format("Blit pass has {:d} barriers", blit.barriers.size()));
+    expectBarrier(blit, "blit", test.post, Layout::eColorAttachmentOptimal, Layout::eTransferSrcOptimal,
+                  colorAccess, Access::eTransferRead);
+    expectBarrier(blit, "blit", test.swapChain, Layout::eUndefined, Layout::eTransferDstOptimal, {},
+                  Access::eTransferWrite);
+
+    auto &finalBatch = graph.getFinalBarriers();
+    expect(finalBatch.barriers.size() == 1u, fmt::format("{:d} final barriers", finalBatch.barriers.size()));
+    expectBarrier(finalBatch, "final", test.swapChain, Layout::eTransferDstOptimal, Layout::ePresentSrcKHR,
+                  Access::eTransferWrite, {});
+}
+
+/**
+ * \brief Images only alias when they can live in the same kind of memory.
+ */
+static void testIncompatibleMemory()
+{
+    TestGraph test;
+    buildGraph(test);
+    test.graph.plan([&test](ResourceHandle resource)
+                    {
+                        TransientMemoryNeeds needs;
+                        needs.requirements.size = IMAGE_SIZE;
+                        needs.requirements.memoryTypeBits = ~0u;
+                        needs.lazy = resource == test.depth;
+                        return needs;
+                    });
+
+    expect(test.graph.getMemorySlot(test.post) != test.graph.getMemorySlot(test.depth),
+           "Post aliases depth in lazily allocated memory");
+    expect(test.graph.getTransientMemorySize() == 3u * IMAGE_SIZE, "Incompatible images share memory");
+}
+
+int main()
+{
+    try
+    {
+        TestGraph test;
+        buildGraph(test);
+        test.graph.plan([](ResourceHandle)
+                        {
+                            TransientMemoryNeeds needs;
+                            needs.requirements.size = IMAGE_SIZE;
+                            needs.requirements.memoryTypeBits = ~0u;
+                            return needs;
+                        });
+
+        testCulling(test);
+        testAliasing(test);
+        testBarriers(test);
+        testIncompatibleMemory();
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include "MeshOptimizer.hpp"
+#include "ObjLoader.hpp"
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+using namespace VkTri;
+
+static constexpr float BOUNDS_EPSILON = 1e-4f;
+
+/**
+ * \brief Contents of a .vkmesh file, split into its arrays.
+ */
+struct MeshFile
+{
+    MeshFileHeader header;
+    vector<MeshVertex> vertices;
+    vector<uint32_t> indices;
+    vector<Meshlet> meshlets;
+    vector<uint32_t> meshletVertices;
+    vector<uint8_t> meshletTriangles;
+};
+
+static void expect(bool condition, const std::string &message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+static MeshFile readMesh(const fs::path &path)
+{
+    std::ifstream input(path, std::ios::binary);
+    expect(input.is_open(), fmt::format("Failed to open {:s}", path.string()));
+
+    MeshFile file;
+    auto read = [&input](auto *data, size_t count)
+    {
+        input.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(*data)));
+    };
+
+    read(&file.header, 1u);
+    expect(input && file.header.magic == MESH_FILE_MAGIC && file.header.version == MESH_FILE_VERSION,
+           fmt::format("{:s} is not a version {:d} mesh file", path.string(), MESH_FILE_VERSION));
+
+    file.vertices.resize(file.header.vertexCount);
+    file.indices.resize(file.header.indexCount);
+    file.meshlets.resize(file.header.meshletCount);
+    file.meshletVertices.resize(file.header.meshletVertexCount);
+    file.meshletTriangles.resize(file.header.meshletTriangleCount * 3u);
+
+    read(file.vertices.data(), file.vertices.size());
+    read(file.indices.data(), file.indices.size());
+    read(file.meshlets.data(), file.meshlets.size());
+    read(file.meshletVertices.data(), file.meshletVertices.size());
+    read(file.meshletTriangles.data(), file.meshletTriangles.size());
+    expect(static_cast<bool>(input), fmt::format("{:s} is shorter than its header says", path.string()));
+    expect(input.peek() == std::char_traits<char>::eof(),
+           fmt::format("{:s} is longer than its header says", path.string()));
+
+    return file;
+}
+
+/**
+ * \brief The vertex cache pass must beat the input order, and the overdraw pass may only give back as much as its
+ * threshold allows.
+ */
+static void testPasses(const IndexedMesh &mesh)
+{
+    auto input = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    auto cacheOrder = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    auto cached = analyzeVertexCache(cacheOrder, mesh.vertices.size());
+
+    auto overdrawOrder = optimizeOverdraw(cacheOrder, mesh.vertices);
+    auto overdraw = analyzeVertexCache(overdrawOrder, mesh.vertices.size());
+
+    std::clog << fmt::format("ACMR: input {:.3f}, vertex cache {:.3f}, overdraw {:.3f}\n", input.acmr, cached.acmr,
+                             overdraw.acmr);
+
+    expect(cached.acmr < input.acmr,
+           fmt::format("Vertex cache pass did not lower the ACMR: {:.3f} -> {:.3f}", input.acmr, cached.acmr));
+    expect(overdraw.acmr <= cached.acmr * DEFAULT_OVERDRAW_THRESHOLD,
+           fmt::format("Overdraw pass raised the ACMR from {:.3f} to {:.3f}, past its threshold of {:.2f}",
+                       cached.acmr, overdraw.acmr, DEFAULT_OVERDRAW_THRESHOLD));
+}
+
+/**
+ * \brief The tool's output holds every triangle of the input, in an order at least as cache friendly as the
+ * overdraw pass promises, and its meshlets cover the index list with bounds that contain their vertices.
+ */
+static void testOutput(const IndexedMesh &mesh, const MeshFile &file)
+{
+    std::unordered_set<uint32_t> referenced(mesh.indices.begin(), mesh.indices.end());
+    expect(file.header.indexCount == mesh.indices.size(),
+           fmt::format("Output has {:d} indices, the input {:d}", file.header.indexCount, mesh.indices.size()));
+    expect(file.header.vertexCount == referenced.size(),
+           fmt::format("Output has {:d} vertices, the input references {:d}", file.header.vertexCount,
+                       referenced.size()));
+    for (auto index : file.indices)
+    {
+        expect(index < file.header.vertexCount, fmt::format("Index {:d} is out of range", index));
+    }
+
+    auto cached = analyzeVertexCache(optimizeVertexCache(mesh.indices, mesh.vertices.size()), mesh.vertices.size());
+    auto written = analyzeVertexCache(file.indices, file.vertices.size());
+    expect(written.acmr <= cached.acmr * DEFAULT_OVERDRAW_THRESHOLD,
+           fmt::format("Written order has an ACMR of {:.3f}, the vertex cache pass reached {:.3f}", written.acmr,
+                       cached.acmr));
+
+    uint32_t vertexOffset = 0u, triangleOffset = 0u;
+    for (size_t m = 0; m < file.meshlets.size(); m++)
+    {
+        const auto &meshlet = file.meshlets[m];
+        expect(meshlet.vertexOffset == vertexOffset && meshlet.triangleOffset == triangleOffset,
+               fmt::format("Meshlet {:d} does not follow the previous one", m));
+        expect(meshlet.vertexCount <= MESHLET_MAX_VERTICES && meshlet.triangleCount <= MESHLET_MAX_TRIANGLES,
+               fmt::format("Meshlet {:d} has {:d} vertices and {:d} triangles", m, meshlet.vertexCount,
+                           meshlet.triangleCount));
+        expect(vertexOffset + meshlet.vertexCount <= file.meshletVertices.size() &&
+               triangleOffset + meshlet.triangleCount <= file.header.meshletTriangleCount,
+               fmt::format("Meshlet {:d} reaches past the meshlet arrays", m));
+
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+        {
+            const auto &position = file.vertices[file.meshletVertices[vertexOffset + v]].position;
+            auto dx = position[0] - meshlet.center[0];
+            auto dy = position[1] - meshlet.center[1];
+            auto dz = position[2] - meshlet.center[2];
+            expect(std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.radius + BOUNDS_EPSILON,
+                   fmt::format("Vertex {:d} of meshlet {:d} lies outside its bounding sphere", v, m));
+        }
+        expect(meshlet.coneCutoff >= -1.0f && meshlet.coneCutoff <= 1.0f,
+               fmt::format("Meshlet {:d} has a cone cutoff of {:.3f}", m, meshlet.coneCutoff));
+
+        // Meshlets take triangles in index order, so their local triangles spell out the index list again.
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            for (uint32_t corner = 0; corner < 3u; corner++)
+            {
+                auto local = file.meshletTriangles[(triangleOffset + t) * 3u + corner];
+                expect(local < meshlet.vertexCount, fmt::format("Meshlet {:d} indexes past its vertices", m));
+                expect(file.meshletVertices[vertexOffset + local] == file.indices[(triangleOffset + t) * 3u + corner],
+                       fmt::format("Triangle {:d} of meshlet {:d} differs from the index list", t, m));
+            }
+        }
+
+        vertexOffset += meshlet.vertexCount;
+        triangleOffset += meshlet.triangleCount;
+    }
+
+    expect(vertexOffset == file.header.meshletVertexCount,
+           fmt::format("Meshlets use {:d} of {:d} meshlet vertices", vertexOffset, file.header.meshletVertexCount));
+    expect(triangleOffset * 3u == file.header.indexCount,
+           fmt::format("Meshlets hold {:d} of {:d} triangles", triangleOffset, file.header.indexCount / 3u));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: MeshOptimizerTest <input.obj> <output.vkmesh>\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto mesh = loadObj(argv[1]);
+        testPasses(mesh);
+        testOutput(mesh, readMesh(argv[2]));
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
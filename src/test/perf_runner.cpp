@@ -0,0 +1,209 @@
+#include "AllocationCounter.hpp"
+#include "DeviceSetup.hpp"
+#include "OffscreenRenderer.hpp"
+#include "SceneDescription.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+
+using namespace VkTri;
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+static constexpr double DEFAULT_TOLERANCE = 0.25; /**< Allowed relative slowdown when a baseline sets none */
+
+// =========
+// Baselines
+// =========
+
+using Metrics = std::map<string, double>;
+
+static Metrics readBaseline(const fs::path &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(fmt::format("No baseline at {:s}, record one with --update-baseline",
+                                             path.string()));
+    }
+
+    Metrics baseline;
+    string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream tokens(line);
+        string key;
+        double value;
+        if ((tokens >> key) && key[0] != '#' && (tokens >> value))
+        {
+            baseline[key] = value;
+        }
+    }
+    return baseline;
+}
+
+static void writeBaseline(const fs::path &path, const SceneDescription &scene, const Metrics &metrics)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to write baseline {:s}", path.string()));
+    }
+
+    file << fmt::format("# Baseline for {:s}.scene, recorded with PerfRunner --update-baseline\n", scene.name);
+    for (const auto &[key, value] : metrics)
+    {
+        file << fmt::format("{:s} {:.3f}\n", key, value);
+    }
+}
+
+/**
+ * \brief Nearest-rank percentile of the samples.
+ */
+static double percentile(vector<double> samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+    return samples[std::clamp<size_t>(rank, 1u, samples.size()) - 1u];
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: PerfRunner <scene file> <baseline file> [--update-baseline]\n";
+        return EXIT_FAILURE;
+    }
+
+    fs::path baselinePath(argv[2]);
+    bool updateBaseline = argc >= 4 && std::strcmp(argv[3], "--update-baseline") == 0;
+
+    try
+    {
+        auto scene = SceneDescription::load(argv[1]);
+
+        auto instance = createHeadlessInstance("Vulkan Triangle Perf", false);
+        auto devices = instance->enumeratePhysicalDevices();
+        auto device = std::find_if(devices.begin(), devices.end(), OffscreenRenderer::isSuitable);
+        if (device == devices.end())
+        {
+            throw std::runtime_error("Failed to find a suitable GPU.");
+        }
+
+        auto renderer = OffscreenRenderer::create(*device, scene.extent);
+        renderer->setScene(scene);
+
+        std::clog << fmt::format("Scene {:s} on {:s}: {:d}x{:d}, {:d} triangle(s), {:d} quad(s), {:d} frames\n",
+                                 scene.name, renderer->name(), scene.extent.width, scene.extent.height,
+                                 scene.triangles, scene.quads, scene.frames);
+
+        vector<uint8_t> pixels;
+        for (uint32_t i = 0; i < scene.warmupFrames; i++)
+        {
+            renderer->renderFrame(i, pixels);
+        }
+
+        // Sized up front so that recording the samples does not show up in the allocation counts.
+        vector<double> cpuMs, gpuMs;
+        cpuMs.reserve(scene.frames);
+        gpuMs.reserve(scene.frames);
+        uint64_t maxAllocations = 0u;
+        uint32_t allocatingFrames = 0u;
+
+        for (uint32_t i = 0; i < scene.frames; i++)
+        {
+            auto allocationsBefore = heapAllocationCount();
+            auto start = std::chrono::steady_clock::now();
+
+            renderer->renderFrame(scene.warmupFrames + i, pixels);
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            auto allocations = heapAllocationCount() - allocationsBefore;
+
+            cpuMs.push_back(elapsed.count());
+            maxAllocations = std::max(maxAllocations, allocations);
+            allocatingFrames += allocations != 0u ? 1u : 0u;
+            if (auto frameGpuMs = renderer->lastGpuFrameMs())
+            {
+                gpuMs.push_back(frameGpuMs.value());
+            }
+        }
+
+        // Counters are the same every frame, so the last one stands for all of them.
+        if (const auto *statistics = renderer->getPipelineStatistics())
+        {
+            std::clog << statistics->format();
+        }
+
+        Metrics measured;
+        measured["cpu_p50_ms"] = percentile(cpuMs, 0.50);
+        measured["cpu_p99_ms"] = percentile(cpuMs, 0.99);
+        if (!gpuMs.empty())
+        {
+            measured["gpu_p50_ms"] = percentile(gpuMs, 0.50);
+            measured["gpu_p99_ms"] = percentile(gpuMs, 0.99);
+        }
+        measured["allocations_per_frame"] = static_cast<double>(maxAllocations);
+
+        if (updateBaseline)
+        {
+            measured["tolerance"] = DEFAULT_TOLERANCE;
+            writeBaseline(baselinePath, scene, measured);
+            std::clog << fmt::format("Recorded baseline {:s}\n", baselinePath.string());
+            return EXIT_SUCCESS;
+        }
+
+        auto baseline = readBaseline(baselinePath);
+        auto tolerance = baseline.count("tolerance") != 0u ? baseline["tolerance"] : DEFAULT_TOLERANCE;
+
+        bool regressed = false;
+        for (const auto &[key, value] : measured)
+        {
+            auto expected = baseline.find(key);
+            if (expected == baseline.end())
+            {
+                std::clog << fmt::format("{:<24s}{:>10.3f}\t(no baseline)\n", key, value);
+                continue;
+            }
+
+            // Allocation counts are deterministic, so any increase is a regression.
+            auto limit = key == "allocations_per_frame" ? expected->second : expected->second * (1.0 + tolerance);
+            bool failed = value > limit;
+            regressed = regressed || failed;
+
+            std::clog << fmt::format("{:<24s}{:>10.3f}\tbaseline {:.3f}, limit {:.3f}\t{:s}\n", key, value,
+                                     expected->second, limit, failed ? "REGRESSED" : "ok");
+        }
+
+        // Warmed-up frames draw from arenas, rings and pools sized during warm-up, whatever the baseline says.
+        if (allocatingFrames != 0u)
+        {
+            std::cerr << fmt::format("{:s}: {:d} of {:d} frames allocated on the heap after warm-up.\n", scene.name,
+                                     allocatingFrames, scene.frames);
+            regressed = true;
+        }
+
+        if (regressed)
+        {
+            std::cerr << fmt::format("{:s} regressed past its baseline.\n", scene.name);
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include "AllocationCounter.hpp"
+#include "PresentTiming.hpp"
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace VkTri;
+
+static constexpr uint32_t ALLOCATION_FRAMES = 256u;
+
+/**
+ * \brief Stands in for the display. Each present is shown at a scripted time, or lost if it has none.
+ *
+ * \details
+ * With a gate, waitForPresent() blocks until release() is called, like a presentation engine that has stalled.
+ */
+class MockPresentBackend : public PresentBackend
+{
+private:
+    std::vector<std::optional<double>> displayTimes; /**< Indexed by present id */
+    bool gated;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool blocked = false;
+    bool released = false;
+
+public:
+    MockPresentBackend(std::vector<std::optional<double>> displayTimes, bool gated = false)
+            : displayTimes(std::move(displayTimes)), gated(gated)
+    {
+    }
+
+    std::optional<double> waitForPresent(uint64_t presentId, uint64_t /*timeoutNs*/) override
+    {
+        if (this->gated)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->blocked = true;
+            this->changed.notify_all();
+            this->changed.wait(lock, [this]
+            { return this->released; });
+        }
+
+        return presentId < this->displayTimes.size() ? this->displayTimes[presentId] : std::nullopt;
+    }
+
+    /**
+     * \brief Blocks until the waiter thread is stuck in waitForPresent().
+     */
+    void waitUntilBlocked()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->changed.wait(lock, [this]
+        { return this->blocked; });
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->released = true;
+        }
+        this->changed.notify_all();
+    }
+};
+
+static void expect(bool condition, const string &message)
+{
+    if (!condition)
+    {
+        throw std::runtime_error(message);
+    }
+}
+
+static void expectNear(double actual, double expected, const string &what)
+{
+    expect(std::abs(actual - expected) < 1e-6,
+           fmt::format("{:s}: expected {:.3f}, got {:.3f}", what, expected, actual));
+}
+
+/**
+ * \brief Without a backend, presents count at the time vkQueuePresentKHR returned.
+ */
+static void testFallback()
+{
+    PresentTimer timer;
+    expect(!timer.usesPresentWait(), "Timer without backend claims to use present_wait");
+
+    timer.inputEvent(1.000);
+    timer.inputEvent(1.004); // Only the first input since the last present counts.
+    timer.presented(timer.beginPresent(), 1.010);
+    timer.presented(timer.beginPresent(), 1.030);
+    timer.inputEvent(1.035);
+    timer.presented(timer.beginPresent(), 1.050, false);
+    timer.presented(timer.beginPresent(), 1.070);
+
+    auto latency = timer.getInputToPresent();
+    expect(latency.count() == 1u, fmt::format("Expected 1 input-to-present sample, got {:d}", latency.count()));
+    expectNear(latency.max(), 10.0, "Fallback input to present");
+
+    // The failed present breaks the chain, so only the first interval remains.
+    auto interval = timer.getPresentInterval();
+    expect(interval.count() == 1u, fmt::format("Expected 1 present interval, got {:d}", interval.count()));
+    expectNear(interval.max(), 20.0, "Fallback present interval");
+    expect(timer.getMissedPresents() == 1u, "Failed present was not counted as missed");
+}
+
+/**
+ * \brief With a backend, presents count at the time the display showed them.
+ */
+static void testPresentWait()
+{
+    // Present 3 is dropped by the presentation engine.
+    auto backend = std::make_unique<MockPresentBackend>(std::vector<std::optional<double>>{
+            std::nullopt, 1.016, 1.033, std::nullopt, 1.066, 1.083});
+    PresentTimer timer(std::move(backend));
+    expect(timer.usesPresentWait(), "Timer with backend does not use present_wait");
+
+    timer.inputEvent(1.000);
+    timer.presented(timer.beginPresent(), 1.001);
+    timer.presented(timer.beginPresent(), 1.018);
+    timer.presented(timer.beginPresent(), 1.035);
+    timer.inputEvent(1.020);
+    timer.inputEvent(1.025);
+    timer.presented(timer.beginPresent(), 1.052);
+    timer.presented(timer.beginPresent(), 1.069);
+    timer.flush();
+
+    auto latency = timer.getInputToPresent();
+    expect(latency.count() == 2u, fmt::format("Expected 2 input-to-present samples, got {:d}", latency.count()));
+    expectNear(latency.min(), 16.0, "Input to present of the first frame");
+    expectNear(latency.max(), 46.0, "Input to present of the fourth frame");
+    expect(latency.bucketCount(6u) == 1u && latency.bucketCount(10u) == 1u,
+           "Input to present samples landed in the wrong buckets");
+
+    auto interval = timer.getPresentInterval();
+    expect(interval.count() == 2u, fmt::format("Expected 2 present intervals, got {:d}", interval.count()));
+    expectNear(interval.mean(), 17.0, "Present interval");
+    expect(timer.getMissedPresents() == 1u, "Dropped present was not counted as missed");
+
+    std::clog << timer.format();
+}
+
+/**
+ * \brief A stalled display must not block the caller, presents beyond the queue are counted as missed.
+ */
+static void testStalledDisplay()
+{
+    std::vector<std::optional<double>> displayTimes(PRESENT_QUEUE_SIZE + 5u);
+    for (size_t i = 1; i < displayTimes.size(); i++)
+    {
+        displayTimes[i] = static_cast<double>(i) * 0.010;
+    }
+    auto backend = std::make_unique<MockPresentBackend>(displayTimes, true);
+    auto &gate = *backend;
+    PresentTimer timer(std::move(backend));
+
+    // The waiter takes the first present off the queue and blocks, the queue then fills up.
+    timer.presented(timer.beginPresent(), 0.0);
+    gate.waitUntilBlocked();
+    for (size_t i = 0; i < PRESENT_QUEUE_SIZE + 2u; i++)
+    {
+        timer.presented(timer.beginPresent(), 0.0);
+    }
+    expect(timer.getMissedPresents() == 2u,
+           fmt::format("Expected 2 presents to overflow, got {:d}", timer.getMissedPresents()));
+
+    gate.release();
+    timer.flush();
+    timer.presented(timer.beginPresent(), 0.0);
+    timer.flush();
+
+    // Intervals between the queued presents, none across the overflowed ones.
+    auto interval = timer.getPresentInterval();
+    expect(interval.count() == PRESENT_QUEUE_SIZE,
+           fmt::format("Expected {:d} present intervals, got {:d}", PRESENT_QUEUE_SIZE, interval.count()));
+    expectNear(interval.max(), 10.0, "Present interval after a stall");
+}
+
+/**
+ * \brief Timing a present must not touch the heap, the frame loop is allocation-free once warmed up.
+ */
+static void testAllocations()
+{
+    std::vector<std::optional<double>> displayTimes(ALLOCATION_FRAMES + 1u, 0.0);
+    PresentTimer fallback;
+    PresentTimer timed(std::make_unique<MockPresentBackend>(displayTimes));
+
+    auto before = heapAllocationCount();
+    for (uint32_t frame = 0; frame < ALLOCATION_FRAMES; frame++)
+    {
+        fallback.inputEvent(frame * 0.016);
+        fallback.presented(fallback.beginPresent(), frame * 0.016 + 0.001);
+        timed.inputEvent(frame * 0.016);
+        timed.presented(timed.beginPresent(), frame * 0.016 + 0.001);
+        timed.flush();
+    }
+    auto allocations = heapAllocationCount() - before;
+
+    if (allocations != 0u)
+    {
+        throw std::runtime_error(fmt::format("Timing {:d} presents made {:d} heap allocation(s)", ALLOCATION_FRAMES,
+                                             allocations));
+    }
+}
+
+int main()
+{
+    try
+    {
+        testFallback();
+        testPresentWait();
+        testStalledDisplay();
+        testAllocations();
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include "DeviceSetup.hpp"
+#include "OffscreenRenderer.hpp"
+#include "SoftwareRenderer.hpp"
+#include "SceneDescription.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace VkTri;
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+static constexpr int CHANNEL_TOLERANCE = 2; /**< Rounding differences allowed per channel */
+static constexpr double MAX_MISMATCH = 0.01; /**< Fraction of pixels allowed to differ, e.g. along edges */
+
+struct RasterTiming
+{
+    string name;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+};
+
+/**
+ * \brief Nearest-rank percentile of the samples.
+ */
+static double percentile(vector<double> samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+    return samples[std::clamp<size_t>(rank, 1u, samples.size()) - 1u];
+}
+
+/**
+ * \brief Renders the scene's frames and measures each one, from submission to pixels in host memory.
+ * \param pixels receives the last frame.
+ */
+static RasterTiming measure(FrameRenderer &renderer, const SceneDescription &scene, vector<uint8_t> &pixels)
+{
+    renderer.setScene(scene);
+    for (uint32_t i = 0; i < scene.warmupFrames; i++)
+    {
+        renderer.renderFrame(i, pixels);
+    }
+
+    vector<double> frameMs;
+    frameMs.reserve(scene.frames);
+    for (uint32_t i = 0; i < scene.frames; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        renderer.renderFrame(scene.warmupFrames + i, pixels);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        frameMs.push_back(elapsed.count());
+    }
+
+    RasterTiming timing;
+    timing.name = renderer.name();
+    timing.p50Ms = percentile(frameMs, 0.50);
+    timing.p99Ms = percentile(frameMs, 0.99);
+    std::cout << fmt::format("{:<48s}p50 {:>8.3f} ms\tp99 {:>8.3f} ms\n", timing.name, timing.p50Ms, timing.p99Ms);
+    return timing;
+}
+
+/**
+ * \brief Fraction of pixels where any channel differs by more than CHANNEL_TOLERANCE.
+ */
+static double mismatchedFraction(const vector<uint8_t> &expected, const vector<uint8_t> &actual)
+{
+    size_t mismatched = 0u;
+    for (size_t pixel = 0; pixel + 4u <= expected.size(); pixel += 4u)
+    {
+        for (size_t channel = 0; channel < 4; channel++)
+        {
+            if (std::abs(expected[pixel + channel] - actual[pixel + channel]) > CHANNEL_TOLERANCE)
+            {
+                mismatched++;
+                break;
+            }
+        }
+    }
+    return static_cast<double>(mismatched) / static_cast<double>(expected.size() / 4u);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: RasterBenchmark <scene file>\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto scene = SceneDescription::load(argv[1]);
+        std::cout << fmt::format("Scene {:s}: {:d}x{:d}, {:d} triangle(s), {:d} quad(s), {:d} frames\n",
+                                 scene.name, scene.extent.width, scene.extent.height, scene.triangles, scene.quads,
+                                 scene.frames);
+
+        vector<uint8_t> softwarePixels;
+        auto software = SoftwareRenderer::create(scene.extent);
+        auto softwareTiming = measure(*software, scene, softwarePixels);
+
+        auto instance = createHeadlessInstance("Vulkan Triangle Raster Benchmark", false);
+        auto devices = instance->enumeratePhysicalDevices();
+        auto device = std::find_if(devices.begin(), devices.end(), OffscreenRenderer::isSuitable);
+        if (device == devices.end())
+        {
+            throw std::runtime_error("Failed to find a suitable GPU to compare against.");
+        }
+
+        vector<uint8_t> devicePixels;
+        auto renderer = OffscreenRenderer::create(*device, scene.extent);
+        auto deviceTiming = measure(*renderer, scene, devicePixels);
+
+        // Both rendered the same frame last, so the device's pixels are the reference.
+        auto mismatch = mismatchedFraction(devicePixels, softwarePixels);
+        std::cout << fmt::format("Software renderer takes {:.2f}x the time of {:s}, {:.3f}% of pixels differ\n",
+                                 softwareTiming.p50Ms / deviceTiming.p50Ms, deviceTiming.name, mismatch * 100.0);
+
+        if (mismatch > MAX_MISMATCH)
+        {
+            std::cerr << fmt::format("{:s}: software frame differs from {:s} in more than {:.1f}% of pixels.\n",
+                                     scene.name, deviceTiming.name, MAX_MISMATCH * 100.0);
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <numeric>
+
+#include "MeshOptimizer.hpp"
+
+using namespace VkTri;
+
+using Vec3 = std::array<float, 3>;
+
+static constexpr size_t CACHE_LINE_SIZE = 64u;
+static constexpr size_t FETCH_CACHE_LINES = 64u; /**< Direct mapped 4 KiB vertex fetch cache */
+
+// Scoring constants of Forsyth's algorithm, as tuned in the original article.
+static constexpr size_t FORSYTH_CACHE_SIZE = 32u;
+static constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+static Vec3 sub(const float *a, const float *b)
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+static Vec3 cross(const Vec3 &a, const Vec3 &b)
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+static float dot(const Vec3 &a, const Vec3 &b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * \brief FIFO post-transform cache as implemented by most hardware.
+ */
+class FifoCache
+{
+private:
+    vector<uint32_t> timestamps; /**< Per vertex, time it entered the cache */
+    uint32_t time;
+    uint32_t size;
+
+public:
+    FifoCache(size_t vertexCount, uint32_t size) : timestamps(vertexCount, 0u), time(size + 1u), size(size)
+    {
+    }
+
+    /**
+     * \return true if the vertex had to be transformed.
+     */
+    bool access(uint32_t vertex)
+    {
+        if (this->time - this->timestamps[vertex] > this->size)
+        {
+            this->timestamps[vertex] = this->time++;
+            return true;
+        }
+        return false;
+    }
+
+    void clear()
+    {
+        this->time += this->size + 1u;
+    }
+};
+
+// ========
+// Analysis
+// ========
+
+VertexCacheStats VkTri::analyzeVertexCache(const vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize)
+{
+    FifoCache cache(vertexCount, cacheSize);
+    vector<bool> referenced(vertexCount, false);
+
+    VertexCacheStats stats;
+    for (auto index : indices)
+    {
+        stats.transformed += cache.access(index) ? 1u : 0u;
+        referenced[index] = true;
+    }
+
+    auto referencedCount = std::count(referenced.begin(), referenced.end(), true);
+    auto triangleCount = indices.size() / 3u;
+    stats.acmr = triangleCount != 0u ? static_cast<float>(stats.transformed) / static_cast<float>(triangleCount) : 0.0f;
+    stats.atvr = referencedCount != 0 ? static_cast<float>(stats.transformed) / static_cast<float>(referencedCount)
+                                      : 0.0f;
+    return stats;
+}
+
+VertexFetchStats VkTri::analyzeVertexFetch(const vector<uint32_t> &indices, size_t vertexCount, size_t vertexSize,
+                                           uint32_t cacheSize)
+{
+    FifoCache cache(vertexCount, cacheSize);
+    std::array<size_t, FETCH_CACHE_LINES> lines;
+    lines.fill(std::numeric_limits<size_t>::max());
+    vector<bool> referenced(vertexCount, false);
+
+    VertexFetchStats stats;
+    for (auto index : indices)
+    {
+        referenced[index] = true;
+        if (!cache.access(index))
+        {
+            continue;
+        }
+
+        auto first = index * vertexSize / CACHE_LINE_SIZE;
+        auto last = (index * vertexSize + vertexSize - 1u) / CACHE_LINE_SIZE;
+        for (auto line = first; line <= last; line++)
+        {
+            auto &slot = lines[line % FETCH_CACHE_LINES];
+            if (slot != line)
+            {
+                slot = line;
+                stats.bytesFetched += static_cast<uint32_t>(CACHE_LINE_SIZE);
+            }
+        }
+    }
+
+    auto referencedBytes = std::count(referenced.begin(), referenced.end(), true) * vertexSize;
+    stats.overfetch = referencedBytes != 0u ? static_cast<float>(stats.bytesFetched) /
+                                              static_cast<float>(referencedBytes) : 0.0f;
+    return stats;
+}
+
+// ============
+// Vertex cache
+// ============
+
+static float forsythVertexScore(int cachePosition, uint32_t activeTriangles)
+{
+    if (activeTriangles == 0u)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            // The last triangle's vertices score the same regardless of order, so it is not simply repeated.
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            auto scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3u);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Vertices with few triangles left get a boost so that they are finished off rather than left stranded.
+    return score + FORSYTH_VALENCE_BOOST_SCALE *
+                   std::pow(static_cast<float>(activeTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+vector<uint32_t> VkTri::optimizeVertexCache(const vector<uint32_t> &indices, size_t vertexCount)
+{
+    auto triangleCount = indices.size() / 3u;
+
+    // Triangles using each vertex, with the active ones kept at the front of every range.
+    vector<uint32_t> activeCounts(vertexCount, 0u);
+    for (auto index : indices)
+    {
+        activeCounts[index]++;
+    }
+
+    vector<uint32_t> offsets(vertexCount + 1u, 0u);
+    std::partial_sum(activeCounts.begin(), activeCounts.end(), offsets.begin() + 1);
+
+    vector<uint32_t> vertexTriangles(indices.size());
+    {
+        vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            vertexTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3u);
+        }
+    }
+
+    vector<int> cachePositions(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        vertexScores[v] = forsythVertexScore(-1, activeCounts[v]);
+    }
+
+    vector<float> triangleScores(triangleCount);
+    vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3u]] + vertexScores[indices[t * 3u + 1u]] +
+                            vertexScores[indices[t * 3u + 2u]];
+    }
+
+    vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    vector<uint32_t> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3u);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3u);
+
+    size_t scanCursor = 0u;
+    auto best = triangleCount != 0u ? 0u : std::numeric_limits<size_t>::max();
+
+    while (result.size() < indices.size())
+    {
+        if (best == std::numeric_limits<size_t>::max())
+        {
+            // Nothing in the cache has triangles left, so continue with the next triangle in the input order.
+            while (emitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            best = scanCursor;
+        }
+
+        const uint32_t *triangle = &indices[best * 3u];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        // Retire the triangle from its vertices' active ranges.
+        for (size_t corner = 0; corner < 3u; corner++)
+        {
+            auto v = triangle[corner];
+            auto begin = vertexTriangles.begin() + offsets[v];
+            auto end = begin + activeCounts[v];
+            std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best)), end - 1);
+            activeCounts[v]--;
+        }
+
+        // The triangle's vertices move to the front of the cache, which may push others out past its end.
+        nextCache.assign(triangle, triangle + 3);
+        for (auto v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                nextCache.push_back(v);
+            }
+        }
+        std::swap(cache, nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            auto v = cache[i];
+            cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScores[v] = forsythVertexScore(cachePositions[v], activeCounts[v]);
+        }
+
+        // Only triangles touching the cache changed score, so the next one is picked among them.
+        best = std::numeric_limits<size_t>::max();
+        float bestScore = -1.0f;
+        for (auto v : cache)
+        {
+            for (uint32_t i = offsets[v]; i < offsets[v] + activeCounts[v]; i++)
+            {
+                auto t = vertexTriangles[i];
+                triangleScores[t] = vertexScores[indices[t * 3u]] + vertexScores[indices[t * 3u + 1u]] +
+                                    vertexScores[indices[t * 3u + 2u]];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (cache.size() > FORSYTH_CACHE_SIZE)
+        {
+            cache.resize(FORSYTH_CACHE_SIZE);
+        }
+    }
+
+    return result;
+}
+
+// ========
+// Overdraw
+// ========
+
+/**
+ * \brief Splits the triangle order where the cache starts over anyway, and then wherever restarting it costs at
+ * most threshold times the ACMR of the enclosing cluster.
+ *
+ * \return the first triangle of every cluster, followed by the triangle count.
+ */
+static vector<uint32_t> findClusters(const vector<uint32_t> &indices, size_t vertexCount, float threshold)
+{
+    auto triangleCount = static_cast<uint32_t>(indices.size() / 3u);
+    FifoCache cache(vertexCount, ANALYSIS_CACHE_SIZE);
+
+    // A triangle missing all three vertices does not profit from what came before it.
+    vector<uint32_t> hardBoundaries;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        uint32_t misses = 0u;
+        for (size_t corner = 0; corner < 3u; corner++)
+        {
+            misses += cache.access(indices[t * 3u + corner]) ? 1u : 0u;
+        }
+        if (misses == 3u)
+        {
+            hardBoundaries.push_back(t);
+        }
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    vector<uint32_t> boundaries;
+    for (size_t c = 0; c + 1u < hardBoundaries.size(); c++)
+    {
+        auto start = hardBoundaries[c];
+        auto end = hardBoundaries[c + 1u];
+
+        cache.clear();
+        uint32_t clusterMisses = 0u;
+        for (auto i = start * 3u; i < end * 3u; i++)
+        {
+            clusterMisses += cache.access(indices[i]) ? 1u : 0u;
+        }
+        auto clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+        boundaries.push_back(start);
+        cache.clear();
+        uint32_t misses = 0u, triangles = 0u;
+        for (auto t = start; t < end; t++)
+        {
+            for (size_t corner = 0; corner < 3u; corner++)
+            {
+                misses += cache.access(indices[t * 3u + corner]) ? 1u : 0u;
+            }
+            triangles++;
+
+            if (t + 1u < end && static_cast<float>(misses) / static_cast<float>(triangles) <= clusterAcmr * threshold)
+            {
+                boundaries.push_back(t + 1u);
+                cache.clear();
+                misses = triangles = 0u;
+            }
+        }
+    }
+    boundaries.push_back(triangleCount);
+
+    return boundaries;
+}
+
+vector<uint32_t> VkTri::optimizeOverdraw(const vector<uint32_t> &indices, const vector<MeshVertex> &vertices,
+                                         float threshold)
+{
+    auto boundaries = findClusters(indices, vertices.size(), threshold);
+    auto clusterCount = boundaries.size() - 1u;
+
+    // Area weighted centroids and normals of every cluster and of the whole mesh.
+    vector<Vec3> centroids(clusterCount, Vec3{}), normals(clusterCount, Vec3{});
+    vector<float> areas(clusterCount, 0.0f);
+    Vec3 meshCentroid{};
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (auto t = boundaries[c]; t < boundaries[c + 1u]; t++)
+        {
+            const auto &p0 = vertices[indices[t * 3u]].position;
+            const auto &p1 = vertices[indices[t * 3u + 1u]].position;
+            const auto &p2 = vertices[indices[t * 3u + 2u]].position;
+
+            auto normal = cross(sub(p1, p0), sub(p2, p0));
+            auto area = std::sqrt(dot(normal, normal));
+
+            for (size_t axis = 0; axis < 3u; axis++)
+            {
+                centroids[c][axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+                normals[c][axis] += normal[axis];
+            }
+            areas[c] += area;
+        }
+
+        for (size_t axis = 0; axis < 3u; axis++)
+        {
+            meshCentroid[axis] += centroids[c][axis];
+            centroids[c][axis] /= areas[c] > 0.0f ? areas[c] : 1.0f;
+        }
+        meshArea += areas[c];
+    }
+
+    for (auto &value : meshCentroid)
+    {
+        value /= meshArea > 0.0f ? meshArea : 1.0f;
+    }
+
+    vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        auto length = std::sqrt(dot(normals[c], normals[c]));
+        auto offset = Vec3{centroids[c][0] - meshCentroid[0], centroids[c][1] - meshCentroid[1],
+                           centroids[c][2] - meshCentroid[2]};
+        sortKeys[c] = length > 0.0f ? dot(offset, normals[c]) / length : 0.0f;
+    }
+
+    // Clusters facing away from the centre sit on the outside of the mesh and are drawn first.
+    vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto c : order)
+    {
+        result.insert(result.end(), indices.begin() + boundaries[c] * 3u, indices.begin() + boundaries[c + 1u] * 3u);
+    }
+    return result;
+}
+
+// ============
+// Vertex fetch
+// ============
+
+vector<uint32_t> VkTri::optimizeVertexFetch(vector<MeshVertex> &vertices, vector<uint32_t> &indices)
+{
+    vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+    vector<MeshVertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (auto &index : indices)
+    {
+        if (remap[index] == std::numeric_limits<uint32_t>::max())
+        {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(reordered);
+    return remap;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshFormat.hpp"
+
+using std::vector;
+
+namespace VkTri
+{
+    static constexpr uint32_t ANALYSIS_CACHE_SIZE = 16u; /**< Post-transform FIFO entries assumed by the report */
+    static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f; /**< ACMR increase allowed to reduce overdraw */
+
+    /**
+     * \brief Post-transform cache efficiency of an index order.
+     */
+    struct VertexCacheStats
+    {
+        uint32_t transformed = 0u; /**< Vertex shader invocations */
+        float acmr = 0.0f; /**< Average cache miss ratio: invocations per triangle, 0.5 at best and 3 at worst */
+        float atvr = 0.0f; /**< Average transformed vertex ratio: invocations per referenced vertex, 1 at best */
+    };
+
+    /**
+     * \brief Vertex memory traffic of an index order.
+     */
+    struct VertexFetchStats
+    {
+        uint32_t bytesFetched = 0u;
+        float overfetch = 0.0f; /**< Bytes fetched per byte of referenced vertex data, 1 at best */
+    };
+
+    /**
+     * \brief Simulates a FIFO post-transform cache of cacheSize entries over the triangle list.
+     */
+    [[nodiscard]] VertexCacheStats analyzeVertexCache(const vector<uint32_t> &indices, size_t vertexCount,
+                                                      uint32_t cacheSize = ANALYSIS_CACHE_SIZE);
+
+    /**
+     * \brief Simulates fetching the vertices that miss the post-transform cache through 64 byte cache lines.
+     */
+    [[nodiscard]] VertexFetchStats analyzeVertexFetch(const vector<uint32_t> &indices, size_t vertexCount,
+                                                      size_t vertexSize, uint32_t cacheSize = ANALYSIS_CACHE_SIZE);
+
+    /**
+     * \brief Reorders triangles so that their vertices are likely still in the post-transform cache.
+     *
+     * \details
+     * Implements Tom Forsyth's linear-speed vertex cache optimisation. It does not assume a cache size or
+     * replacement policy, so the order works well on hardware with any small FIFO or LRU cache.
+     */
+    [[nodiscard]] vector<uint32_t> optimizeVertexCache(const vector<uint32_t> &indices, size_t vertexCount);
+
+    /**
+     * \brief Reorders clusters of triangles so that the ones more likely to occlude others are drawn first.
+     *
+     * \details
+     * Expects indices already ordered by optimizeVertexCache(). The order is split into clusters wherever that
+     * costs at most threshold times the ACMR, and the clusters are sorted by how far they face outwards from the
+     * centre of the mesh. The order of triangles within a cluster is kept.
+     */
+    [[nodiscard]] vector<uint32_t> optimizeOverdraw(const vector<uint32_t> &indices,
+                                                    const vector<MeshVertex> &vertices,
+                                                    float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+    /**
+     * \brief Reorders vertices by first use and rewrites the indices to match. Unreferenced vertices are dropped.
+     *
+     * \return the new index of every original vertex, or UINT32_MAX for dropped ones.
+     */
+    vector<uint32_t> optimizeVertexFetch(vector<MeshVertex> &vertices, vector<uint32_t> &indices);
+}
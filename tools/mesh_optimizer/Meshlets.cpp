@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "Meshlets.hpp"
+
+using namespace VkTri;
+
+using Vec3 = std::array<float, 3>;
+
+static constexpr float CONE_MIN_SPREAD = 0.1f; /**< Cones wider than this cosine away from the axis never cull */
+
+static float distance(const float *a, const float *b)
+{
+    auto dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * \brief Ritter's bounding sphere: a quick approximation at most a few percent larger than the minimal one.
+ */
+static void computeSphere(const MeshletData &data, const vector<MeshVertex> &vertices, Meshlet &meshlet)
+{
+    auto position = [&](uint32_t i) { return vertices[data.vertices[meshlet.vertexOffset + i]].position; };
+
+    auto farthestFrom = [&](const float *point)
+    {
+        uint32_t farthest = 0u;
+        for (uint32_t i = 1; i < meshlet.vertexCount; i++)
+        {
+            if (distance(position(i), point) > distance(position(farthest), point))
+            {
+                farthest = i;
+            }
+        }
+        return farthest;
+    };
+
+    const auto *a = position(farthestFrom(position(0u)));
+    const auto *b = position(farthestFrom(a));
+
+    float radius = distance(a, b) * 0.5f;
+    Vec3 center = {(a[0] + b[0]) * 0.5f, (a[1] + b[1]) * 0.5f, (a[2] + b[2]) * 0.5f};
+
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        const auto *p = position(i);
+        auto d = distance(p, center.data());
+        if (d > radius)
+        {
+            // Grow just enough to touch the outlying point, keeping the opposite side in place.
+            auto grownRadius = (radius + d) * 0.5f;
+            auto shift = (grownRadius - radius) / d;
+            for (size_t axis = 0; axis < 3u; axis++)
+            {
+                center[axis] += (p[axis] - center[axis]) * shift;
+            }
+            radius = grownRadius;
+        }
+    }
+
+    std::copy(center.begin(), center.end(), meshlet.center);
+    meshlet.radius = radius;
+}
+
+/**
+ * \brief Cone containing the normals of all triangles, with its apex placed so that every triangle plane lies
+ * in front of it.
+ */
+static void computeCone(const MeshletData &data, const vector<MeshVertex> &vertices, Meshlet &meshlet)
+{
+    std::copy(meshlet.center, meshlet.center + 3, meshlet.coneApex);
+    meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+    meshlet.coneCutoff = 1.0f;
+    meshlet.padding = 0.0f;
+
+    vector<Vec3> normals;
+    vector<const float *> corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+
+    Vec3 axis{};
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+    {
+        const auto *local = &data.triangles[(meshlet.triangleOffset + t) * 3u];
+        const auto *p0 = vertices[data.vertices[meshlet.vertexOffset + local[0]]].position;
+        const auto *p1 = vertices[data.vertices[meshlet.vertexOffset + local[1]]].position;
+        const auto *p2 = vertices[data.vertices[meshlet.vertexOffset + local[2]]].position;
+
+        Vec3 e1 = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        Vec3 e2 = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        Vec3 n = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+
+        auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0f)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < 3u; i++)
+        {
+            n[i] /= length;
+            axis[i] += n[i];
+        }
+        normals.push_back(n);
+        corners.push_back(p0);
+    }
+
+    auto axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (normals.empty() || axisLength == 0.0f)
+    {
+        return;
+    }
+    for (auto &value : axis)
+    {
+        value /= axisLength;
+    }
+
+    float minDot = 1.0f;
+    for (const auto &n : normals)
+    {
+        minDot = std::min(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+    }
+
+    std::copy(axis.begin(), axis.end(), meshlet.coneAxis);
+    if (minDot <= CONE_MIN_SPREAD)
+    {
+        return;
+    }
+
+    // Move the apex back along the axis until it is behind every triangle plane:
+    // dot(center - t * axis - p0, n) = 0 gives t = dot(center - p0, n) / dot(axis, n).
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); i++)
+    {
+        const auto &n = normals[i];
+        const auto *p0 = corners[i];
+        auto dc = (meshlet.center[0] - p0[0]) * n[0] + (meshlet.center[1] - p0[1]) * n[1] +
+                  (meshlet.center[2] - p0[2]) * n[2];
+        auto dn = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+        maxT = std::max(maxT, dc / dn);
+    }
+
+    for (size_t i = 0; i < 3u; i++)
+    {
+        meshlet.coneApex[i] = meshlet.center[i] - axis[i] * maxT;
+    }
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+MeshletData VkTri::buildMeshlets(const vector<MeshVertex> &vertices, const vector<uint32_t> &indices,
+                                 uint32_t maxVertices, uint32_t maxTriangles)
+{
+    if (maxVertices < 3u || maxVertices > 256u || maxTriangles < 1u)
+    {
+        throw std::invalid_argument(fmt::format("Meshlets of {:d} vertices and {:d} triangles are not supported",
+                                                maxVertices, maxTriangles));
+    }
+
+    MeshletData data;
+    vector<int> localIndices(vertices.size(), -1);
+
+    Meshlet current{};
+    auto finish = [&]()
+    {
+        for (uint32_t i = 0; i < current.vertexCount; i++)
+        {
+            localIndices[data.vertices[current.vertexOffset + i]] = -1;
+        }
+        data.meshlets.push_back(current);
+
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        current.triangleOffset = static_cast<uint32_t>(data.triangles.size() / 3u);
+    };
+
+    for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+    {
+        const auto *triangle = &indices[i];
+
+        uint32_t newVertices = 0u;
+        for (size_t corner = 0; corner < 3u; corner++)
+        {
+            // Counts a vertex repeated within a degenerate triangle twice, which only errs on the safe side.
+            newVertices += localIndices[triangle[corner]] < 0 ? 1u : 0u;
+        }
+
+        if (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1u > maxTriangles)
+        {
+            finish();
+        }
+
+        for (size_t corner = 0; corner < 3u; corner++)
+        {
+            auto &local = localIndices[triangle[corner]];
+            if (local < 0)
+            {
+                local = static_cast<int>(current.vertexCount++);
+                data.vertices.push_back(triangle[corner]);
+            }
+            data.triangles.push_back(static_cast<uint8_t>(local));
+        }
+        current.triangleCount++;
+    }
+
+    if (current.triangleCount != 0u)
+    {
+        finish();
+    }
+
+    for (auto &meshlet : data.meshlets)
+    {
+        computeSphere(data, vertices, meshlet);
+        computeCone(data, vertices, meshlet);
+    }
+
+    return data;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshFormat.hpp"
+
+using std::vector;
+
+namespace VkTri
+{
+    /**
+     * \brief Meshlets of a mesh together with the arrays they index, laid out as in a .vkmesh file.
+     */
+    struct MeshletData
+    {
+        vector<Meshlet> meshlets;
+        vector<uint32_t> vertices; /**< Mesh vertex indices, vertexCount per meshlet */
+        vector<uint8_t> triangles; /**< Three meshlet-local vertex indices per triangle */
+    };
+
+    /**
+     * \brief Splits the triangle list into meshlets and computes their bounding spheres and normal cones.
+     *
+     * \details
+     * Triangles are added in index order until either limit would be exceeded, so the locality produced by
+     * optimizeVertexCache() carries over into small, tight meshlets.
+     *
+     * \param maxVertices at most 256, so that local indices fit in a byte.
+     * \throws std::invalid_argument if the limits cannot hold a single triangle or do not fit the format.
+     */
+    [[nodiscard]] MeshletData buildMeshlets(const vector<MeshVertex> &vertices, const vector<uint32_t> &indices,
+                                            uint32_t maxVertices = MESHLET_MAX_VERTICES,
+                                            uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+}
@@ -0,0 +1,193 @@
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include <fmt/format.h>
+
+#include "ObjLoader.hpp"
+
+using std::string;
+
+using namespace VkTri;
+
+using ObjCorner = std::tuple<uint32_t, uint32_t, uint32_t>; /**< Position, texture coordinate, normal; 0 if absent */
+
+/**
+ * \brief Resolves a 1-based or negative OBJ index against the number of elements read so far.
+ */
+static uint32_t resolveIndex(long index, size_t count, const fs::path &path, size_t lineNumber)
+{
+    auto resolved = index < 0 ? static_cast<long>(count) + index + 1 : index;
+    if (resolved < 1 || resolved > static_cast<long>(count))
+    {
+        throw std::runtime_error(fmt::format("{:s}:{:d}: index {:d} out of range", path.string(), lineNumber, index));
+    }
+    return static_cast<uint32_t>(resolved);
+}
+
+static void computeNormals(IndexedMesh &mesh)
+{
+    for (auto &vertex : mesh.vertices)
+    {
+        vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+    }
+
+    // Unnormalized face normals weigh each face by its area.
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const auto &a = mesh.vertices[mesh.indices[i]].position;
+        const auto &b = mesh.vertices[mesh.indices[i + 1]].position;
+        const auto &c = mesh.vertices[mesh.indices[i + 2]].position;
+
+        std::array<float, 3> ab = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        std::array<float, 3> ac = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        std::array<float, 3> normal = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2],
+                                       ab[0] * ac[1] - ab[1] * ac[0]};
+
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            auto &target = mesh.vertices[mesh.indices[i + corner]].normal;
+            target[0] += normal[0];
+            target[1] += normal[1];
+            target[2] += normal[2];
+        }
+    }
+
+    for (auto &vertex : mesh.vertices)
+    {
+        auto &n = vertex.normal;
+        auto length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0f)
+        {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+    }
+}
+
+IndexedMesh VkTri::loadObj(const fs::path &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to open {:s}", path.string()));
+    }
+
+    vector<std::array<float, 3>> positions;
+    vector<std::array<float, 2>> texCoords;
+    vector<std::array<float, 3>> normals;
+
+    IndexedMesh mesh;
+    std::map<ObjCorner, uint32_t> cornerVertices;
+    vector<uint32_t> polygon;
+    bool hasNormals = false;
+
+    string line;
+    for (size_t lineNumber = 1u; std::getline(file, line); lineNumber++)
+    {
+        std::istringstream tokens(line);
+        string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        if (keyword == "v" || keyword == "vn")
+        {
+            std::array<float, 3> value{};
+            if (!(tokens >> value[0] >> value[1] >> value[2]))
+            {
+                throw std::runtime_error(fmt::format("{:s}:{:d}: expected 3 numbers", path.string(), lineNumber));
+            }
+            (keyword == "v" ? positions : normals).push_back(value);
+        }
+        else if (keyword == "vt")
+        {
+            std::array<float, 2> value{};
+            if (!(tokens >> value[0] >> value[1]))
+            {
+                throw std::runtime_error(fmt::format("{:s}:{:d}: expected 2 numbers", path.string(), lineNumber));
+            }
+            texCoords.push_back(value);
+        }
+        else if (keyword == "f")
+        {
+            polygon.clear();
+
+            string corner;
+            while (tokens >> corner)
+            {
+                // v, v/vt, v//vn or v/vt/vn
+                std::array<long, 3> parts{0, 0, 0};
+                size_t start = 0u;
+                for (size_t part = 0; part < 3u && start <= corner.size(); part++)
+                {
+                    auto end = corner.find('/', start);
+                    auto text = corner.substr(start, end == string::npos ? string::npos : end - start);
+                    parts[part] = text.empty() ? 0 : std::stol(text);
+                    if (end == string::npos)
+                    {
+                        break;
+                    }
+                    start = end + 1u;
+                }
+
+                ObjCorner key{resolveIndex(parts[0], positions.size(), path, lineNumber),
+                              parts[1] != 0 ? resolveIndex(parts[1], texCoords.size(), path, lineNumber) : 0u,
+                              parts[2] != 0 ? resolveIndex(parts[2], normals.size(), path, lineNumber) : 0u};
+                hasNormals = hasNormals || std::get<2>(key) != 0u;
+
+                auto found = cornerVertices.find(key);
+                if (found == cornerVertices.end())
+                {
+                    MeshVertex vertex{};
+                    const auto &position = positions[std::get<0>(key) - 1u];
+                    std::copy(position.begin(), position.end(), vertex.position);
+                    if (std::get<1>(key) != 0u)
+                    {
+                        const auto &uv = texCoords[std::get<1>(key) - 1u];
+                        std::copy(uv.begin(), uv.end(), vertex.uv);
+                    }
+                    if (std::get<2>(key) != 0u)
+                    {
+                        const auto &normal = normals[std::get<2>(key) - 1u];
+                        std::copy(normal.begin(), normal.end(), vertex.normal);
+                    }
+
+                    found = cornerVertices.emplace(key, static_cast<uint32_t>(mesh.vertices.size())).first;
+                    mesh.vertices.push_back(vertex);
+                }
+                polygon.push_back(found->second);
+            }
+
+            if (polygon.size() < 3u)
+            {
+                throw std::runtime_error(fmt::format("{:s}:{:d}: face with fewer than 3 corners", path.string(),
+                                                     lineNumber));
+            }
+
+            for (size_t i = 1; i + 1 < polygon.size(); i++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i], polygon[i + 1]});
+            }
+        }
+    }
+
+    if (mesh.indices.empty())
+    {
+        throw std::runtime_error(fmt::format("{:s} has no faces", path.string()));
+    }
+
+    if (!hasNormals)
+    {
+        computeNormals(mesh);
+    }
+
+    return mesh;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "MeshFormat.hpp"
+
+using std::vector;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    /**
+     * \brief Triangle list with one vertex per distinct position, normal and texture coordinate combination.
+     */
+    struct IndexedMesh
+    {
+        vector<MeshVertex> vertices;
+        vector<uint32_t> indices;
+    };
+
+    /**
+     * \brief Loads the geometry of a Wavefront OBJ file. Polygons are triangulated as fans.
+     *
+     * \details
+     * Only v, vt, vn and f records are read; groups, objects and materials are ignored, so the whole file ends up
+     * as one mesh. Missing normals are replaced with smooth normals computed from the faces.
+     *
+     * \throws std::runtime_error on malformed records or out of range indices.
+     */
+    [[nodiscard]] IndexedMesh loadObj(const fs::path &path);
+}
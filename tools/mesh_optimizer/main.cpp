@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/format.h>
+
+#include "Meshlets.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjLoader.hpp"
+
+using std::string;
+
+using namespace VkTri;
+
+using Triangle = std::array<uint32_t, 3>;
+
+struct Options
+{
+    fs::path input;
+    fs::path output;
+    bool overdraw = true;
+    float overdrawThreshold = DEFAULT_OVERDRAW_THRESHOLD;
+    uint32_t cacheSize = ANALYSIS_CACHE_SIZE;
+    uint32_t meshletVertices = MESHLET_MAX_VERTICES;
+    uint32_t meshletTriangles = MESHLET_MAX_TRIANGLES;
+};
+
+static Options parseOptions(int argc, char **argv)
+{
+    Options options;
+    options.input = argv[1];
+    options.output = argv[2];
+
+    for (int i = 3; i < argc; i++)
+    {
+        auto value = [&]() -> string
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error(fmt::format("{:s} needs a value", argv[i]));
+            }
+            return argv[++i];
+        };
+
+        if (std::strcmp(argv[i], "--no-overdraw") == 0)
+        {
+            options.overdraw = false;
+        }
+        else if (std::strcmp(argv[i], "--overdraw-threshold") == 0)
+        {
+            options.overdrawThreshold = std::stof(value());
+        }
+        else if (std::strcmp(argv[i], "--cache-size") == 0)
+        {
+            options.cacheSize = static_cast<uint32_t>(std::stoul(value()));
+        }
+        else if (std::strcmp(argv[i], "--meshlet-vertices") == 0)
+        {
+            options.meshletVertices = static_cast<uint32_t>(std::stoul(value()));
+        }
+        else if (std::strcmp(argv[i], "--meshlet-triangles") == 0)
+        {
+            options.meshletTriangles = static_cast<uint32_t>(std::stoul(value()));
+        }
+        else
+        {
+            throw std::runtime_error(fmt::format("Unknown option {:s}", argv[i]));
+        }
+    }
+
+    if (options.cacheSize == 0u)
+    {
+        throw std::runtime_error("--cache-size must be positive");
+    }
+    return options;
+}
+
+/**
+ * \brief Triangles as a sorted list, each rotated to start at its smallest index, so that reorderings that keep
+ * the winding compare equal.
+ */
+static vector<Triangle> canonicalTriangles(const vector<uint32_t> &indices)
+{
+    vector<Triangle> triangles;
+    triangles.reserve(indices.size() / 3u);
+    for (size_t i = 0; i + 2u < indices.size(); i += 3u)
+    {
+        Triangle triangle = {indices[i], indices[i + 1u], indices[i + 2u]};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void printStage(const char *stage, const vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize)
+{
+    auto cache = analyzeVertexCache(indices, vertexCount, cacheSize);
+    auto fetch = analyzeVertexFetch(indices, vertexCount, sizeof(MeshVertex), cacheSize);
+    std::clog << fmt::format("{:<16s}{:>8.3f}{:>8.3f}{:>11.3f}\n", stage, cache.acmr, cache.atvr, fetch.overfetch);
+}
+
+static void writeMesh(const fs::path &path, const vector<MeshVertex> &vertices, const vector<uint32_t> &indices,
+                      const MeshletData &meshlets)
+{
+    MeshFileHeader header;
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.meshlets.size());
+    header.meshletVertexCount = static_cast<uint32_t>(meshlets.vertices.size());
+    header.meshletTriangleCount = static_cast<uint32_t>(meshlets.triangles.size() / 3u);
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to write {:s}", path.string()));
+    }
+
+    auto write = [&output](const auto &data, size_t count)
+    {
+        output.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(count * sizeof(*data)));
+    };
+
+    write(&header, 1u);
+    write(vertices.data(), vertices.size());
+    write(indices.data(), indices.size());
+    write(meshlets.meshlets.data(), meshlets.meshlets.size());
+    write(meshlets.vertices.data(), meshlets.vertices.size());
+    write(meshlets.triangles.data(), meshlets.triangles.size());
+
+    if (!output)
+    {
+        throw std::runtime_error(fmt::format("Failed to write {:s}", path.string()));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: mesh_optimizer <input.obj> <output.vkmesh> [--no-overdraw] [--overdraw-threshold <x>]\n"
+                     "                      [--cache-size <n>] [--meshlet-vertices <n>] [--meshlet-triangles <n>]\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto options = parseOptions(argc, argv);
+        auto mesh = loadObj(options.input);
+        auto expected = canonicalTriangles(mesh.indices);
+
+        std::clog << fmt::format("{:s}: {:d} vertices, {:d} triangles\n", options.input.string(),
+                                 mesh.vertices.size(), mesh.indices.size() / 3u);
+        std::clog << fmt::format("{:<16s}{:>8s}{:>8s}{:>11s}\t(FIFO of {:d})\n", "stage", "ACMR", "ATVR",
+                                 "overfetch", options.cacheSize);
+        printStage("input", mesh.indices, mesh.vertices.size(), options.cacheSize);
+
+        auto indices = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        printStage("vertex cache", indices, mesh.vertices.size(), options.cacheSize);
+
+        if (options.overdraw)
+        {
+            indices = optimizeOverdraw(indices, mesh.vertices, options.overdrawThreshold);
+            printStage("overdraw", indices, mesh.vertices.size(), options.cacheSize);
+        }
+
+        if (canonicalTriangles(indices) != expected)
+        {
+            throw std::runtime_error("Reordering lost or changed triangles");
+        }
+
+        auto vertices = mesh.vertices;
+        auto remap = optimizeVertexFetch(vertices, indices);
+        printStage("vertex fetch", indices, vertices.size(), options.cacheSize);
+
+        for (auto &triangle : expected)
+        {
+            for (auto &index : triangle)
+            {
+                index = remap[index];
+            }
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        }
+        std::sort(expected.begin(), expected.end());
+        if (canonicalTriangles(indices) != expected)
+        {
+            throw std::runtime_error("Vertex remapping lost or changed triangles");
+        }
+
+        auto meshlets = buildMeshlets(vertices, indices, options.meshletVertices, options.meshletTriangles);
+
+        size_t culling = 0u;
+        float meshletVertices = 0.0f, meshletTriangles = 0.0f;
+        for (const auto &meshlet : meshlets.meshlets)
+        {
+            culling += meshlet.coneCutoff < 1.0f ? 1u : 0u;
+            meshletVertices += static_cast<float>(meshlet.vertexCount);
+            meshletTriangles += static_cast<float>(meshlet.triangleCount);
+        }
+        auto meshletCount = static_cast<float>(std::max<size_t>(meshlets.meshlets.size(), 1u));
+
+        std::clog << fmt::format("{:d} meshlets of up to {:d} vertices and {:d} triangles, {:.1f} vertices and "
+                                 "{:.1f} triangles on average, {:d} with a usable normal cone\n",
+                                 meshlets.meshlets.size(), options.meshletVertices, options.meshletTriangles,
+                                 meshletVertices / meshletCount, meshletTriangles / meshletCount, culling);
+
+        writeMesh(options.output, vertices, indices, meshlets);
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << fmt::format("mesh_optimizer: {:s}: {:s}\n", argv[1], err.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,508 @@
+#include <array>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+#include <fmt/format.h>
+#include "SpirvReflector.hpp"
+
+using namespace VkTri;
+
+// Subset of the SPIR-V specification used by the reflector.
+namespace Spv
+{
+    static constexpr uint32_t MAGIC = 0x07230203u;
+    static constexpr uint32_t HEADER_WORDS = 5u;
+
+    enum Op : uint32_t
+    {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpTypeVoid = 19,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72
+    };
+
+    enum Decoration : uint32_t
+    {
+        BufferBlock = 3,
+        ArrayStride = 6,
+        MatrixStride = 7,
+        BuiltIn = 11,
+        Location = 30,
+        Binding = 33,
+        DescriptorSet = 34,
+        Offset = 35
+    };
+
+    enum StorageClass : uint32_t
+    {
+        UniformConstant = 0,
+        Input = 1,
+        Uniform = 2,
+        PushConstant = 9,
+        StorageBuffer = 12
+    };
+
+    enum Dim : uint32_t
+    {
+        DimBuffer = 5,
+        DimSubpassData = 6
+    };
+}
+
+/**
+ * \brief Decodes a nul-terminated literal string packed into words.
+ */
+static string literalString(const vector<uint32_t> &operands, size_t first)
+{
+    string result;
+    for (size_t i = first; i < operands.size(); i++)
+    {
+        for (uint32_t byte = 0u; byte < 4u; byte++)
+        {
+            auto c = static_cast<char>((operands[i] >> (byte * 8u)) & 0xFFu);
+            if (c == '\0')
+            {
+                return result;
+            }
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+SpirvReflector::SpirvReflector(vector<uint32_t> words)
+{
+    this->parse(std::move(words));
+}
+
+SpirvReflector SpirvReflector::load(const fs::path &path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to open {:s}", path.string()));
+    }
+
+    auto size = static_cast<size_t>(file.tellg());
+    if (size % sizeof(uint32_t) != 0u)
+    {
+        throw std::runtime_error(fmt::format("{:s} is not a SPIR-V binary", path.string()));
+    }
+
+    vector<uint32_t> words(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(words.data()), static_cast<std::streamsize>(size));
+
+    return SpirvReflector(std::move(words));
+}
+
+void SpirvReflector::parse(vector<uint32_t> words)
+{
+    if (words.size() < Spv::HEADER_WORDS)
+    {
+        throw std::runtime_error("SPIR-V module is truncated");
+    }
+
+    // Modules written on a machine of the other endianness have their words swapped.
+    if (words[0] != Spv::MAGIC)
+    {
+        for (auto &word : words)
+        {
+            word = ((word & 0xFFu) << 24u) | ((word & 0xFF00u) << 8u) | ((word >> 8u) & 0xFF00u) | (word >> 24u);
+        }
+        if (words[0] != Spv::MAGIC)
+        {
+            throw std::runtime_error("Missing SPIR-V magic number");
+        }
+    }
+
+    size_t position = Spv::HEADER_WORDS;
+    while (position < words.size())
+    {
+        auto wordCount = words[position] >> 16u;
+        auto opcode = words[position] & 0xFFFFu;
+        if (wordCount == 0u || position + wordCount > words.size())
+        {
+            throw std::runtime_error(fmt::format("Malformed SPIR-V instruction at word {:d}", position));
+        }
+
+        Instruction instruction{opcode, vector<uint32_t>(words.begin() + static_cast<long>(position) + 1,
+                                                         words.begin() + static_cast<long>(position + wordCount))};
+        const auto &ops = instruction.operands;
+        position += wordCount;
+
+        switch (opcode)
+        {
+            case Spv::OpName:
+                this->names[ops.at(0)] = literalString(ops, 1);
+                break;
+            case Spv::OpEntryPoint:
+                if (this->executionModel.has_value())
+                {
+                    throw std::runtime_error("Modules with several entry points are not supported");
+                }
+                this->executionModel = ops.at(0);
+                break;
+            case Spv::OpDecorate:
+                this->decorations[ops.at(0)][ops.at(1)] = ops.size() > 2 ? ops[2] : 0u;
+                break;
+            case Spv::OpMemberDecorate:
+                this->memberDecorations[{ops.at(0), ops.at(1)}][ops.at(2)] = ops.size() > 3 ? ops[3] : 0u;
+                break;
+            case Spv::OpConstant:
+                this->constants[ops.at(1)] = ops.at(2);
+                break;
+            case Spv::OpVariable:
+                this->variables.push_back(std::move(instruction));
+                break;
+            default:
+                if (opcode >= Spv::OpTypeVoid && opcode <= Spv::OpTypePointer)
+                {
+                    auto id = ops.at(0);
+                    this->types[id] = std::move(instruction);
+                }
+                break;
+        }
+    }
+
+    if (!this->executionModel.has_value())
+    {
+        throw std::runtime_error("SPIR-V module has no entry point");
+    }
+}
+
+const SpirvReflector::Instruction &SpirvReflector::type(uint32_t id) const
+{
+    auto found = this->types.find(id);
+    if (found == this->types.end())
+    {
+        throw std::runtime_error(fmt::format("Unknown SPIR-V type %{:d}", id));
+    }
+    return found->second;
+}
+
+std::optional<uint32_t> SpirvReflector::decoration(uint32_t id, uint32_t decoration) const
+{
+    auto found = this->decorations.find(id);
+    if (found == this->decorations.end())
+    {
+        return std::nullopt;
+    }
+
+    auto value = found->second.find(decoration);
+    if (value == found->second.end())
+    {
+        return std::nullopt;
+    }
+    return value->second;
+}
+
+std::optional<uint32_t> SpirvReflector::memberDecoration(uint32_t id, uint32_t member, uint32_t decoration) const
+{
+    auto found = this->memberDecorations.find({id, member});
+    if (found == this->memberDecorations.end())
+    {
+        return std::nullopt;
+    }
+
+    auto value = found->second.find(decoration);
+    if (value == found->second.end())
+    {
+        return std::nullopt;
+    }
+    return value->second;
+}
+
+string SpirvReflector::nameOf(uint32_t id) const
+{
+    auto found = this->names.find(id);
+    return found != this->names.end() ? found->second : string();
+}
+
+uint32_t SpirvReflector::typeSize(uint32_t id, std::optional<uint32_t> matrixStride) const
+{
+    const auto &instruction = this->type(id);
+    const auto &ops = instruction.operands;
+
+    switch (instruction.opcode)
+    {
+        case Spv::OpTypeBool:
+            return 4u;
+        case Spv::OpTypeInt:
+        case Spv::OpTypeFloat:
+            return ops.at(1) / 8u;
+        case Spv::OpTypeVector:
+            return ops.at(2) * this->typeSize(ops.at(1));
+        case Spv::OpTypeMatrix:
+            return ops.at(2) * matrixStride.value_or(this->typeSize(ops.at(1)));
+        case Spv::OpTypeArray:
+        {
+            auto length = this->constants.at(ops.at(2));
+            auto stride = this->decoration(ops.at(0), Spv::ArrayStride);
+            return length * stride.value_or(this->typeSize(ops.at(1), matrixStride));
+        }
+        case Spv::OpTypeRuntimeArray:
+            // Sized by the bound range rather than the block.
+            return 0u;
+        case Spv::OpTypeStruct:
+        {
+            uint32_t size = 0u;
+            for (uint32_t member = 0u; member + 1u < ops.size(); member++)
+            {
+                auto offset = this->memberDecoration(ops[0], member, Spv::Offset).value_or(0u);
+                auto stride = this->memberDecoration(ops[0], member, Spv::MatrixStride);
+                size = std::max(size, offset + this->typeSize(ops[member + 1u], stride));
+            }
+            return size;
+        }
+        default:
+            throw std::runtime_error(fmt::format("Type %{:d} has no size in a buffer block", id));
+    }
+}
+
+string SpirvReflector::descriptorType(uint32_t typeId, uint32_t storageClass) const
+{
+    const auto &instruction = this->type(typeId);
+
+    if (storageClass == Spv::StorageBuffer)
+    {
+        return "eStorageBuffer";
+    }
+
+    if (storageClass == Spv::Uniform)
+    {
+        // Before SPIR-V 1.3, storage buffers were uniform blocks decorated with BufferBlock.
+        return this->decoration(typeId, Spv::BufferBlock).has_value() ? "eStorageBuffer" : "eUniformBuffer";
+    }
+
+    switch (instruction.opcode)
+    {
+        case Spv::OpTypeSampler:
+            return "eSampler";
+        case Spv::OpTypeSampledImage:
+            return "eCombinedImageSampler";
+        case Spv::OpTypeImage:
+        {
+            auto dim = instruction.operands.at(2);
+            auto sampled = instruction.operands.at(6);
+            if (dim == Spv::DimBuffer)
+            {
+                return sampled == 2u ? "eStorageTexelBuffer" : "eUniformTexelBuffer";
+            }
+            if (dim == Spv::DimSubpassData)
+            {
+                return "eInputAttachment";
+            }
+            return sampled == 2u ? "eStorageImage" : "eSampledImage";
+        }
+        default:
+            throw std::runtime_error(fmt::format("Unsupported descriptor type for %{:d}", typeId));
+    }
+}
+
+std::pair<string, uint32_t> SpirvReflector::vertexFormat(uint32_t typeId) const
+{
+    const auto &instruction = this->type(typeId);
+
+    uint32_t components = 1u;
+    auto scalarId = typeId;
+    if (instruction.opcode == Spv::OpTypeVector)
+    {
+        components = instruction.operands.at(2);
+        scalarId = instruction.operands.at(1);
+    }
+
+    const auto &scalar = this->type(scalarId);
+    if ((scalar.opcode != Spv::OpTypeFloat && scalar.opcode != Spv::OpTypeInt) || scalar.operands.at(1) != 32u)
+    {
+        throw std::runtime_error(fmt::format("Unsupported vertex input type %{:d}", typeId));
+    }
+
+    static const std::array<const char *, 4> channels = {"R32", "R32G32", "R32G32B32", "R32G32B32A32"};
+    string numeric = scalar.opcode == Spv::OpTypeFloat ? "Sfloat" : (scalar.operands.at(2) != 0u ? "Sint" : "Uint");
+
+    return {fmt::format("e{:s}{:s}", channels.at(components - 1u), numeric), components * 4u};
+}
+
+ReflectedInterface SpirvReflector::reflect() const
+{
+    static const std::map<uint32_t, const char *> stages = {
+            {0u, "eVertex"},
+            {1u, "eTessellationControl"},
+            {2u, "eTessellationEvaluation"},
+            {3u, "eGeometry"},
+            {4u, "eFragment"},
+            {5u, "eCompute"}
+    };
+
+    ReflectedInterface interface;
+
+    auto stage = stages.find(this->executionModel.value());
+    if (stage == stages.end())
+    {
+        throw std::runtime_error(fmt::format("Unsupported execution model {:d}", this->executionModel.value()));
+    }
+    interface.stage = stage->second;
+
+    for (const auto &variable : this->variables)
+    {
+        auto id = variable.operands.at(1);
+        auto storageClass = variable.operands.at(2);
+
+        const auto &pointer = this->type(variable.operands.at(0));
+        auto pointeeId = pointer.operands.at(2);
+
+        switch (storageClass)
+        {
+            case Spv::UniformConstant:
+            case Spv::Uniform:
+            case Spv::StorageBuffer:
+            {
+                ReflectedBinding binding;
+                binding.set = this->decoration(id, Spv::DescriptorSet).value_or(0u);
+                binding.binding = this->decoration(id, Spv::Binding).value_or(0u);
+
+                const auto *pointee = &this->type(pointeeId);
+                if (pointee->opcode == Spv::OpTypeRuntimeArray)
+                {
+                    throw std::runtime_error(fmt::format("Runtime sized descriptor array {:s} is not supported",
+                                                         this->nameOf(id)));
+                }
+                if (pointee->opcode == Spv::OpTypeArray)
+                {
+                    binding.count = this->constants.at(pointee->operands.at(2));
+                    pointeeId = pointee->operands.at(1);
+                }
+
+                binding.descriptorType = this->descriptorType(pointeeId, storageClass);
+                if (storageClass != Spv::UniformConstant)
+                {
+                    binding.blockSize = this->typeSize(pointeeId);
+                }
+
+                binding.name = this->nameOf(id).empty() ? this->nameOf(pointeeId) : this->nameOf(id);
+                interface.bindings.push_back(binding);
+                break;
+            }
+            case Spv::PushConstant:
+            {
+                const auto &block = this->type(pointeeId);
+                auto begin = UINT32_MAX;
+                for (uint32_t member = 0u; member + 1u < block.operands.size(); member++)
+                {
+                    begin = std::min(begin, this->memberDecoration(pointeeId, member, Spv::Offset).value_or(0u));
+                }
+
+                interface.pushConstantOffset = begin == UINT32_MAX ? 0u : begin;
+                interface.pushConstantSize = this->typeSize(pointeeId) - interface.pushConstantOffset;
+                break;
+            }
+            case Spv::Input:
+            {
+                // Built-ins such as gl_VertexIndex are not fed from vertex buffers.
+                if (interface.stage != "eVertex" || this->decoration(id, Spv::BuiltIn).has_value())
+                {
+                    break;
+                }
+
+                auto location = this->decoration(id, Spv::Location);
+                if (!location.has_value())
+                {
+                    throw std::runtime_error(fmt::format("Vertex input {:s} has no location", this->nameOf(id)));
+                }
+
+                ReflectedAttribute attribute;
+                attribute.location = location.value();
+                std::tie(attribute.format, attribute.size) = this->vertexFormat(pointeeId);
+                attribute.name = this->nameOf(id);
+                interface.attributes.push_back(attribute);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::sort(interface.bindings.begin(), interface.bindings.end(),
+              [](const ReflectedBinding &a, const ReflectedBinding &b)
+              {
+                  return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+              });
+
+    std::sort(interface.attributes.begin(), interface.attributes.end(),
+              [](const ReflectedAttribute &a, const ReflectedAttribute &b)
+              {
+                  return a.location < b.location;
+              });
+
+    for (auto &attribute : interface.attributes)
+    {
+        attribute.offset = interface.vertexStride;
+        interface.vertexStride += attribute.size;
+    }
+
+    return interface;
+}
+
+string SpirvReflector::generateHeader(const ReflectedInterface &interface, const string &name, const string &source)
+{
+    string header = fmt::format("// Generated by shader_reflect from {:s}. Do not edit.\n\n"
+                                "#pragma once\n\n"
+                                "#include \"ShaderReflection.hpp\"\n\n"
+                                "namespace VkTri::Reflection::{:s}\n"
+                                "{{\n", source, name);
+
+    header += fmt::format("    inline constexpr vk::ShaderStageFlagBits STAGE = vk::ShaderStageFlagBits::{:s};\n\n",
+                          interface.stage);
+
+    header += fmt::format("    inline constexpr std::array<DescriptorBindingInfo, {:d}> DESCRIPTOR_BINDINGS = {{{{\n",
+                          interface.bindings.size());
+    for (const auto &binding : interface.bindings)
+    {
+        header += fmt::format("            DescriptorBindingInfo{{{:d}u, {:d}u, vk::DescriptorType::{:s}, {:d}u, "
+                              "{:d}u, \"{:s}\"}},\n", binding.set, binding.binding, binding.descriptorType,
+                              binding.count, binding.blockSize, binding.name);
+    }
+    header += "    }};\n\n";
+
+    header += fmt::format("    inline constexpr PushConstantInfo PUSH_CONSTANTS = {{{:d}u, {:d}u}};\n\n",
+                          interface.pushConstantOffset, interface.pushConstantSize);
+
+    header += fmt::format("    inline constexpr std::array<VertexAttributeInfo, {:d}> VERTEX_ATTRIBUTES = {{{{\n",
+                          interface.attributes.size());
+    for (const auto &attribute : interface.attributes)
+    {
+        header += fmt::format("            VertexAttributeInfo{{{:d}u, vk::Format::{:s}, {:d}u, \"{:s}\"}},\n",
+                              attribute.location, attribute.format, attribute.offset, attribute.name);
+    }
+    header += "    }};\n\n";
+
+    header += fmt::format("    inline constexpr uint32_t VERTEX_STRIDE = {:d}u;\n\n", interface.vertexStride);
+
+    header += "    inline constexpr ShaderInterface INTERFACE = {\n"
+              "            STAGE,\n"
+              "            DESCRIPTOR_BINDINGS.data(), DESCRIPTOR_BINDINGS.size(),\n"
+              "            PUSH_CONSTANTS,\n"
+              "            VERTEX_ATTRIBUTES.data(), VERTEX_ATTRIBUTES.size(),\n"
+              "            VERTEX_STRIDE\n"
+              "    };\n"
+              "}\n";
+
+    return header;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+namespace VkTri
+{
+    /**
+     * \brief Descriptor binding used by a shader.
+     */
+    struct ReflectedBinding
+    {
+        uint32_t set = 0u;
+        uint32_t binding = 0u;
+        string descriptorType; /**< vk::DescriptorType enumerator, e.g. "eUniformBuffer" */
+        uint32_t count = 1u; /**< Array size of the binding */
+        uint32_t blockSize = 0u; /**< Bytes spanned by a buffer block, 0 for images and samplers */
+        string name;
+    };
+
+    /**
+     * \brief Vertex shader input, laid out tightly in location order within a single vertex binding.
+     */
+    struct ReflectedAttribute
+    {
+        uint32_t location = 0u;
+        string format; /**< vk::Format enumerator, e.g. "eR32G32Sfloat" */
+        uint32_t offset = 0u;
+        uint32_t size = 0u;
+        string name;
+    };
+
+    /**
+     * \brief Everything a pipeline layout and vertex input state need to know about one shader stage.
+     */
+    struct ReflectedInterface
+    {
+        string stage; /**< vk::ShaderStageFlagBits enumerator, e.g. "eVertex" */
+        vector<ReflectedBinding> bindings;
+        uint32_t pushConstantOffset = 0u;
+        uint32_t pushConstantSize = 0u; /**< 0 when the shader has no push constant block */
+        vector<ReflectedAttribute> attributes;
+        uint32_t vertexStride = 0u;
+    };
+
+    /**
+     * \brief Minimal SPIR-V parser that extracts the resource interface of a shader module.
+     *
+     * \details
+     * Only the debug names, decorations, types, constants and global variables are looked at. Names are optional
+     * and only make the generated headers easier to read, so stripped modules work as well.
+     */
+    class SpirvReflector
+    {
+    private:
+        struct Instruction
+        {
+            uint32_t opcode;
+            vector<uint32_t> operands;
+        };
+
+        std::map<uint32_t, Instruction> types; /**< Type declarations by result id */
+        std::map<uint32_t, uint32_t> constants; /**< 32-bit scalar constants by result id */
+        std::map<uint32_t, string> names;
+        std::map<uint32_t, std::map<uint32_t, uint32_t>> decorations; /**< id -> decoration -> first literal */
+        std::map<std::pair<uint32_t, uint32_t>, std::map<uint32_t, uint32_t>> memberDecorations;
+        vector<Instruction> variables;
+        std::optional<uint32_t> executionModel;
+
+        void parse(vector<uint32_t> words);
+
+        [[nodiscard]] const Instruction &type(uint32_t id) const;
+
+        [[nodiscard]] std::optional<uint32_t> decoration(uint32_t id, uint32_t decoration) const;
+
+        [[nodiscard]] std::optional<uint32_t> memberDecoration(uint32_t id, uint32_t member,
+                                                               uint32_t decoration) const;
+
+        /**
+         * \brief Bytes spanned by a type inside a buffer block, following its explicit layout decorations.
+         */
+        [[nodiscard]] uint32_t typeSize(uint32_t id, std::optional<uint32_t> matrixStride = std::nullopt) const;
+
+        [[nodiscard]] string descriptorType(uint32_t typeId, uint32_t storageClass) const;
+
+        [[nodiscard]] std::pair<string, uint32_t> vertexFormat(uint32_t typeId) const;
+
+        [[nodiscard]] string nameOf(uint32_t id) const;
+
+    public:
+        explicit SpirvReflector(vector<uint32_t> words);
+
+        /**
+         * \brief Reads and parses a SPIR-V binary.
+         */
+        [[nodiscard]] static SpirvReflector load(const fs::path &path);
+
+        [[nodiscard]] ReflectedInterface reflect() const;
+
+        /**
+         * \brief Writes the interface as a C++ header declaring constexpr descriptions in the given namespace.
+         * \return the header text.
+         */
+        [[nodiscard]] static string generateHeader(const ReflectedInterface &interface, const string &name,
+                                                   const string &source);
+    };
+}
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "SpirvReflector.hpp"
+
+using namespace VkTri;
+
+/**
+ * \brief Writes the file only if its contents change, so dependent sources are not rebuilt needlessly.
+ */
+static void writeIfChanged(const fs::path &path, const string &contents)
+{
+    {
+        std::ifstream existing(path, std::ios::binary);
+        if (existing.is_open())
+        {
+            std::stringstream buffer;
+            buffer << existing.rdbuf();
+            if (buffer.str() == contents)
+            {
+                return;
+            }
+        }
+    }
+
+    if (path.has_parent_path())
+    {
+        fs::create_directories(path.parent_path());
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        throw std::runtime_error(fmt::format("Failed to write {:s}", path.string()));
+    }
+    output << contents;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: shader_reflect <input.spv> <output.hpp> <namespace>\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        fs::path input(argv[1]);
+        auto interface = SpirvReflector::load(input).reflect();
+        writeIfChanged(argv[2], SpirvReflector::generateHeader(interface, argv[3], input.filename().string()));
+    }
+    catch (const std::exception &err)
+    {
+        std::cerr << fmt::format("shader_reflect: {:s}: {:s}\n", argv[1], err.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}